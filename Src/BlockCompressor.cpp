@@ -0,0 +1,471 @@
+/// \file BlockCompressor.cpp
+/// \brief Code for CBlockCompressor.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <fstream>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+#include "BlockCompressor.h"
+#include "DDS.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper functions
+
+#pragma region Helper functions
+
+/// BC7 4-bit index interpolation weights, out of 64.
+
+static const int g_nBC7Weight[16] = {
+  0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64
+}; //g_nBC7Weight
+
+/// Load a 4x4 block of 32-bit ARGB pixels into floating point channels in
+/// the order red, green, blue, alpha.
+/// \param p Pointer to the top left pixel of the block.
+/// \param stride Distance between rows in pixels.
+/// \param px [OUT] Channel values.
+
+static void LoadBlock(const UINT* p, UINT stride, float px[16][4]){
+  for(UINT i=0; i<4; i++)
+    for(UINT j=0; j<4; j++){
+      const UINT c = p[i*stride + j];
+      float* q = px[4*i + j];
+
+      q[0] = float((c >> 16) & 0xFF);
+      q[1] = float((c >>  8) & 0xFF);
+      q[2] = float( c        & 0xFF);
+      q[3] = float( c >> 24);
+    } //for
+} //LoadBlock
+
+/// Find the endpoints of a line segment through a block's pixels in color
+/// space. The line passes through the mean in the direction of the principal
+/// axis, which is found by power iteration on the covariance matrix, and the
+/// segment is clipped to the extent of the projected pixels.
+/// \param px Channel values.
+/// \param n Number of channels to use.
+/// \param e0 [OUT] First endpoint.
+/// \param e1 [OUT] Second endpoint.
+
+static void FitLine(const float px[16][4], int n, float e0[4], float e1[4]){
+  float mean[4] = {0}, cov[4][4] = {0}, axis[4] = {1, 1, 1, 1};
+
+  for(int k=0; k<16; k++)
+    for(int c=0; c<n; c++)
+      mean[c] += px[k][c]/16.0f;
+
+  for(int k=0; k<16; k++)
+    for(int r=0; r<n; r++)
+      for(int c=0; c<n; c++)
+        cov[r][c] += (px[k][r] - mean[r])*(px[k][c] - mean[c]);
+
+  for(int iter=0; iter<8; iter++){ //power iteration
+    float v[4] = {0}, len = 0;
+
+    for(int r=0; r<n; r++){
+      for(int c=0; c<n; c++)
+        v[r] += cov[r][c]*axis[c];
+      len = max(len, fabsf(v[r]));
+    } //for
+
+    if(len < 1e-6f)break; //flat block, keep previous axis
+
+    for(int r=0; r<n; r++)
+      axis[r] = v[r]/len;
+  } //for
+
+  float tmin = 0, tmax = 0, norm = 0;
+
+  for(int c=0; c<n; c++)
+    norm += axis[c]*axis[c];
+
+  for(int k=0; k<16; k++){
+    float t = 0;
+
+    for(int c=0; c<n; c++)
+      t += (px[k][c] - mean[c])*axis[c];
+
+    tmin = min(tmin, t/norm);
+    tmax = max(tmax, t/norm);
+  } //for
+
+  for(int c=0; c<n; c++){
+    e0[c] = min(255.0f, max(0.0f, mean[c] + tmin*axis[c]));
+    e1[c] = min(255.0f, max(0.0f, mean[c] + tmax*axis[c]));
+  } //for
+} //FitLine
+
+/// Refine endpoints by least squares given the interpolation weight assigned to
+/// each pixel, that is, find the endpoints that minimize the squared error
+/// when pixel k is approximated by (1 - w[k])*e0 + w[k]*e1.
+/// \param px Channel values.
+/// \param n Number of channels to use.
+/// \param w Interpolation weights in [0, 1].
+/// \param e0 [IN, OUT] First endpoint.
+/// \param e1 [IN, OUT] Second endpoint.
+
+static void RefineLine(const float px[16][4], int n, const float w[16],
+  float e0[4], float e1[4])
+{
+  float a = 0, b = 0, c = 0, x[4] = {0}, y[4] = {0};
+
+  for(int k=0; k<16; k++){
+    const float u = 1.0f - w[k];
+    a += u*u; b += u*w[k]; c += w[k]*w[k];
+
+    for(int i=0; i<n; i++){
+      x[i] += u*px[k][i];
+      y[i] += w[k]*px[k][i];
+    } //for
+  } //for
+
+  const float det = a*c - b*b;
+  if(fabsf(det) < 1e-6f)return; //singular, keep what we have
+
+  for(int i=0; i<n; i++){
+    e0[i] = min(255.0f, max(0.0f, (c*x[i] - b*y[i])/det));
+    e1[i] = min(255.0f, max(0.0f, (a*y[i] - b*x[i])/det));
+  } //for
+} //RefineLine
+
+/// Squared distance between two colors.
+/// \param p First color.
+/// \param q Second color.
+/// \param n Number of channels to use.
+/// \return Squared Euclidean distance.
+
+static float Dist2(const float* p, const float* q, int n){
+  float d = 0;
+
+  for(int c=0; c<n; c++)
+    d += (p[c] - q[c])*(p[c] - q[c]);
+
+  return d;
+} //Dist2
+
+/// Quantize a color to RGB565.
+/// \param e Color with channels in [0, 255].
+/// \return RGB565 value.
+
+static WORD To565(const float e[4]){
+  const UINT r = UINT(e[0]*31.0f/255.0f + 0.5f);
+  const UINT g = UINT(e[1]*63.0f/255.0f + 0.5f);
+  const UINT b = UINT(e[2]*31.0f/255.0f + 0.5f);
+  return WORD(r << 11 | g << 5 | b);
+} //To565
+
+/// Expand an RGB565 color to 8 bits per channel.
+/// \param n RGB565 value.
+/// \param e [OUT] Color with channels in [0, 255].
+
+static void From565(WORD n, float e[4]){
+  const UINT r = n >> 11, g = (n >> 5) & 63, b = n & 31;
+  e[0] = float(r << 3 | r >> 2);
+  e[1] = float(g << 2 | g >> 4);
+  e[2] = float(b << 3 | b >> 2);
+} //From565
+
+/// Write bits into a 128-bit little-endian block, least significant first.
+/// \param dest Block.
+/// \param pos [IN, OUT] Bit position, advanced by `n`.
+/// \param v Value.
+/// \param n Number of bits.
+
+static void PutBits(BYTE* dest, UINT& pos, UINT v, UINT n){
+  for(UINT i=0; i<n; i++, pos++)
+    if(v & (1 << i))
+      dest[pos >> 3] |= BYTE(1 << (pos & 7));
+} //PutBits
+
+#pragma endregion Helper functions
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructors and destructors
+
+#pragma region Constructors and destructors
+
+/// \param f Compression format.
+
+CBlockCompressor::CBlockCompressor(eBlockFormat f):
+  m_eFormat(f), m_nBlockSize(f == eBlockFormat::BC1? 8: 16){
+} //constructor
+
+#pragma endregion Constructors and destructors
+
+///////////////////////////////////////////////////////////////////////////////
+// Block encoders
+
+#pragma region Block encoders
+
+/// Compress a 4x4 block to BC1 in 4-color mode. The endpoints are fitted to
+/// the principal axis, refined once by least squares, then quantized to RGB565
+/// and each pixel is assigned the closest of the four palette colors. Alpha
+/// is ignored.
+/// \param p Pointer to the top left pixel of the block.
+/// \param stride Distance between rows in pixels.
+/// \param dest [OUT] 8-byte compressed block.
+
+void CBlockCompressor::CompressBC1(const UINT* p, UINT stride, BYTE* dest) const{
+  const float fWeight[4] = {0.0f, 1.0f, 1.0f/3.0f, 2.0f/3.0f};
+
+  float px[16][4], e0[4] = {0}, e1[4] = {0}, pal[4][4] = {0}, w[16];
+  UINT index[16];
+
+  LoadBlock(p, stride, px);
+  FitLine(px, 3, e0, e1);
+
+  for(int pass=0; pass<2; pass++){
+    WORD c0 = To565(e0), c1 = To565(e1);
+
+    if(c0 < c1){ //4-color mode requires c0 > c1
+      std::swap(c0, c1);
+      std::swap(e0, e1);
+    } //if
+
+    From565(c0, pal[0]);
+    From565(c1, pal[1]);
+
+    for(int c=0; c<3; c++){
+      pal[2][c] = (2*pal[0][c] + pal[1][c])/3.0f;
+      pal[3][c] = (pal[0][c] + 2*pal[1][c])/3.0f;
+    } //for
+
+    for(int k=0; k<16; k++){
+      index[k] = 0;
+
+      for(UINT i=1; i<4; i++)
+        if(Dist2(px[k], pal[i], 3) < Dist2(px[k], pal[index[k]], 3))
+          index[k] = i;
+
+      w[k] = fWeight[index[k]];
+    } //for
+
+    if(pass == 0)
+      RefineLine(px, 3, w, e0, e1);
+
+    else{ //emit block
+      UINT bits = 0;
+
+      if(c0 == c1) //solid block, 3-color mode, use color 0 throughout
+        for(int k=0; k<16; k++)
+          index[k] = 0;
+
+      for(int k=0; k<16; k++)
+        bits |= index[k] << (2*k);
+
+      dest[0] = BYTE(c0); dest[1] = BYTE(c0 >> 8);
+      dest[2] = BYTE(c1); dest[3] = BYTE(c1 >> 8);
+
+      for(int i=0; i<4; i++)
+        dest[4 + i] = BYTE(bits >> (8*i));
+    } //else
+  } //for
+} //CompressBC1
+
+/// Compress a 4x4 block to BC7 mode 6, which has a single subset with
+/// 7-bit RGBA endpoints, a p-bit per endpoint, and 4-bit indices. The endpoints
+/// are fitted to the principal axis in RGBA space and refined once by least
+/// squares. The p-bit for each endpoint is chosen to minimize quantization
+/// error.
+/// \param p Pointer to the top left pixel of the block.
+/// \param stride Distance between rows in pixels.
+/// \param dest [OUT] 16-byte compressed block.
+
+void CBlockCompressor::CompressBC7(const UINT* p, UINT stride, BYTE* dest) const{
+  float px[16][4], e[2][4] = {0}, pal[16][4], w[16];
+  UINT q[2][4] = {0}, pbit[2] = {0}, index[16];
+
+  LoadBlock(p, stride, px);
+  FitLine(px, 4, e[0], e[1]);
+
+  for(int pass=0; pass<2; pass++){
+    for(int i=0; i<2; i++){ //quantize endpoints with best p-bit
+      float fBest = 1e30f;
+
+      for(UINT b=0; b<2; b++){
+        UINT t[4];
+        float err = 0;
+
+        for(int c=0; c<4; c++){
+          const int v = int((e[i][c] - b)/2.0f + 0.5f);
+          t[c] = UINT(min(127, max(0, v)));
+          const float d = float(t[c] << 1 | b) - e[i][c];
+          err += d*d;
+        } //for
+
+        if(err < fBest){
+          fBest = err;
+          pbit[i] = b;
+
+          for(int c=0; c<4; c++)
+            q[i][c] = t[c];
+        } //if
+      } //for
+    } //for
+
+    for(int k=0; k<16; k++) //palette
+      for(int c=0; c<4; c++){
+        const int a = q[0][c] << 1 | pbit[0], b = q[1][c] << 1 | pbit[1];
+        const int wt = g_nBC7Weight[k];
+        pal[k][c] = float(((64 - wt)*a + wt*b + 32) >> 6);
+      } //for
+
+    for(int k=0; k<16; k++){
+      index[k] = 0;
+
+      for(UINT i=1; i<16; i++)
+        if(Dist2(px[k], pal[i], 4) < Dist2(px[k], pal[index[k]], 4))
+          index[k] = i;
+
+      w[k] = g_nBC7Weight[index[k]]/64.0f;
+    } //for
+
+    if(pass == 0)
+      RefineLine(px, 4, w, e[0], e[1]);
+  } //for
+
+  if(index[0] & 8){ //anchor index must have its high bit clear
+    std::swap(q[0], q[1]);
+    std::swap(pbit[0], pbit[1]);
+
+    for(int k=0; k<16; k++)
+      index[k] = 15 - index[k];
+  } //if
+
+  UINT pos = 0;
+  memset(dest, 0, 16);
+
+  PutBits(dest, pos, 1 << 6, 7); //mode 6
+
+  for(int c=0; c<4; c++){
+    PutBits(dest, pos, q[0][c], 7);
+    PutBits(dest, pos, q[1][c], 7);
+  } //for
+
+  PutBits(dest, pos, pbit[0], 1);
+  PutBits(dest, pos, pbit[1], 1);
+  PutBits(dest, pos, index[0], 3);
+
+  for(int k=1; k<16; k++)
+    PutBits(dest, pos, index[k], 4);
+} //CompressBC7
+
+#pragma endregion Block encoders
+
+///////////////////////////////////////////////////////////////////////////////
+// Compression and assembly
+
+#pragma region Compression and assembly
+
+/// Compress every block of every tile and store the results in `m_vBlocks`.
+/// The blocks of each tile are stored in row-major order so that a row of
+/// blocks is contiguous. This is the only place that block encoding happens,
+/// so its cost is independent of the size of the tiling.
+/// \param tiles Tile pixels, 32-bit ARGB in row-major order.
+/// \param w Tile width in pixels.
+/// \param h Tile height in pixels.
+/// \return S_OK for success, E_FAIL if the tile size is not a multiple of 4.
+
+HRESULT CBlockCompressor::Compress(const std::vector<std::vector<UINT>>& tiles,
+  UINT w, UINT h)
+{
+  if(w == 0 || h == 0 || w%4 != 0 || h%4 != 0)return E_FAIL;
+
+  m_nTileWidth  = w/4;
+  m_nTileHeight = h/4;
+  m_vBlocks.resize(tiles.size());
+
+  for(size_t t=0; t<tiles.size(); t++){
+    std::vector<BYTE>& v = m_vBlocks[t];
+    v.resize(size_t(m_nTileWidth)*m_nTileHeight*m_nBlockSize);
+    BYTE* dest = v.data();
+
+    for(UINT i=0; i<m_nTileHeight; i++)
+      for(UINT j=0; j<m_nTileWidth; j++){
+        const UINT* p = &tiles[t][4*(i*w + j)];
+
+        if(m_eFormat == eBlockFormat::BC1)
+          CompressBC1(p, w, dest);
+        else CompressBC7(p, w, dest);
+
+        dest += m_nBlockSize;
+      } //for
+  } //for
+
+  return S_OK;
+} //Compress
+
+/// Save a Wang tiling as a DDS file of compressed blocks. Each row of blocks
+/// in the output is assembled in a buffer by copying the corresponding row of
+/// compressed blocks from each tile in the grid row, then written out, so
+/// memory use is independent of the height of the tiling. `Compress()` must
+/// have been called first.
+/// \param filename Name of the DDS file.
+/// \param tiler Wang tiler.
+/// \return S_OK for success, E_FAIL for failure.
+
+HRESULT CBlockCompressor::Save(const std::wstring& filename,
+  const CWangTiler& tiler) const
+{
+  if(m_vBlocks.empty())return E_FAIL; //nothing compressed
+
+  const size_t nGridWidth  = tiler.GetWidth();
+  const size_t nGridHeight = tiler.GetHeight();
+  const size_t nRowBytes = size_t(m_nTileWidth)*m_nBlockSize; //per tile
+
+  for(size_t i=0; i<nGridHeight; i++) //make sure indices are in range
+    for(size_t j=0; j<nGridWidth; j++)
+      if(tiler(i, j) >= m_vBlocks.size())return E_FAIL;
+
+  std::ofstream s(filename, std::ios::binary);
+  if(!s.is_open())return E_FAIL;
+
+  const UINT fmt = m_eFormat == eBlockFormat::BC1?
+    DDS_FORMAT_BC1: DDS_FORMAT_BC7;
+  const UINT w = UINT(4*m_nTileWidth*nGridWidth);
+  const UINT h = UINT(4*m_nTileHeight*nGridHeight);
+
+  if(FAILED(WriteDDSHeader(s, w, h, fmt)))return E_FAIL;
+
+  std::vector<BYTE> row(nRowBytes*nGridWidth); //one row of output blocks
+
+  for(size_t i=0; i<nGridHeight; i++)
+    for(UINT r=0; r<m_nTileHeight; r++){
+      BYTE* dest = row.data();
+
+      for(size_t j=0; j<nGridWidth; j++){
+        const BYTE* src = m_vBlocks[tiler(i, j)].data() + r*nRowBytes;
+        memcpy(dest, src, nRowBytes);
+        dest += nRowBytes;
+      } //for
+
+      s.write((const char*)row.data(), row.size());
+    } //for
+
+  return s.good()? S_OK: E_FAIL;
+} //Save
+
+#pragma endregion Compression and assembly
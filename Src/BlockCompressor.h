@@ -0,0 +1,72 @@
+/// \file BlockCompressor.h
+/// \brief Interface for CBlockCompressor.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef __BLOCKCOMPRESSOR_H__
+#define __BLOCKCOMPRESSOR_H__
+
+#include "Windows.h"
+#include <string>
+#include <vector>
+
+#include "WangTiler.h"
+
+/// \brief Block compression format.
+
+enum class eBlockFormat{
+  BC1, ///< 4 bits per pixel, opaque RGB.
+  BC7 ///< 8 bits per pixel, RGBA (mode 6 only).
+}; //eBlockFormat
+
+/// \brief Tile-aware block compressor.
+///
+/// Every 4x4 block of a Wang tiling image lies inside exactly one tile provided
+/// the tile width and height are multiples of 4, so its compressed form depends
+/// only on the tile. The block compressor therefore compresses each tile once
+/// and assembles the compressed image by copying rows of compressed blocks
+/// in the order given by a `CWangTiler`.
+
+class CBlockCompressor{
+  private:
+    eBlockFormat m_eFormat = eBlockFormat::BC1; ///< Compression format.
+    UINT m_nBlockSize = 8; ///< Bytes per compressed block.
+
+    UINT m_nTileWidth = 0; ///< Tile width in blocks.
+    UINT m_nTileHeight = 0; ///< Tile height in blocks.
+
+    std::vector<std::vector<BYTE>> m_vBlocks; ///< Compressed blocks per tile.
+
+    void CompressBC1(const UINT* p, UINT stride, BYTE* dest) const; ///< BC1.
+    void CompressBC7(const UINT* p, UINT stride, BYTE* dest) const; ///< BC7.
+
+  public:
+    CBlockCompressor(eBlockFormat f); ///< Constructor.
+
+    HRESULT Compress(const std::vector<std::vector<UINT>>& tiles,
+      UINT w, UINT h); ///< Compress tiles.
+    HRESULT Save(const std::wstring& filename,
+      const CWangTiler& tiler) const; ///< Save tiling as DDS.
+}; //CBlockCompressor
+
+#endif //__BLOCKCOMPRESSOR_H__
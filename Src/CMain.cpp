@@ -25,6 +25,15 @@
 
 #include "CMain.h"
 #include "WindowsHelpers.h"
+#include "BlockCompressor.h"
+#include "JpegWriter.h"
+#include "TileAtlas.h"
+#include "SvgWriter.h"
+#include "TextureBomber.h"
+#include "MemoryGovernor.h"
+
+/// Longest time in milliseconds that drawing waits for memory.
+static const DWORD MAXDRAWWAIT = 250;
 
 ///////////////////////////////////////////////////////////////////////////////
 // Constructors and destructors
@@ -42,6 +51,8 @@ CMain::CMain(const HWND hwnd):
   m_gdiplusToken = InitGDIPlus(); //initialize GDI+
   CreateMenus(); //create the menu bar
   m_pWangTiler = new CWangTiler(16, 16); //create the Wang tiler
+  m_pSuperTiler = new CSuperTiler; //create the super-tiler
+  m_pTileCache = new CTileCache; //create the tile cache
   
   if(FAILED(LoadTileSet(IDM_TILESET_DEFAULT, 8))) //load the default tile set
     FatalAppExit(0, "One or more default tileset images are missing.");
@@ -50,15 +61,16 @@ CMain::CMain(const HWND hwnd):
   Draw(); //draw it to the bitmap
 } //constructor
 
-/// Delete GDI+ objects, then shut down GDI+.
+/// Delete GDI+ objects, then shut down GDI+. The tile set must be deleted
+/// before the tile cache that holds its tiles.
 
 CMain::~CMain(){
   delete m_pWangTiler;
+  delete m_pSuperTiler;
   delete m_pBitmap;
-
-  for(UINT i=0; i<m_nNumTiles; i++)
-    delete m_pTile[i];
-  delete [] m_pTile;
+  CMemoryGovernor::GetInstance().Release(m_nReserved);
+  delete m_pTileSet;
+  delete m_pTileCache;
 
   Gdiplus::GdiplusShutdown(m_gdiplusToken);
 } //destructor
@@ -71,12 +83,19 @@ CMain::~CMain(){
 #pragma region Drawing functions
 
 /// Draw the bitmap `m_pBitmap` to the window client area, scaled down if
-/// necessary. This function should only be called in response to a WM_PAINT
+/// necessary. There is nothing to draw if there was not enough memory for
+/// the bitmap. This function should only be called in response to a WM_PAINT
 /// message.
 
 void CMain::OnPaint(){  
   PAINTSTRUCT ps; //paint structure
   HDC hdc = BeginPaint(m_hWnd, &ps); //device context
+
+  if(m_pBitmap == nullptr){ //not enough memory to draw
+    EndPaint(m_hWnd, &ps);
+    return;
+  } //if
+
   Gdiplus::Graphics graphics(hdc); //GDI+ graphics object
 
   //bitmap width and height
@@ -110,44 +129,282 @@ void CMain::OnPaint(){
   EndPaint(m_hWnd, &ps); //this must be done last
 } //OnPaint
 
-/// Draw the Wang tiling stored in the array `m_pTile` to the bitmap `m_pBitmap`
-/// using the tiles stored in array `m_pTile`. If `m_pBitmap` is **nullptr**,
-/// then a new bitmap of the appropriate size is created.
+/// Draw the Wang tiling generated by `m_pWangTiler` to the bitmap `m_pBitmap`
+/// using the tiles in tile set `m_pTileSet`. If `m_pBitmap` is **nullptr**
+/// or the wrong size, then a new bitmap of the appropriate size is created,
+/// after reserving the memory for it and the tiling from the global memory
+/// governor so that it counts against the budget shared with any background
+/// jobs. The UI thread waits at most `MAXDRAWWAIT` milliseconds for the
+/// memory, and if it is not available by then the user is told and nothing
+/// is drawn. The tile set renders straight into the bitmap on the shared thread
+/// pool at interactive priority, so that redrawing after a regenerate or a
+/// tileset change is not held up by batch work. If edge blending is on then
+/// the tiling is drawn by a texture bomber instead, unless it has super-tiles,
+/// which the texture bomber cannot draw, or its tiles are too small to blend.
 
 void CMain::Draw(){
-  const UINT nTileWidth  = m_pTile[0]->GetWidth();
-  const UINT nTileHeight = m_pTile[0]->GetHeight();
-
-  if(m_pBitmap == nullptr){
-    const int w = int(nTileWidth*m_pWangTiler->GetWidth());
-    const int h = int(nTileHeight*m_pWangTiler->GetHeight());
-    m_pBitmap = new Gdiplus::Bitmap(w, h);
-  } //if
+  const UINT nTileWidth  = m_pTileSet->GetTileWidth();
+  const UINT nTileHeight = m_pTileSet->GetTileHeight();
   
   const size_t nGridWidth  = m_pWangTiler->GetWidth();
   const size_t nGridHeight = m_pWangTiler->GetHeight();
 
-  Gdiplus::Rect r;
-  r.Width = nTileWidth;
-  r.Height = nTileHeight;
+  const int w = int(nTileWidth*nGridWidth); //bitmap width
+  const int h = int(nTileHeight*nGridHeight); //bitmap height
 
-  Gdiplus::Graphics graphics(m_pBitmap);
-  graphics.SetSmoothingMode(Gdiplus::SmoothingModeHighQuality);
+  if(m_pBitmap != nullptr &&
+    (m_pBitmap->GetWidth() != UINT(w) || m_pBitmap->GetHeight() != UINT(h)))
+  { //wrong size
+    delete m_pBitmap;
+    m_pBitmap = nullptr;
+    CMemoryGovernor::GetInstance().Release(m_nReserved);
+    m_nReserved = 0;
+  } //if
 
-  for(size_t i=0; i<nGridHeight; i++){
-    for(size_t j=0; j<nGridWidth; j++){
-      const size_t index = (*m_pWangTiler)(i, j);
-      graphics.DrawImage(m_pTile[index], r);
-      r.X += nTileWidth; //next column
-    } //for
-    
-    r.Y += nTileHeight; //next row
-    r.X = 0; //first column
-  } //for
+  if(m_pBitmap == nullptr){
+    const size_t bytes = CMemoryGovernor::GetTilingBytes(
+      nGridWidth, nGridHeight, nTileWidth, nTileHeight);
+
+    if(FAILED(CMemoryGovernor::GetInstance().Reserve(bytes, MAXDRAWWAIT))){
+      MessageBoxW(m_hWnd, L"Not enough memory to draw the tiling.",
+        L"Error", MB_ICONERROR | MB_OK);
+      return;
+    } //if
+
+    m_nReserved = bytes;
+    m_pBitmap = new Gdiplus::Bitmap(w, h, PixelFormat32bppARGB);
+  } //if
+
+  Gdiplus::Rect r(0, 0, w, h);
+  Gdiplus::BitmapData data;
+
+  if(m_pBitmap->LockBits(&r, Gdiplus::ImageLockModeWrite,
+    PixelFormat32bppARGB, &data) != Gdiplus::Ok)return;
+
+  const bool blend = m_bBlend && m_pSuperTiler->GetPlacements().empty();
+
+  if(!blend || FAILED(CTextureBomber().Render(*m_pTileSet, *m_pWangTiler,
+    (BYTE*)data.Scan0, size_t(data.Stride), ePriority::Interactive)))
+    m_pTileSet->Render(*m_pWangTiler, (BYTE*)data.Scan0, size_t(data.Stride),
+      ePriority::Interactive, m_pSuperTiler);
+
+  m_pBitmap->UnlockBits(&data);
 } //Draw
 
 #pragma endregion Drawing functions
 
+///////////////////////////////////////////////////////////////////////////////
+// Export functions
+
+#pragma region Export functions
+
+/// Get the pixels of every tile in the current tileset as 32-bit ARGB.
+/// \param v [OUT] One pixel array per tile.
+/// \return S_OK for success, E_FAIL for failure.
+
+HRESULT CMain::GetTilePixels(std::vector<std::vector<UINT>>& v){
+  v.resize(m_pTileSet->GetSize());
+
+  for(UINT i=0; i<m_pTileSet->GetSize(); i++)
+    v[i] = m_pTileSet->GetTile(i)->GetPixels();
+
+  return v.empty()? E_FAIL: S_OK;
+} //GetTilePixels
+
+/// Get the tile pixels for an exporter that works a whole tile at a time,
+/// with the super-tiles in the current tiling, if any, flattened into
+/// cell-sized pieces by `CSuperTiler::Flatten()`.
+/// \param v [OUT] Vector of tile pixels, then super-tile pieces.
+/// \param pFlat [OUT] Pointer to a new Wang tiler with the flattened tile
+/// indices, which the caller must delete, or **nullptr** if there are no
+/// super-tiles and the current Wang tiler is to be exported as it is.
+/// \return S_OK for success, E_FAIL for failure.
+
+HRESULT CMain::GetExportTiles(std::vector<std::vector<UINT>>& v,
+  CWangTiler*& pFlat)
+{
+  pFlat = nullptr;
+
+  if(FAILED(GetTilePixels(v)))return E_FAIL;
+  if(m_pSuperTiler->GetPlacements().empty())return S_OK;
+
+  pFlat = new CWangTiler(m_pWangTiler->GetWidth(), m_pWangTiler->GetHeight());
+
+  if(FAILED(m_pSuperTiler->Flatten(*m_pWangTiler, *m_pTileSet, *pFlat, v))){
+    delete pFlat;
+    pFlat = nullptr;
+    return E_FAIL;
+  } //if
+
+  return S_OK;
+} //GetExportTiles
+
+/// Export the current Wang tiling as a block-compressed DDS file. The tiles are
+/// compressed once each and the output is assembled from their compressed
+/// blocks, so the time taken is little more than the time needed to write the
+/// file. Super-tiles are flattened into extra tiles first. The tile width and
+/// height must be multiples of 4.
+/// \param idm Menu identifier, either `IDM_EXPORT_BC1` or `IDM_EXPORT_BC7`.
+/// \return S_OK for success, E_FAIL for failure.
+
+HRESULT CMain::ExportDDS(const UINT idm){
+  std::wstring filename; //output file name
+  std::vector<std::vector<UINT>> pixels; //tile pixels
+
+  const UINT w = m_pTileSet->GetTileWidth(); //tile width
+  const UINT h = m_pTileSet->GetTileHeight(); //tile height
+
+  CBlockCompressor compressor(idm == IDM_EXPORT_BC1?
+    eBlockFormat::BC1: eBlockFormat::BC7);
+
+  CWangTiler* pFlat = nullptr; //flattened super-tiles, if any
+
+  if(FAILED(SaveFileDialog(m_hWnd, L"DDS Files", L"dds", filename)))
+    return E_FAIL; //user cancelled
+
+  if(FAILED(GetExportTiles(pixels, pFlat)) ||
+    FAILED(compressor.Compress(pixels, w, h)))
+  {
+    delete pFlat;
+    MessageBoxW(m_hWnd, L"Tile width and height must be multiples of 4.",
+      L"Error", MB_ICONERROR | MB_OK);
+    return E_FAIL;
+  } //if
+
+  const HRESULT hr = compressor.Save(filename,
+    pFlat != nullptr? *pFlat: *m_pWangTiler);
+  delete pFlat;
+
+  if(FAILED(hr)){
+    std::wstring s = L"Error saving file " + filename;
+    MessageBoxW(m_hWnd, s.c_str(), L"Error", MB_ICONERROR | MB_OK);
+    return E_FAIL;
+  } //if
+
+  return S_OK;
+} //ExportDDS
+
+/// Export the current Wang tiling as a baseline JPEG file. The tiles are
+/// transformed and quantized once each and only the entropy coding is done
+/// per block of the output. Super-tiles are flattened into extra tiles first.
+/// The tile width and height must be multiples of 8.
+/// \return S_OK for success, E_FAIL for failure.
+
+HRESULT CMain::ExportJPEG(){
+  std::wstring filename; //output file name
+  std::vector<std::vector<UINT>> pixels; //tile pixels
+
+  const UINT w = m_pTileSet->GetTileWidth(); //tile width
+  const UINT h = m_pTileSet->GetTileHeight(); //tile height
+
+  CJpegWriter writer;
+
+  CWangTiler* pFlat = nullptr; //flattened super-tiles, if any
+
+  if(FAILED(SaveFileDialog(m_hWnd, L"JPEG Files", L"jpg", filename)))
+    return E_FAIL; //user cancelled
+
+  if(FAILED(GetExportTiles(pixels, pFlat)) ||
+    FAILED(writer.Compress(pixels, w, h)))
+  {
+    delete pFlat;
+    MessageBoxW(m_hWnd, L"Tile width and height must be multiples of 8.",
+      L"Error", MB_ICONERROR | MB_OK);
+    return E_FAIL;
+  } //if
+
+  const HRESULT hr = writer.Save(filename,
+    pFlat != nullptr? *pFlat: *m_pWangTiler);
+  delete pFlat;
+
+  if(FAILED(hr)){
+    std::wstring s = L"Error saving file " + filename;
+    MessageBoxW(m_hWnd, s.c_str(), L"Error", MB_ICONERROR | MB_OK);
+    return E_FAIL;
+  } //if
+
+  return S_OK;
+} //ExportJPEG
+
+/// Export the current tileset as a tile atlas, that is, a DDS texture array
+/// with one element per tile, each surrounded by a gutter copied from matching
+/// neighbors and each with its own mip chain.
+/// \return S_OK for success, E_FAIL for failure.
+
+HRESULT CMain::ExportAtlas(){
+  std::wstring filename; //output file name
+  std::vector<std::vector<UINT>> pixels; //tile pixels
+
+  const UINT w = m_pTileSet->GetTileWidth(); //tile width
+  const UINT h = m_pTileSet->GetTileHeight(); //tile height
+
+  CTileAtlas atlas;
+
+  if(FAILED(SaveFileDialog(m_hWnd, L"DDS Files", L"dds", filename)))
+    return E_FAIL; //user cancelled
+
+  if(FAILED(GetTilePixels(pixels)) || FAILED(atlas.Build(pixels, w, h)) ||
+    FAILED(atlas.Save(filename)))
+  {
+    std::wstring s = L"Error saving file " + filename;
+    MessageBoxW(m_hWnd, s.c_str(), L"Error", MB_ICONERROR | MB_OK);
+    return E_FAIL;
+  } //if
+
+  return S_OK;
+} //ExportAtlas
+
+/// Export the current Wang tiling as an SVG file for printing. Each tile is
+/// embedded once as a PNG image and each cell refers to it, so the file size
+/// grows with the number of cells rather than the number of pixels. Each
+/// super-tile is embedded once too.
+/// \return S_OK for success, E_FAIL for failure.
+
+HRESULT CMain::ExportSVG(){
+  std::wstring filename; //output file name
+  std::vector<std::vector<BYTE>> png(m_pTileSet->GetSize()); //tile images
+
+  const UINT w = m_pTileSet->GetTileWidth(); //tile width
+  const UINT h = m_pTileSet->GetTileHeight(); //tile height
+
+  CSvgWriter writer;
+
+  std::vector<std::vector<BYTE>> superpng; //super-tile images
+  std::vector<UINT> size; //super-tile sizes
+
+  if(FAILED(SaveFileDialog(m_hWnd, L"SVG Files", L"svg", filename)))
+    return E_FAIL; //user cancelled
+
+  HRESULT hr = S_OK;
+
+  for(UINT i=0; i<m_pTileSet->GetSize() && SUCCEEDED(hr); i++)
+    hr = EncodePNG(m_pTileSet->GetTile(i)->GetBitmap(), png[i]);
+
+  if(!m_pSuperTiler->GetPlacements().empty()){
+    superpng.resize(m_pTileSet->GetSuperTileCount());
+    size.resize(m_pTileSet->GetSuperTileCount());
+
+    for(UINT i=0; i<m_pTileSet->GetSuperTileCount() && SUCCEEDED(hr); i++){
+      const SSuperTile& super = m_pTileSet->GetSuperTile(i);
+      hr = EncodePNG(super.m_pTile->GetBitmap(), superpng[i]);
+      size[i] = super.m_nSize;
+    } //for
+  } //if
+
+  if(FAILED(hr) || FAILED(writer.Build(png, w, h)) ||
+    FAILED(writer.BuildSuper(superpng, size)) ||
+    FAILED(writer.Save(filename, *m_pWangTiler, m_pSuperTiler)))
+  {
+    std::wstring s = L"Error saving file " + filename;
+    MessageBoxW(m_hWnd, s.c_str(), L"Error", MB_ICONERROR | MB_OK);
+    return E_FAIL;
+  } //if
+
+  return S_OK;
+} //ExportSVG
+
+#pragma endregion Export functions
+
 ///////////////////////////////////////////////////////////////////////////////
 // Menu functions
 
@@ -171,63 +428,53 @@ void CMain::CreateMenus(){
 ///////////////////////////////////////////////////////////////////////////////
 // Other functions
 
-/// Load a tileset into `m_pTile` and set the checkmarks on the `Tileset` menu.
-/// Assumes that `m_hTilesetMenu` contains a handle to the `Tileset` menu and
-/// that the tile images are in separate numbered png files in a hard-coded
-/// subfolder of the `tiles` folder.
+/// Load a tileset into `m_pTileSet` and set the checkmarks on the `Tileset`
+/// menu. Assumes that `m_hTilesetMenu` contains a handle to the `Tileset` menu
+/// and that the tile images are in separate numbered png files in a hard-coded
+/// subfolder of the `tiles` folder, or if there is no such subfolder then in a
+/// zip archive of the same name with `.zip` appended. The new tile set is
+/// loaded before the old one is released, so tiles that they have in common
+/// are decoded but not stored twice, and the current tile set is unchanged if
+/// loading fails.
+/// The tiling is regenerated if the old or new tile set has super-tiles,
+/// since the super-tiles placed in it belong to the old tile set.
 /// \param idm A menu identifier for the required tileset.
 /// \param n Number of tiles in the tileset.
 /// \return S_OK if the tileset loaded correctly, E_FAIL otherwise.
 
 HRESULT CMain::LoadTileSet(const UINT idm, const UINT n){
-  UINT i = 0;
-  bool error = false;
-  std::wstring filename;
-  Gdiplus::Bitmap** temp = new Gdiplus::Bitmap*[n];
-
-  if(m_nNumTiles != n){
-    for(UINT i=0; i<m_nNumTiles; i++)
-      delete m_pTile[i];
-    delete [] m_pTile;
+  std::wstring folder = L"tiles\\"; //folder name
+  std::wstring filename; //name of file that failed to load
 
-    m_pTile = new Gdiplus::Bitmap*[n];
-    for(UINT i=0; i<n; i++)
-      m_pTile[i] = nullptr;
+  switch(idm){
+    case IDM_TILESET_DEFAULT: folder += L"default"; break;      
+    case IDM_TILESET_FLOWER:  folder += L"flowers"; break;
+    case IDM_TILESET_MUD:     folder += L"mud";     break;
+    case IDM_TILESET_GRASS:   folder += L"grass";   break;
+  } //switch
 
-    m_nNumTiles = n;
-  } //if
-
-  for(i=0; i<n && !error; i++){ //for each tile
-    filename = L"tiles\\"; //file name
-
-    switch(idm){
-      case IDM_TILESET_DEFAULT: filename += L"default"; break;      
-      case IDM_TILESET_FLOWER:  filename += L"flowers"; break;
-      case IDM_TILESET_MUD:     filename += L"mud";     break;
-      case IDM_TILESET_GRASS:   filename += L"grass";   break;
-    } //switch
+  if(GetFileAttributesW(folder.c_str()) == INVALID_FILE_ATTRIBUTES)
+    folder += L".zip"; //no folder, so try a zip archive
 
-    filename += std::wstring(L"\\") + std::to_wstring(i) + L".png";
-
-    temp[i] = Gdiplus::Bitmap::FromFile(filename.c_str()); //load tile
-    error = temp[i]->GetLastStatus() != Gdiplus::Ok;
-  } //for
+  CTileSet* pTileSet = new CTileSet(m_pTileCache);
+  const bool error = FAILED(pTileSet->Load(folder, n, filename));
 
   //error handling
 
   if(error){ //fail
     std::wstring s = L"Error loading file " + filename;
     MessageBoxW(m_hWnd, s.c_str(), L"Error", MB_ICONERROR | MB_OK);
-
-    for(UINT j=0; j<i; j++)
-      delete temp[j];
+    delete pTileSet;
   } //if
 
   else{ //success
-    for(UINT j=0; j<n; j++){ //copy tile pointers to m_pTile
-      delete m_pTile[j];
-      m_pTile[j] = temp[j];
-    } //for
+    const bool regenerate = m_pTileSet != nullptr &&
+      (m_pTileSet->GetSuperTileCount() > 0 || pTileSet->GetSuperTileCount() > 0);
+
+    delete m_pTileSet;
+    m_pTileSet = pTileSet;
+
+    if(regenerate)Generate();
 
     //unset menu checkmarks then check the one we want
     CheckMenuItem(m_hTilesetMenu, IDM_TILESET_DEFAULT, MF_UNCHECKED);
@@ -238,14 +485,28 @@ HRESULT CMain::LoadTileSet(const UINT idm, const UINT n){
     CheckMenuItem(m_hTilesetMenu, idm, MF_CHECKED);
   } //else
 
-  delete [] temp;
   return error? E_FAIL: S_OK;
 } //LoadTileSet
 
-/// Generate a Wang tiling.
+/// Toggle blending of tile edges on or off and update the checkmark on the
+/// `Tileset` menu to match. The caller should redraw.
+
+void CMain::ToggleBlend(){
+  m_bBlend = !m_bBlend;
+  CheckMenuItem(m_hTilesetMenu, IDM_TILESET_BLEND,
+    m_bBlend? MF_CHECKED: MF_UNCHECKED);
+} //ToggleBlend
+
+/// Generate a Wang tiling, with super-tiles if the current tile set has any.
 
 void CMain::Generate(){
-  m_pWangTiler->Generate();
+  if(m_pTileSet->GetSuperTileCount() > 0)
+    m_pSuperTiler->Generate(*m_pWangTiler, *m_pTileSet);
+
+  else{
+    m_pSuperTiler->Clear();
+    m_pWangTiler->Generate();
+  } //else
 } //Generate
 
 /// Reader function for the bitmap pointer `m_pBitmap` which, it is assumed,
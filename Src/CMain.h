@@ -29,6 +29,8 @@
 #include "Includes.h"
 #include "WindowsHelpers.h"
 #include "WangTiler.h"
+#include "TileSet.h"
+#include "SuperTiler.h"
 
 /// \brief The main class.
 ///
@@ -44,20 +46,31 @@ class CMain{
     ULONG_PTR m_gdiplusToken = 0; ///< GDI+ token.
 
     Gdiplus::Bitmap* m_pBitmap = nullptr; ///< Pointer to a bitmap image.
+    size_t m_nReserved = 0; ///< Bytes reserved from the memory governor.
 
     CWangTiler* m_pWangTiler; ///< Pointer to the Wang tiler.
-    Gdiplus::Bitmap** m_pTile = nullptr; ///< The tile pointer array.
-    UINT m_nNumTiles = 0; ///< Number of tiles in tileset.
+    CSuperTiler* m_pSuperTiler = nullptr; ///< Pointer to the super-tiler.
+    CTileCache* m_pTileCache = nullptr; ///< Pointer to the tile cache.
+    CTileSet* m_pTileSet = nullptr; ///< Pointer to the current tile set.
+    bool m_bBlend = false; ///< Whether to blend tile edges.
 
     void CreateMenus(); ///< Create menus.
+    HRESULT GetTilePixels(std::vector<std::vector<UINT>>& v); ///< Get tile pixels.
+    HRESULT GetExportTiles(std::vector<std::vector<UINT>>& v,
+      CWangTiler*& pFlat); ///< Get tiles to export.
 
   public:
     CMain(const HWND hwnd); ///< Constructor.
     ~CMain(); ///< Destructor.
     
     HRESULT LoadTileSet(const UINT idm, const UINT n); ///< Load tileset.
+    void ToggleBlend(); ///< Toggle blending of tile edges.
     void Generate(); ///< Generate a Wang tiling.
     void Draw(); ///< Draw the Wang tiling.
+    HRESULT ExportDDS(const UINT idm); ///< Export block-compressed DDS.
+    HRESULT ExportJPEG(); ///< Export JPEG.
+    HRESULT ExportAtlas(); ///< Export tile atlas.
+    HRESULT ExportSVG(); ///< Export SVG.
 
     void OnPaint(); ///< Paint the client area of the window.
     Gdiplus::Bitmap* GetBitmap(); ///< Get pointer to bitmap.
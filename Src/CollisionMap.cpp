@@ -0,0 +1,361 @@
+/// \file CollisionMap.cpp
+/// \brief Code for CCollisionMap.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <intrin.h>
+
+#include "CollisionMap.h"
+#include "ThreadPool.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Bake functions
+
+#pragma region Bake functions
+
+/// Check that a tiling can be baked with a tile set.
+/// \param tiler Wang tiler.
+/// \param tileset Tile set.
+/// \return S_OK if the tile set has collision masks and every tile in the
+/// tiling is in it, E_FAIL otherwise.
+
+HRESULT CCollisionMap::Check(const CWangTiler& tiler,
+  const CTileSet& tileset)
+{
+  if(tileset.GetMaskStride() == 0)return E_FAIL;
+
+  for(size_t i=0; i<tiler.GetHeight(); i++)
+    for(size_t j=0; j<tiler.GetWidth(); j++)
+      if(tiler(i, j) >= tileset.GetSize())return E_FAIL;
+
+  return S_OK;
+} //Check
+
+/// Bake one band of the collision map, that is, the pixel rows covered by
+/// one row of tiles. Each word of each tile mask row is shifted right by the
+/// bit offset of the tile within its destination word and ORed in, and the
+/// bits that it shifts out are shifted left into the next word. Unused bits
+/// at the end of tile mask rows are clear, so they never set a bit that
+/// belongs to the next tile.
+/// \param tiler Wang tiler.
+/// \param tileset Tile set with collision masks.
+/// \param i Tile row.
+/// \param stride Words per destination row.
+/// \param pDest [OUT] First word of the band.
+
+void CCollisionMap::BakeBand(const CWangTiler& tiler, const CTileSet& tileset,
+  size_t i, size_t stride, UINT64* pDest)
+{
+  const size_t tw = tileset.GetTileWidth(), th = tileset.GetTileHeight();
+  const size_t ms = tileset.GetMaskStride(); //words per mask row
+
+  memset(pDest, 0, th*stride*sizeof(UINT64));
+
+  for(size_t j=0; j<tiler.GetWidth(); j++){
+    const UINT64* pSrc = tileset.GetMask(UINT(tiler(i, j)));
+
+    for(size_t k=0; k<ms; k++){ //for each word of a mask row
+      const size_t offset = j*tw + 64*k; //bit offset in destination row
+      const size_t d = offset/64; //destination word
+      const UINT s = UINT(offset%64); //shift
+      const bool spill = s > 0 && d + 1 < stride; //whether to use next word
+
+      for(size_t y=0; y<th; y++){
+        const UINT64 w = pSrc[y*ms + k];
+        UINT64* p = pDest + y*stride + d;
+
+        p[0] |= w >> s;
+        if(spill)p[1] |= w << (64 - s);
+      } //for
+    } //for
+  } //for
+} //BakeBand
+
+/// Bake the collision map for a tiling, one band per task on the shared
+/// thread pool. The tiling must not have super-tiles, since the cells under
+/// them hold filler tiles (see `CSuperTiler`).
+/// \param tiler Wang tiler.
+/// \param tileset Tile set with collision masks.
+/// \return S_OK for success, E_FAIL if the tile set has no collision masks
+/// or the tiling refers to a missing tile.
+
+HRESULT CCollisionMap::Bake(const CWangTiler& tiler, const CTileSet& tileset){
+  if(FAILED(Check(tiler, tileset)))return E_FAIL;
+
+  const size_t th = tileset.GetTileHeight();
+
+  m_nWidth = tiler.GetWidth()*tileset.GetTileWidth();
+  m_nHeight = tiler.GetHeight()*th;
+  m_nStride = (m_nWidth + 63)/64;
+  m_vBits.resize(m_nHeight*m_nStride);
+
+  CThreadPool::GetInstance().ParallelFor(tiler.GetHeight(), 1,
+    [&](size_t i0, size_t i1){
+      for(size_t i=i0; i<i1; i++)
+        BakeBand(tiler, tileset, i, m_nStride, &m_vBits[i*th*m_nStride]);
+    }); //ParallelFor
+
+  return S_OK;
+} //Bake
+
+#pragma endregion Bake functions
+
+///////////////////////////////////////////////////////////////////////////////
+// Save functions
+
+#pragma region Save functions
+
+/// Write rows of bits to a binary PBM file. PBM rows are packed into bytes
+/// with the leftmost pixel in the most significant bit, so each word only
+/// needs its bytes swapped into big-endian order.
+/// \param s Output stream, positioned after the PBM header.
+/// \param p First word of the first row.
+/// \param rows Number of rows.
+/// \param stride Words per row.
+/// \param width Width in pixels.
+/// \return S_OK for success, E_FAIL for failure.
+
+HRESULT CCollisionMap::WriteRows(std::ofstream& s, const UINT64* p,
+  size_t rows, size_t stride, size_t width)
+{
+  std::vector<UINT64> row(stride); //one row in big-endian order
+
+  for(size_t y=0; y<rows; y++){
+    for(size_t k=0; k<stride; k++)
+      row[k] = _byteswap_uint64(p[y*stride + k]);
+
+    s.write((const char*)row.data(), (width + 7)/8);
+  } //for
+
+  return s.good()? S_OK: E_FAIL;
+} //WriteRows
+
+/// Save the collision map as a binary PBM file, in which solid pixels are
+/// black. `Bake()` must have been called first.
+/// \param filename Name of the PBM file.
+/// \return S_OK for success, E_FAIL for failure.
+
+HRESULT CCollisionMap::Save(const std::wstring& filename) const{
+  if(m_vBits.empty())return E_FAIL; //nothing baked
+
+  std::ofstream s(filename, std::ios::binary);
+  if(!s.is_open())return E_FAIL;
+
+  s << "P4\n" << m_nWidth << " " << m_nHeight << "\n";
+  return WriteRows(s, m_vBits.data(), m_nHeight, m_nStride, m_nWidth);
+} //Save
+
+/// Bake the collision map for a tiling straight to a binary PBM file without
+/// holding the whole map in memory. Bands are baked in batches of two per
+/// thread pool worker, and each batch is written in order before the next is
+/// baked into the same buffer.
+/// \param tiler Wang tiler.
+/// \param tileset Tile set with collision masks.
+/// \param filename Name of the PBM file.
+/// \return S_OK for success, E_FAIL if the tile set has no collision masks,
+/// the tiling refers to a missing tile, or the file cannot be written.
+
+HRESULT CCollisionMap::Stream(const CWangTiler& tiler,
+  const CTileSet& tileset, const std::wstring& filename)
+{
+  if(FAILED(Check(tiler, tileset)))return E_FAIL;
+
+  std::ofstream s(filename, std::ios::binary);
+  if(!s.is_open())return E_FAIL;
+
+  CThreadPool& pool = CThreadPool::GetInstance();
+  const size_t th = tileset.GetTileHeight();
+  const size_t w = tiler.GetWidth()*tileset.GetTileWidth(); //width in pixels
+  const size_t stride = (w + 63)/64; //words per row
+  const size_t batch = 2*size_t(max(1U, pool.GetSize())); //bands per batch
+  std::vector<UINT64> buffer(batch*th*stride); //batch of bands
+
+  s << "P4\n" << w << " " << tiler.GetHeight()*th << "\n";
+
+  for(size_t b=0; b<tiler.GetHeight() && s.good(); b+=batch){
+    const size_t n = min(batch, tiler.GetHeight() - b); //bands in batch
+
+    pool.ParallelFor(n, 1, [&](size_t i0, size_t i1){
+      for(size_t i=i0; i<i1; i++)
+        BakeBand(tiler, tileset, b + i, stride, &buffer[i*th*stride]);
+    }); //ParallelFor
+
+    if(FAILED(WriteRows(s, buffer.data(), n*th, stride, w)))return E_FAIL;
+  } //for
+
+  return s.good()? S_OK: E_FAIL;
+} //Stream
+
+#pragma endregion Save functions
+
+///////////////////////////////////////////////////////////////////////////////
+// Query functions
+
+#pragma region Query functions
+
+/// Get one word of a horizontal span with the bits outside the span clear.
+/// \param k Word index in the row.
+/// \param x0 First pixel of the span.
+/// \param x1 One past the last pixel of the span.
+/// \param y Row.
+/// \return Bits of word `k` that lie in the span.
+
+UINT64 CCollisionMap::GetSpanWord(size_t k, size_t x0, size_t x1,
+  size_t y) const
+{
+  UINT64 w = m_vBits[y*m_nStride + k];
+
+  if(k == x0/64)w &= ~0ULL >> (x0%64);
+  if(k == (x1 - 1)/64)w &= ~0ULL << (63 - (x1 - 1)%64);
+
+  return w;
+} //GetSpanWord
+
+/// Test whether a pixel is solid.
+/// \param x Column.
+/// \param y Row.
+/// \return true if the pixel is solid.
+
+const bool CCollisionMap::IsSolid(size_t x, size_t y) const{
+  return (m_vBits[y*m_nStride + x/64] >> (63 - x%64) & 1) != 0;
+} //IsSolid
+
+/// Get the 64 pixels of a row starting at a given pixel, which need not be
+/// at the start of a word, with the given pixel in the most significant bit.
+/// Pixels past the end of the row are clear.
+/// \param x First column.
+/// \param y Row.
+/// \return Bits of 64 pixels.
+
+const UINT64 CCollisionMap::GetBits(size_t x, size_t y) const{
+  const size_t k = x/64; //word index
+  const UINT s = UINT(x%64); //shift
+  const UINT64* p = &m_vBits[y*m_nStride + k];
+
+  UINT64 w = p[0] << s;
+  if(s > 0 && k + 1 < m_nStride)w |= p[1] >> (64 - s);
+
+  return w;
+} //GetBits
+
+/// Test whether any pixel in a horizontal span is solid, a word at a time.
+/// \param x0 First column.
+/// \param x1 One past the last column.
+/// \param y Row.
+/// \return true if any pixel in the span is solid.
+
+const bool CCollisionMap::AnySolid(size_t x0, size_t x1, size_t y) const{
+  if(x0 >= x1)return false;
+
+  for(size_t k=x0/64; k<=(x1 - 1)/64; k++)
+    if(GetSpanWord(k, x0, x1, y) != 0)return true;
+
+  return false;
+} //AnySolid
+
+/// Find the first solid pixel in a horizontal span, a word at a time. The
+/// 32-bit intrinsic is used on each half of a word, since the 64-bit one is
+/// only available on x64.
+/// \param x0 First column.
+/// \param x1 One past the last column.
+/// \param y Row.
+/// \return Column of the first solid pixel, or `x1` if there is none.
+
+const size_t CCollisionMap::FindSolid(size_t x0, size_t x1, size_t y) const{
+  if(x0 >= x1)return x1;
+
+  for(size_t k=x0/64; k<=(x1 - 1)/64; k++){
+    const UINT64 w = GetSpanWord(k, x0, x1, y);
+    DWORD index = 0; //index of most significant set bit
+
+    if(_BitScanReverse(&index, DWORD(w >> 32)))
+      return 64*k + 31 - index;
+
+    if(_BitScanReverse(&index, DWORD(w)))
+      return 64*k + 63 - index;
+  } //for
+
+  return x1;
+} //FindSolid
+
+/// Count the solid pixels in a horizontal span, a word at a time. The bits
+/// are counted in parallel within the word with shifts and masks rather
+/// than the popcount intrinsic, which needs a CPU with POPCNT.
+/// \param x0 First column.
+/// \param x1 One past the last column.
+/// \param y Row.
+/// \return Number of solid pixels.
+
+const size_t CCollisionMap::CountSolid(size_t x0, size_t x1, size_t y) const{
+  if(x0 >= x1)return 0;
+
+  size_t n = 0; //number of solid pixels
+
+  for(size_t k=x0/64; k<=(x1 - 1)/64; k++){
+    UINT64 w = GetSpanWord(k, x0, x1, y);
+    w -= (w >> 1) & 0x5555555555555555ULL; //2-bit counts
+    w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+    w = (w + (w >> 4)) & 0x0F0F0F0F0F0F0F0FULL; //byte counts
+    n += size_t((w*0x0101010101010101ULL) >> 56); //sum of byte counts
+  } //for
+
+  return n;
+} //CountSolid
+
+#pragma endregion Query functions
+
+///////////////////////////////////////////////////////////////////////////////
+// Reader functions
+
+#pragma region Reader functions
+
+/// Reader function for the width.
+/// \return Width in pixels.
+
+const size_t CCollisionMap::GetWidth() const{
+  return m_nWidth;
+} //GetWidth
+
+/// Reader function for the height.
+/// \return Height in pixels.
+
+const size_t CCollisionMap::GetHeight() const{
+  return m_nHeight;
+} //GetHeight
+
+/// Reader function for the stride.
+/// \return Number of 64-bit words per row.
+
+const size_t CCollisionMap::GetStride() const{
+  return m_nStride;
+} //GetStride
+
+/// Get a row of the collision map.
+/// \param y Row.
+/// \return Pointer to the first of `GetStride()` words.
+
+const UINT64* CCollisionMap::GetRow(size_t y) const{
+  return &m_vBits[y*m_nStride];
+} //GetRow
+
+#pragma endregion Reader functions
@@ -0,0 +1,89 @@
+/// \file CollisionMap.h
+/// \brief Interface for CCollisionMap.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef __COLLISIONMAP_H__
+#define __COLLISIONMAP_H__
+
+#include "Windows.h"
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "WangTiler.h"
+#include "TileSet.h"
+
+/// \brief Bit-packed collision bitmap.
+///
+/// A collision map has one bit per pixel of a rendered Wang tiling, set where
+/// the pixel is solid, composed from the collision masks of the tiles. Each
+/// row is packed into 64-bit words with the leftmost pixel in the most
+/// significant bit. Rows are assembled a word at a time: each word of a tile
+/// mask row is shifted into place and ORed into at most two words of the
+/// map row, so the cost depends on the number of words rather than pixels.
+/// The map is baked one band of tile-height rows per task, and can also be
+/// written straight to a PBM file a few bands at a time without holding the
+/// whole map in memory. Queries test or search horizontal spans a word at a
+/// time.
+
+class CCollisionMap{
+  private:
+    size_t m_nWidth = 0; ///< Width in pixels.
+    size_t m_nHeight = 0; ///< Height in pixels.
+    size_t m_nStride = 0; ///< Words per row.
+    std::vector<UINT64> m_vBits; ///< Bits in row-major order.
+
+    static void BakeBand(const CWangTiler& tiler, const CTileSet& tileset,
+      size_t i, size_t stride, UINT64* pDest); ///< Bake a row of tiles.
+    static HRESULT Check(const CWangTiler& tiler,
+      const CTileSet& tileset); ///< Check that a tiling can be baked.
+    static HRESULT WriteRows(std::ofstream& s, const UINT64* p, size_t rows,
+      size_t stride, size_t width); ///< Write rows to a PBM file.
+    UINT64 GetSpanWord(size_t k, size_t x0, size_t x1,
+      size_t y) const; ///< Get one word of a span.
+
+  public:
+    HRESULT Bake(const CWangTiler& tiler,
+      const CTileSet& tileset); ///< Bake from a tiling.
+    HRESULT Save(const std::wstring& filename) const; ///< Save as PBM.
+
+    static HRESULT Stream(const CWangTiler& tiler, const CTileSet& tileset,
+      const std::wstring& filename); ///< Bake straight to a PBM file.
+
+    const bool IsSolid(size_t x, size_t y) const; ///< Test one pixel.
+    const UINT64 GetBits(size_t x, size_t y) const; ///< Get 64 pixels.
+    const bool AnySolid(size_t x0, size_t x1,
+      size_t y) const; ///< Test a span.
+    const size_t FindSolid(size_t x0, size_t x1,
+      size_t y) const; ///< Find first solid pixel in a span.
+    const size_t CountSolid(size_t x0, size_t x1,
+      size_t y) const; ///< Count solid pixels in a span.
+
+    const size_t GetWidth() const; ///< Get width in pixels.
+    const size_t GetHeight() const; ///< Get height in pixels.
+    const size_t GetStride() const; ///< Get words per row.
+    const UINT64* GetRow(size_t y) const; ///< Get a row of words.
+}; //CCollisionMap
+
+#endif //__COLLISIONMAP_H__
@@ -0,0 +1,366 @@
+/// \file CommandLine.cpp
+/// \brief Code for the command line tools.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <shellapi.h>
+
+#include "CommandLine.h"
+#include "WindowsHelpers.h"
+#include "ImageCompare.h"
+#include "JobServer.h"
+#include "SeedSearch.h"
+#include "LoadTest.h"
+#include "CollisionMap.h"
+#include "TileRecovery.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper functions
+
+#pragma region Helper functions
+
+/// Write a string to standard output. If the parent process did not redirect
+/// standard output then attach to its console, if it has one.
+/// \param s String to be written.
+
+static void Print(const std::string& s){
+  HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
+
+  if(h == nullptr || h == INVALID_HANDLE_VALUE){
+    AttachConsole(ATTACH_PARENT_PROCESS);
+    h = GetStdHandle(STD_OUTPUT_HANDLE);
+  } //if
+
+  if(h != nullptr && h != INVALID_HANDLE_VALUE){
+    DWORD n = 0; //number of bytes written
+    WriteFile(h, s.data(), DWORD(s.size()), &n, nullptr);
+  } //if
+} //Print
+
+/// Write the command line usage text to standard output.
+/// \return 1, the exit code for a malformed command line.
+
+static int Usage(){
+  Print("Usage: -compare a.png b.png [result.json]\n"
+    "       -serve [socket path]\n"
+    "       -seedsearch repetition|balance w h first count k"
+    " [result.json]\n"
+    "       -loadtest n w h [mix [ms [result.json]]]\n"
+    "       -collision folder w h seed result.pbm\n"
+    "       -recover image.png folder [result.json]\n");
+  return 1;
+} //Usage
+
+/// Write a string to a file if a file name is given, otherwise to standard
+/// output.
+/// \param s String to be written.
+/// \param filename File name, or nullptr for standard output.
+/// \return S_OK for success, E_FAIL for failure.
+
+static HRESULT Output(const std::string& s, LPCWSTR filename){
+  if(filename == nullptr){
+    Print(s);
+    return S_OK;
+  } //if
+
+  HANDLE h = CreateFileW(filename, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+    FILE_ATTRIBUTE_NORMAL, nullptr);
+  if(h == INVALID_HANDLE_VALUE)return E_FAIL;
+
+  DWORD n = 0; //number of bytes written
+  const BOOL ok = WriteFile(h, s.data(), DWORD(s.size()), &n, nullptr);
+  CloseHandle(h);
+
+  return ok && n == s.size()? S_OK: E_FAIL;
+} //Output
+
+#pragma endregion Helper functions
+
+///////////////////////////////////////////////////////////////////////////////
+// Commands
+
+#pragma region Commands
+
+/// Compare two image files and output PSNR, SSIM, and maximum absolute error
+/// as JSON. Usage: `-compare a.png b.png [result.json]`.
+/// \param argc Number of arguments after the command name.
+/// \param argv Arguments after the command name.
+/// \return 0 for success, 1 for failure.
+
+static int Compare(int argc, LPWSTR* argv){
+  if(argc < 2 || argc > 3)return Usage();
+
+  const ULONG_PTR token = InitGDIPlus();
+  CImageCompare result;
+  HRESULT hr = CompareImageFiles(argv[0], argv[1], result);
+
+  if(SUCCEEDED(hr))
+    hr = Output(result.GetJSON() + "\n", argc > 2? argv[2]: nullptr);
+
+  Gdiplus::GdiplusShutdown(token);
+  return SUCCEEDED(hr)? 0: 1;
+} //Compare
+
+/// Run the job server until a client asks it to shut down.
+/// Usage: `-serve [socket path]`.
+/// \param argc Number of arguments after the command name.
+/// \param argv Arguments after the command name.
+/// \return 0 for success, 1 for failure.
+
+static int Serve(int argc, LPWSTR* argv){
+  if(argc > 1)return Usage();
+
+  const std::wstring path = argc > 0? argv[0]: CJobServer::GetDefaultPath();
+  const ULONG_PTR token = InitGDIPlus();
+  CJobServer* pServer = new CJobServer;
+  const HRESULT hr = pServer->Listen(path);
+
+  if(SUCCEEDED(hr)){
+    char s[MAX_PATH*4] = {0}; //path in UTF-8
+    WideCharToMultiByte(CP_UTF8, 0, path.c_str(), -1, s, sizeof(s),
+      nullptr, nullptr);
+    Print(std::string("Serving on ") + s + "\n");
+
+    pServer->Run();
+  } //if
+
+  delete pServer; //before GDI+ shuts down, since it holds tile bitmaps
+  Gdiplus::GdiplusShutdown(token);
+  return SUCCEEDED(hr)? 0: 1;
+} //Serve
+
+/// Search a range of seeds for the Wang tilings that score best on a metric
+/// and output the best seeds and their scores as JSON. The metric is either
+/// `repetition` or `balance`.
+/// Usage: `-seedsearch metric w h first count k [result.json]`.
+/// \param argc Number of arguments after the command name.
+/// \param argv Arguments after the command name.
+/// \return 0 for success, 1 for failure.
+
+static int SeedSearch(int argc, LPWSTR* argv){
+  if(argc < 6 || argc > 7)return Usage();
+
+  CTilingMetric* pMetric = nullptr;
+
+  if(wcscmp(argv[0], L"repetition") == 0)
+    pMetric = new CRepetitionMetric;
+  else if(wcscmp(argv[0], L"balance") == 0)
+    pMetric = new CBalanceMetric;
+  else return Usage();
+
+  const size_t w = wcstoul(argv[1], nullptr, 10); //width
+  const size_t h = wcstoul(argv[2], nullptr, 10); //height
+  const UINT first = wcstoul(argv[3], nullptr, 10); //first seed
+  const UINT count = wcstoul(argv[4], nullptr, 10); //number of seeds
+  const size_t k = wcstoul(argv[5], nullptr, 10); //number to keep
+
+  HRESULT hr = E_FAIL;
+
+  if(w > 0 && h > 0){
+    CSeedSearch search(w, h, k);
+    hr = search.Run(first, count, *pMetric);
+
+    if(SUCCEEDED(hr))
+      hr = Output(search.GetJSON() + "\n", argc > 6? argv[6]: nullptr);
+  } //if
+
+  delete pMetric;
+  return SUCCEEDED(hr)? 0: 1;
+} //SeedSearch
+
+/// Run a concurrency scaling load test and output throughput and latency at
+/// each concurrency level as JSON. Rendering uses the default tile set. The
+/// mix is a comma-separated list of operations with weights, for example
+/// `generate:4,render:1,encode:1,query:4`, and defaults to equal weights.
+/// Usage: `-loadtest n w h [mix [ms [result.json]]]`.
+/// \param argc Number of arguments after the command name.
+/// \param argv Arguments after the command name.
+/// \return 0 for success, 1 for failure.
+
+static int LoadTest(int argc, LPWSTR* argv){
+  if(argc < 3 || argc > 6)return Usage();
+
+  const UINT n = wcstoul(argv[0], nullptr, 10); //maximum number of clients
+  const size_t w = wcstoul(argv[1], nullptr, 10); //width
+  const size_t h = wcstoul(argv[2], nullptr, 10); //height
+  if(n == 0 || w == 0 || h == 0)return 1;
+
+  const ULONG_PTR token = InitGDIPlus();
+  CTileCache* pCache = new CTileCache;
+  CTileSet* pTileSet = new CTileSet(pCache);
+  std::wstring filename; //name of file that failed to load
+
+  if(FAILED(pTileSet->Load(L"tiles\\default", 8, filename))){
+    delete pTileSet; //run without rendering
+    pTileSet = nullptr;
+  } //if
+
+  CLoadTest* pTest = new CLoadTest(pTileSet, w, h);
+  HRESULT hr = argc > 3? pTest->SetMix(argv[3]): S_OK;
+  if(argc > 4)pTest->SetDuration(wcstoul(argv[4], nullptr, 10));
+
+  if(SUCCEEDED(hr))hr = pTest->Run(n);
+  if(SUCCEEDED(hr))
+    hr = Output(pTest->GetJSON() + "\n", argc > 5? argv[5]: nullptr);
+
+  delete pTest;
+  delete pTileSet; //before the cache that holds its tiles
+  delete pCache;
+  Gdiplus::GdiplusShutdown(token);
+  return SUCCEEDED(hr)? 0: 1;
+} //LoadTest
+
+/// Bake the collision map of a Wang tiling from the collision masks of a tile
+/// set and write it as a binary PBM file, streaming it a few bands at a time.
+/// Usage: `-collision folder w h seed result.pbm`.
+/// \param argc Number of arguments after the command name.
+/// \param argv Arguments after the command name.
+/// \return 0 for success, 1 for failure.
+
+static int Collision(int argc, LPWSTR* argv){
+  if(argc != 5)return Usage();
+
+  const size_t w = wcstoul(argv[1], nullptr, 10); //width
+  const size_t h = wcstoul(argv[2], nullptr, 10); //height
+  const UINT seed = wcstoul(argv[3], nullptr, 10); //seed
+  if(w == 0 || h == 0)return 1;
+
+  const ULONG_PTR token = InitGDIPlus();
+  CTileCache* pCache = new CTileCache;
+  CTileSet* pTileSet = new CTileSet(pCache);
+  std::wstring filename; //name of file that failed to load
+  HRESULT hr = pTileSet->Load(argv[0], 8, filename);
+
+  if(SUCCEEDED(hr)){
+    CWangTiler* pTiler = new CWangTiler(w, h);
+    pTiler->Seed(seed);
+    pTiler->Generate();
+    hr = CCollisionMap::Stream(*pTiler, *pTileSet, argv[4]);
+    delete pTiler;
+  } //if
+
+  delete pTileSet; //before the cache that holds its tiles
+  delete pCache;
+  Gdiplus::GdiplusShutdown(token);
+  return SUCCEEDED(hr)? 0: 1;
+} //Collision
+
+/// Recover the tile indices of a Wang tiling from an image of it rendered
+/// with a tile set, and output them as JSON together with the number of
+/// cells that matched exactly, approximately, or not at all. The image must
+/// be a whole number of tiles wide and high.
+/// Usage: `-recover image.png folder [result.json]`.
+/// \param argc Number of arguments after the command name.
+/// \param argv Arguments after the command name.
+/// \return 0 if every cell matched a tile, 1 otherwise.
+
+static int Recover(int argc, LPWSTR* argv){
+  if(argc < 2 || argc > 3)return Usage();
+
+  const ULONG_PTR token = InitGDIPlus();
+  CTileCache* pCache = new CTileCache;
+  CTileSet* pTileSet = new CTileSet(pCache);
+  std::wstring filename; //name of file that failed to load
+  HRESULT hr = pTileSet->Load(argv[1], 8, filename);
+
+  Gdiplus::Bitmap* pBitmap = Gdiplus::Bitmap::FromFile(argv[0]);
+  std::vector<UINT> v; //pixels
+
+  if(SUCCEEDED(hr) && (pBitmap == nullptr ||
+    pBitmap->GetLastStatus() != Gdiplus::Ok ||
+    FAILED(GetPixels(pBitmap, v))))hr = E_FAIL;
+
+  if(SUCCEEDED(hr)){
+    const UINT w = pBitmap->GetWidth(), h = pBitmap->GetHeight();
+    const UINT tw = pTileSet->GetTileWidth(), th = pTileSet->GetTileHeight();
+
+    if(w == 0 || h == 0 || w%tw != 0 || h%th != 0)hr = E_FAIL;
+
+    else{
+      CWangTiler* pTiler = new CWangTiler(w/tw, h/th);
+      CTileRecovery recovery(pTileSet);
+      hr = recovery.Recover(v, w, h, *pTiler);
+
+      const HRESULT hrOut = Output(recovery.GetJSON(*pTiler) + "\n",
+        argc > 2? argv[2]: nullptr);
+      if(FAILED(hrOut))hr = hrOut;
+      delete pTiler;
+    } //else
+  } //if
+
+  delete pBitmap;
+  delete pTileSet; //before the cache that holds its tiles
+  delete pCache;
+  Gdiplus::GdiplusShutdown(token);
+  return SUCCEEDED(hr)? 0: 1;
+} //Recover
+
+#pragma endregion Commands
+
+///////////////////////////////////////////////////////////////////////////////
+// Command line
+
+#pragma region Command line
+
+/// Run a command line tool if the first command line argument names one.
+/// If the first argument starts with a hyphen but names no tool then print
+/// the usage text instead. Otherwise do nothing so that the application
+/// runs normally.
+/// \param nExitCode [OUT] Exit code from the command line tool, if any.
+/// \return true if a command line tool was run.
+
+bool RunCommandLine(int& nExitCode){
+  int argc = 0; //number of arguments
+  LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc); //arguments
+  bool bCommand = true; //whether there was a command
+
+  if(argv == nullptr || argc < 2)bCommand = false;
+
+  else if(wcscmp(argv[1], L"-compare") == 0)
+    nExitCode = Compare(argc - 2, argv + 2);
+
+  else if(wcscmp(argv[1], L"-serve") == 0)
+    nExitCode = Serve(argc - 2, argv + 2);
+
+  else if(wcscmp(argv[1], L"-seedsearch") == 0)
+    nExitCode = SeedSearch(argc - 2, argv + 2);
+
+  else if(wcscmp(argv[1], L"-loadtest") == 0)
+    nExitCode = LoadTest(argc - 2, argv + 2);
+
+  else if(wcscmp(argv[1], L"-collision") == 0)
+    nExitCode = Collision(argc - 2, argv + 2);
+
+  else if(wcscmp(argv[1], L"-recover") == 0)
+    nExitCode = Recover(argc - 2, argv + 2);
+
+  else if(argv[1][0] == L'-') //unknown command
+    nExitCode = Usage();
+
+  else bCommand = false; //not a command, eg. a file from the shell
+
+  LocalFree(argv);
+  return bCommand;
+} //RunCommandLine
+
+#pragma endregion Command line
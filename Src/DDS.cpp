@@ -0,0 +1,107 @@
+/// \file DDS.cpp
+/// \brief Code for the DDS file header functions.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "DDS.h"
+
+/// Write a little-endian 32-bit unsigned integer to a stream.
+/// \param s Output stream.
+/// \param n Value to be written.
+
+static void Write32(std::ostream& s, UINT n){
+  const char b[4] = {char(n), char(n >> 8), char(n >> 16), char(n >> 24)};
+  s.write(b, 4);
+} //Write32
+
+/// Write the magic number, a `DDS_HEADER`, and a `DDS_HEADER_DXT10` to a
+/// stream. The pixel format always uses the `DX10` four-character code so that
+/// block-compressed formats and texture arrays are handled the same way. The
+/// pitch or linear size field is filled in only if it fits in 32 bits, which
+/// readers are allowed to ignore anyway.
+/// \param s Output stream, which must be opened in binary mode.
+/// \param w Width in pixels.
+/// \param h Height in pixels.
+/// \param fmt DXGI format code, one of the `DDS_FORMAT_*` values.
+/// \param nMips Number of mip levels.
+/// \param nArraySize Number of array elements.
+/// \return S_OK if the header was written, E_FAIL otherwise.
+
+HRESULT WriteDDSHeader(std::ostream& s, UINT w, UINT h, UINT fmt,
+  UINT nMips, UINT nArraySize)
+{
+  const bool bCompressed = fmt == DDS_FORMAT_BC1 || fmt == DDS_FORMAT_BC7;
+  const UINT64 nBlockSize = fmt == DDS_FORMAT_BC1? 8: 16; //bytes per block
+
+  const UINT64 nSize = bCompressed? //size of top mip level in bytes
+    nBlockSize*((w + 3)/4)*((h + 3)/4): UINT64(4)*w*h;
+
+  DWORD dwFlags = 0x1 | 0x2 | 0x4 | 0x1000; //caps, height, width, pixelformat
+  if(nMips > 1)dwFlags |= 0x20000; //mipmap count
+  dwFlags |= bCompressed? 0x80000: 0x8; //linear size or pitch
+
+  DWORD dwCaps = 0x1000; //texture
+  if(nMips > 1)dwCaps |= 0x8 | 0x400000; //complex, mipmap
+  if(nArraySize > 1)dwCaps |= 0x8; //complex
+
+  const UINT64 nPitch = bCompressed? nSize: UINT64(4)*w;
+
+  s.write("DDS ", 4); //magic number
+
+  //DDS_HEADER
+
+  Write32(s, 124); //header size
+  Write32(s, dwFlags);
+  Write32(s, h);
+  Write32(s, w);
+  Write32(s, nPitch > 0xFFFFFFFF? 0: UINT(nPitch));
+  Write32(s, 0); //depth
+  Write32(s, nMips);
+
+  for(int i=0; i<11; i++)
+    Write32(s, 0); //reserved
+
+  //DDS_PIXELFORMAT
+
+  Write32(s, 32); //pixel format size
+  Write32(s, 0x4); //four-character code is valid
+  s.write("DX10", 4);
+
+  for(int i=0; i<5; i++)
+    Write32(s, 0); //bit count and masks
+
+  Write32(s, dwCaps);
+
+  for(int i=0; i<4; i++)
+    Write32(s, 0); //caps2, caps3, caps4, reserved
+
+  //DDS_HEADER_DXT10
+
+  Write32(s, fmt); //DXGI format
+  Write32(s, 3); //2D texture
+  Write32(s, 0); //misc flags
+  Write32(s, nArraySize);
+  Write32(s, 0); //alpha mode unknown
+
+  return s.good()? S_OK: E_FAIL;
+} //WriteDDSHeader
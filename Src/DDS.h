@@ -0,0 +1,53 @@
+/// \file DDS.h
+/// \brief Interface for the DDS file header functions.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef __DDS_H__
+#define __DDS_H__
+
+#include "Windows.h"
+#include <ostream>
+
+///////////////////////////////////////////////////////////////////////////////
+// DXGI formats
+
+#pragma region DXGI formats
+
+#define DDS_FORMAT_BC1 71 ///< DXGI format code for BC1.
+#define DDS_FORMAT_BGRA 87 ///< DXGI format code for 32-bit BGRA.
+#define DDS_FORMAT_BC7 98 ///< DXGI format code for BC7.
+
+#pragma endregion DXGI formats
+
+///////////////////////////////////////////////////////////////////////////////
+// DDS functions
+
+#pragma region DDS functions
+
+HRESULT WriteDDSHeader(std::ostream& s, UINT w, UINT h, UINT fmt,
+  UINT nMips=1, UINT nArraySize=1); ///< Write DDS header.
+
+#pragma endregion DDS functions
+
+#endif //__DDS_H__
@@ -0,0 +1,248 @@
+/// \file EdgeInference.cpp
+/// \brief Code for CEdgeInference.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "EdgeInference.h"
+#include "Helpers.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructors and destructors
+
+#pragma region Constructors and destructors
+
+/// \param depth Strip depth in pixels.
+
+CEdgeInference::CEdgeInference(UINT depth):
+  m_nDepth(max(1U, depth)){
+} //constructor
+
+#pragma endregion Constructors and destructors
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper functions
+
+#pragma region Helper functions
+
+/// Split strips of pixels into two clusters around two medoids. The medoids
+/// start out as the two strips furthest apart, then each strip is put in the
+/// cluster of the nearer medoid, and each medoid is moved to the strip with
+/// the smallest total distance to the others in its cluster, until nothing
+/// changes. The distances between all pairs of strips are computed once up
+/// front, since there are only a few strips.
+/// \param strips Strips of the same length.
+/// \param label [OUT] Cluster, 0 or 1, of each strip.
+/// \return true if both clusters are nonempty.
+
+bool CEdgeInference::Cluster(const std::vector<std::vector<UINT>>& strips,
+  std::vector<UINT>& label) const
+{
+  const size_t n = strips.size();
+  std::vector<UINT64> d(n*n, 0); //distances
+
+  for(size_t a=0; a<n; a++)
+    for(size_t b=a + 1; b<n; b++)
+      d[a*n + b] = d[b*n + a] = SumAbsDiff(strips[a].data(), strips[b].data(),
+        strips[a].size());
+
+  size_t m[2] = {0, 0}; //medoids
+
+  for(size_t a=0; a<n; a++) //furthest pair
+    for(size_t b=a + 1; b<n; b++)
+      if(d[a*n + b] > d[m[0]*n + m[1]]){
+        m[0] = a;
+        m[1] = b;
+      } //if
+
+  if(m[0] == m[1])return false; //all strips identical
+
+  label.assign(n, 0);
+
+  for(UINT iter=0; iter<16; iter++){
+    for(size_t a=0; a<n; a++)
+      label[a] = d[a*n + m[1]] < d[a*n + m[0]]? 1: 0;
+
+    bool changed = false;
+
+    for(UINT c=0; c<2; c++){
+      UINT64 best = UINT64(-1); //smallest total distance
+      size_t medoid = m[c];
+
+      for(size_t a=0; a<n; a++)
+        if(label[a] == c){
+          UINT64 total = 0;
+
+          for(size_t b=0; b<n; b++)
+            if(label[b] == c)total += d[a*n + b];
+
+          if(total < best){
+            best = total;
+            medoid = a;
+          } //if
+        } //if
+
+      changed = changed || medoid != m[c];
+      m[c] = medoid;
+    } //for
+
+    if(!changed)break;
+  } //for
+
+  return label[m[0]] == 0 && label[m[1]] == 1;
+} //Cluster
+
+/// Number the clusters of one set of strips to match the clusters of the
+/// strips they meet across an edge. The mean distance between strips that
+/// would meet is compared for the two possible pairings, and the labels of
+/// the second set are swapped if that makes it smaller.
+/// \param a Strips along one edge, such as the top edges.
+/// \param alabel Cluster of each strip in `a`.
+/// \param b Strips along the opposite edge, nearest the edge first.
+/// \param blabel [IN, OUT] Cluster of each strip in `b`.
+
+void CEdgeInference::Pair(const std::vector<std::vector<UINT>>& a,
+  const std::vector<UINT>& alabel, const std::vector<std::vector<UINT>>& b,
+  std::vector<UINT>& blabel) const
+{
+  double sum[2] = {0, 0}; //total distance, same and swapped
+  size_t count[2] = {0, 0}; //number of pairs, same and swapped
+
+  for(size_t i=0; i<b.size(); i++)
+    for(size_t j=0; j<a.size(); j++){
+      const UINT k = blabel[i] ^ alabel[j]; //0 if same, 1 if swapped
+      sum[k] += double(SumAbsDiff(b[i].data(), a[j].data(), b[i].size()));
+      count[k]++;
+    } //for
+
+  if(count[0] > 0 && count[1] > 0 && sum[1]/count[1] < sum[0]/count[0])
+    for(UINT& x: blabel)
+      x ^= 1;
+} //Pair
+
+#pragma endregion Helper functions
+
+///////////////////////////////////////////////////////////////////////////////
+// Inference
+
+#pragma region Inference
+
+/// Infer the edge colors of a set of 8 Wang tiles. Strips are taken with the
+/// row or column nearest the edge first, so that the bottom strip of one
+/// tile is compared with the top strip of another as mirror images across
+/// the edge between them. The colors in each direction are numbered so that
+/// the first image has top and left color 0, which means that a folder that
+/// is already in the right order keeps its order.
+/// \param tiles Tiles, all of the same size.
+/// \return S_OK if the tiles form a complete Wang tile set, E_FAIL otherwise.
+
+HRESULT CEdgeInference::Infer(const std::vector<CTile*>& tiles){
+  m_vCode.clear();
+  m_vOrder.clear();
+
+  const size_t n = tiles.size();
+  if(n != 8)return E_FAIL;
+
+  const UINT w = tiles[0]->GetWidth(), h = tiles[0]->GetHeight();
+  const UINT depth = min(m_nDepth, min(w, h)/2); //strip depth
+  if(depth == 0)return E_FAIL;
+
+  for(const CTile* p: tiles)
+    if(p->GetWidth() != w || p->GetHeight() != h)return E_FAIL;
+
+  std::vector<std::vector<UINT>> strip[4]; //top, left, bottom, right strips
+
+  for(UINT e=0; e<4; e++)
+    strip[e].resize(n);
+
+  for(size_t t=0; t<n; t++){
+    const UINT* p = tiles[t]->GetPixels().data();
+
+    for(UINT k=0; k<depth; k++){
+      strip[0][t].insert(strip[0][t].end(), p + size_t(k)*w,
+        p + size_t(k + 1)*w);
+      strip[2][t].insert(strip[2][t].end(), p + size_t(h - 1 - k)*w,
+        p + size_t(h - k)*w);
+
+      for(UINT i=0; i<h; i++){
+        strip[1][t].push_back(p[size_t(i)*w + k]);
+        strip[3][t].push_back(p[size_t(i)*w + w - 1 - k]);
+      } //for
+    } //for
+  } //for
+
+  std::vector<UINT> label[4]; //edge colors of top, left, bottom, right
+
+  for(UINT e=0; e<4; e++)
+    if(!Cluster(strip[e], label[e]))return E_FAIL;
+
+  for(UINT e=0; e<2; e++){
+    if(label[e][0] == 1) //make image 0 top left color 0
+      for(UINT& x: label[e])
+        x ^= 1;
+
+    Pair(strip[e], label[e], strip[e + 2], label[e + 2]);
+  } //for
+
+  m_vOrder.assign(n, UINT(n));
+
+  for(size_t t=0; t<n; t++){
+    const UINT top = label[0][t], left = label[1][t];
+    const UINT parity = top ^ label[2][t];
+    const UINT code = top << 2 | left << 1 | parity;
+
+    if((left ^ label[3][t]) != parity || m_vOrder[code] != n){ //not Wang tiles
+      m_vCode.clear();
+      m_vOrder.clear();
+      return E_FAIL;
+    } //if
+
+    m_vCode.push_back(code);
+    m_vOrder[code] = UINT(t);
+  } //for
+
+  return S_OK;
+} //Infer
+
+#pragma endregion Inference
+
+///////////////////////////////////////////////////////////////////////////////
+// Reader functions
+
+#pragma region Reader functions
+
+/// Reader function for the inferred tile indices. `Infer()` must have
+/// succeeded first.
+/// \return Inferred tile index for each image.
+
+const std::vector<UINT>& CEdgeInference::GetCodes() const{
+  return m_vCode;
+} //GetCodes
+
+/// Reader function for the image order. `Infer()` must have succeeded first.
+/// \return Image to use for each tile index.
+
+const std::vector<UINT>& CEdgeInference::GetOrder() const{
+  return m_vOrder;
+} //GetOrder
+
+#pragma endregion Reader functions
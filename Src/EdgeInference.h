@@ -0,0 +1,69 @@
+/// \file EdgeInference.h
+/// \brief Interface for CEdgeInference.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef __EDGEINFERENCE_H__
+#define __EDGEINFERENCE_H__
+
+#include "Includes.h"
+#include "TileCache.h"
+
+/// \brief Edge color inference.
+///
+/// The Wang tiler assumes that tile `t` has the edge colors encoded in the
+/// bits of `t`, so the images in a tile folder have to be numbered to match.
+/// Edge color inference works the colors out from the images instead. It
+/// takes a strip of pixels along each edge of each tile and splits the top
+/// strips into two clusters by their sum of absolute differences, and
+/// likewise the bottom, left, and right strips. Strips along edges of the
+/// same color are nearly identical, so each cluster is an edge color. The
+/// bottom clusters are then paired with the top clusters, and the right
+/// clusters with the left clusters, so that strips that meet across an edge
+/// are as similar as possible. If every tile then has a consistent parity
+/// and no two tiles have the same colors, the result is the order in which
+/// the images must be used for the Wang tiler's indices.
+
+class CEdgeInference{
+  private:
+    UINT m_nDepth = 2; ///< Strip depth in pixels.
+
+    std::vector<UINT> m_vCode; ///< Inferred tile index for each image.
+    std::vector<UINT> m_vOrder; ///< Image for each tile index.
+
+    bool Cluster(const std::vector<std::vector<UINT>>& strips,
+      std::vector<UINT>& label) const; ///< Split strips into two clusters.
+    void Pair(const std::vector<std::vector<UINT>>& a,
+      const std::vector<UINT>& alabel, const std::vector<std::vector<UINT>>& b,
+      std::vector<UINT>& blabel) const; ///< Pair up clusters across an edge.
+
+  public:
+    CEdgeInference(UINT depth=2); ///< Constructor.
+
+    HRESULT Infer(const std::vector<CTile*>& tiles); ///< Infer edge colors.
+
+    const std::vector<UINT>& GetCodes() const; ///< Get tile index per image.
+    const std::vector<UINT>& GetOrder() const; ///< Get image per tile index.
+}; //CEdgeInference
+
+#endif //__EDGEINFERENCE_H__
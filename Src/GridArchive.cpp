@@ -0,0 +1,280 @@
+/// \file GridArchive.cpp
+/// \brief Code for CGridArchive.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <fstream>
+#include <iterator>
+
+#include "GridArchive.h"
+#include "Helpers.h"
+#include "ThreadPool.h"
+
+/// A grid archive file starts with the 4 bytes `WGRA`, then the saved
+/// dictionary, then the number of grids, then the width, height, and
+/// compressed size of each grid, and finally the compressed grids back to
+/// back. All of the numbers after the dictionary are unsigned LEB128
+/// varints, so the index costs about 4 bytes per grid.
+
+static const BYTE g_nMagic[4] = {'W', 'G', 'R', 'A'}; ///< Magic number.
+
+///////////////////////////////////////////////////////////////////////////////
+// Build
+
+#pragma region Build
+
+/// Train the dictionary on a sample of grids. This must be done before any
+/// grids are added, since they are compressed with the dictionary as they
+/// are added.
+/// \param v Sample grids.
+/// \return S_OK for success, E_FAIL if there are already grids in the
+/// archive or a sample has a tile index that is not a Wang tile.
+
+HRESULT CGridArchive::Train(const std::vector<const CWangTiler*>& v){
+  if(!m_vEntry.empty())return E_FAIL;
+  return m_cDictionary.Train(v);
+} //Train
+
+/// Compress a grid with the dictionary and add it to the end of the archive.
+/// \param t Grid.
+/// \return S_OK for success, E_FAIL if the grid is empty or too large, or
+/// has a tile index that is not a Wang tile.
+
+HRESULT CGridArchive::Add(const CWangTiler& t){
+  const size_t w = t.GetWidth(), h = t.GetHeight();
+  if(w == 0 || h == 0 || w > 0xFFFF || h > 0xFFFF)return E_FAIL;
+
+  std::vector<BYTE> v; //compressed grid
+
+  if(FAILED(m_cDictionary.Compress(t.GetRow(0), UINT(w), UINT(h), v)))
+    return E_FAIL;
+
+  SGridEntry e;
+  e.m_nOffset = m_vData.size();
+  e.m_nCell = m_vEntry.empty()? 0: m_vEntry.back().m_nCell +
+    UINT64(m_vEntry.back().m_nWidth)*m_vEntry.back().m_nHeight;
+  e.m_nSize = UINT(v.size());
+  e.m_nWidth = UINT(w);
+  e.m_nHeight = UINT(h);
+
+  m_vEntry.push_back(e);
+  m_vData.insert(m_vData.end(), v.begin(), v.end());
+
+  return S_OK;
+} //Add
+
+/// Remove all grids, keeping the dictionary.
+
+void CGridArchive::Clear(){
+  m_vEntry.clear();
+  m_vData.clear();
+} //Clear
+
+#pragma endregion Build
+
+///////////////////////////////////////////////////////////////////////////////
+// Save and load
+
+#pragma region Save and load
+
+/// Save the archive to a file.
+/// \param filename Name of the file.
+/// \return S_OK for success, E_FAIL for failure.
+
+HRESULT CGridArchive::Save(const std::wstring& filename) const{
+  std::vector<BYTE> v(g_nMagic, g_nMagic + 4); //everything but the grids
+
+  m_cDictionary.Save(v);
+  PutVarint(v, m_vEntry.size());
+
+  for(const SGridEntry& e: m_vEntry){
+    PutVarint(v, e.m_nWidth);
+    PutVarint(v, e.m_nHeight);
+    PutVarint(v, e.m_nSize);
+  } //for
+
+  std::ofstream s(filename, std::ios::binary);
+  if(!s.is_open())return E_FAIL;
+
+  s.write((const char*)v.data(), v.size());
+  s.write((const char*)m_vData.data(), m_vData.size());
+
+  return s.good()? S_OK: E_FAIL;
+} //Save
+
+/// Load an archive from a file, replacing the dictionary and any grids
+/// already in this archive. The index is checked against the size of the
+/// file, but the grids themselves are only checked as they are
+/// decompressed.
+/// \param filename Name of the file.
+/// \return S_OK for success, E_FAIL if the file cannot be read or is not a
+/// grid archive, in which case this archive is left empty.
+
+HRESULT CGridArchive::Load(const std::wstring& filename){
+  Clear();
+
+  std::ifstream s(filename, std::ios::binary);
+  if(!s.is_open())return E_FAIL;
+
+  const std::vector<BYTE> v((std::istreambuf_iterator<char>(s)),
+    std::istreambuf_iterator<char>()); //file contents
+
+  const BYTE* p = v.data();
+  const BYTE* end = p + v.size();
+  const size_t k = CGridDictionary::GetSaveSize(); //dictionary size
+
+  if(v.size() < 4 + k || memcmp(p, g_nMagic, 4) != 0 ||
+    FAILED(m_cDictionary.Load(p + 4, k)))return E_FAIL;
+
+  p += 4 + k;
+
+  UINT64 n = 0; //number of grids
+  if(!GetVarint(p, end, n) || n > UINT64(end - p)/3)return E_FAIL;
+
+  m_vEntry.resize(size_t(n));
+  UINT64 offset = 0, cell = 0; //running totals
+
+  for(SGridEntry& e: m_vEntry){
+    UINT64 w = 0, h = 0, size = 0;
+
+    if(!GetVarint(p, end, w) || !GetVarint(p, end, h) ||
+      !GetVarint(p, end, size) || w == 0 || h == 0 || w > 0xFFFF ||
+      h > 0xFFFF || size > 0xFFFFFFFF)
+    {
+      Clear();
+      return E_FAIL;
+    } //if
+
+    e.m_nOffset = offset;
+    e.m_nCell = cell;
+    e.m_nSize = UINT(size);
+    e.m_nWidth = UINT(w);
+    e.m_nHeight = UINT(h);
+
+    offset += size;
+    cell += w*h;
+  } //for
+
+  if(offset != UINT64(end - p)){
+    Clear();
+    return E_FAIL;
+  } //if
+
+  m_vData.assign(p, end);
+  return S_OK;
+} //Load
+
+#pragma endregion Save and load
+
+///////////////////////////////////////////////////////////////////////////////
+// Extraction
+
+#pragma region Extraction
+
+/// Decompress one grid into a tiling of the same size.
+/// \param i Grid index.
+/// \param t [OUT] Tiling, which must be the size of the grid.
+/// \return S_OK for success, E_FAIL if there is no such grid, the tiling is
+/// the wrong size, or the grid is corrupt.
+
+HRESULT CGridArchive::Extract(size_t i, CWangTiler& t) const{
+  if(i >= m_vEntry.size())return E_FAIL;
+
+  const SGridEntry& e = m_vEntry[i];
+  if(t.GetWidth() != e.m_nWidth || t.GetHeight() != e.m_nHeight)
+    return E_FAIL;
+
+  return m_cDictionary.Decompress(m_vData.data() + e.m_nOffset, e.m_nSize,
+    e.m_nWidth, e.m_nHeight, t.GetRow(0));
+} //Extract
+
+/// Decompress a batch of consecutive grids into one buffer, in parallel on
+/// the thread pool. The cells of each grid are in row-major order, and those
+/// of grid `first + k` start at index `GetEntry(first + k).m_nCell` minus
+/// `GetEntry(first).m_nCell`. Passing the same buffer in for each batch means
+/// that decompressing a long run of batches allocates almost nothing.
+/// \param first Index of the first grid.
+/// \param n Number of grids.
+/// \param v [OUT] Cells of the grids, resized to fit.
+/// \return S_OK for success, E_FAIL if there are not that many grids or any
+/// of them is corrupt.
+
+HRESULT CGridArchive::Extract(size_t first, size_t n,
+  std::vector<UINT>& v) const
+{
+  if(n == 0 || first >= m_vEntry.size() || n > m_vEntry.size() - first)
+    return E_FAIL;
+
+  const SGridEntry& last = m_vEntry[first + n - 1];
+  const UINT64 base = m_vEntry[first].m_nCell; //first cell of batch
+
+  v.resize(size_t(last.m_nCell - base) + size_t(last.m_nWidth)*last.m_nHeight);
+  std::vector<BYTE> ok(n, 0); //whether each grid decompressed
+
+  CThreadPool::GetInstance().ParallelFor(n, 64, [&](size_t i0, size_t i1){
+    for(size_t k=i0; k<i1; k++){
+      const SGridEntry& e = m_vEntry[first + k];
+
+      ok[k] = SUCCEEDED(m_cDictionary.Decompress(
+        m_vData.data() + e.m_nOffset, e.m_nSize, e.m_nWidth, e.m_nHeight,
+        &v[size_t(e.m_nCell - base)]));
+    } //for
+  }); //ParallelFor
+
+  for(BYTE b: ok)
+    if(!b)return E_FAIL;
+
+  return S_OK;
+} //Extract
+
+#pragma endregion Extraction
+
+///////////////////////////////////////////////////////////////////////////////
+// Reader functions
+
+#pragma region Reader functions
+
+/// Get the number of grids.
+/// \return Number of grids.
+
+const size_t CGridArchive::GetSize() const{
+  return m_vEntry.size();
+} //GetSize
+
+/// Get the index entry for a grid.
+/// \param i Grid index, which must be less than `GetSize()`.
+/// \return Index entry.
+
+const SGridEntry& CGridArchive::GetEntry(size_t i) const{
+  return m_vEntry[i];
+} //GetEntry
+
+/// Get the total size of the compressed grids, not counting the dictionary
+/// and index.
+/// \return Size in bytes.
+
+const size_t CGridArchive::GetDataSize() const{
+  return m_vData.size();
+} //GetDataSize
+
+#pragma endregion Reader functions
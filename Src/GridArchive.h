@@ -0,0 +1,81 @@
+/// \file GridArchive.h
+/// \brief Interface for CGridArchive.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef __GRIDARCHIVE_H__
+#define __GRIDARCHIVE_H__
+
+#include "Windows.h"
+#include <string>
+#include <vector>
+
+#include "GridDictionary.h"
+
+/// \brief Grid archive entry.
+///
+/// Where to find one compressed grid in an archive, and where its cells go
+/// when a batch of grids is decompressed into one buffer.
+
+struct SGridEntry{
+  UINT64 m_nOffset = 0; ///< Offset of compressed grid in archive data.
+  UINT64 m_nCell = 0; ///< Number of cells in all earlier grids.
+  UINT m_nSize = 0; ///< Size of compressed grid in bytes.
+  UINT m_nWidth = 0; ///< Grid width.
+  UINT m_nHeight = 0; ///< Grid height.
+}; //SGridEntry
+
+/// \brief Archive of many small grids.
+///
+/// A grid archive holds any number of small Wang tilings, each compressed
+/// on its own with a dictionary trained on a sample of them, so that any
+/// one grid can be decompressed without touching the others. The dictionary
+/// is stored once at the start of the archive, where a generic compressor
+/// would have to relearn the same statistics for every grid. Decompression
+/// is const and thread-safe, and a batch of consecutive grids can be
+/// decompressed in parallel into one reusable buffer.
+
+class CGridArchive{
+  private:
+    CGridDictionary m_cDictionary; ///< Dictionary.
+    std::vector<SGridEntry> m_vEntry; ///< Index of grids.
+    std::vector<BYTE> m_vData; ///< Compressed grids, back to back.
+
+  public:
+    HRESULT Train(const std::vector<const CWangTiler*>& v); ///< Train.
+    HRESULT Add(const CWangTiler& t); ///< Compress and add grid.
+    void Clear(); ///< Remove all grids.
+
+    HRESULT Save(const std::wstring& filename) const; ///< Save to file.
+    HRESULT Load(const std::wstring& filename); ///< Load from file.
+
+    HRESULT Extract(size_t i, CWangTiler& t) const; ///< Decompress grid.
+    HRESULT Extract(size_t first, size_t n,
+      std::vector<UINT>& v) const; ///< Decompress batch of grids.
+
+    const size_t GetSize() const; ///< Get number of grids.
+    const SGridEntry& GetEntry(size_t i) const; ///< Get index entry.
+    const size_t GetDataSize() const; ///< Get compressed size.
+}; //CGridArchive
+
+#endif //__GRIDARCHIVE_H__
@@ -0,0 +1,203 @@
+/// \file GridDelta.cpp
+/// \brief Code for Wang tiling deltas.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <emmintrin.h>
+
+#include "GridDelta.h"
+#include "Helpers.h"
+
+/// A delta between two Wang tilings of the same size lists the cells that
+/// differ as spans in row-major order. It starts with the 4 bytes `WDIF`,
+/// then the width, height, and number of changed cells. Each span is the
+/// number of unchanged cells since the end of the previous span, the number
+/// of changed cells in it, and then for each changed cell the exclusive-or
+/// of its old and new tile indices. All of these numbers are unsigned
+/// LEB128 varints, so a Wang tile change costs one byte. Since the delta is
+/// an exclusive-or, applying it to either tiling gives the other one.
+
+static const BYTE g_nMagic[4] = {'W', 'D', 'I', 'F'}; ///< Magic number.
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper functions
+
+#pragma region Helper functions
+
+/// Find the first cell at or after a given column where two rows differ.
+/// Four cells at a time are compared using SSE2.
+/// \param a Row of first tiling.
+/// \param b Row of second tiling.
+/// \param j Column to start at.
+/// \param w Row width.
+/// \return Column of first difference, or `w` if there is none.
+
+static size_t FindDiff(const UINT* a, const UINT* b, size_t j, size_t w){
+  for(; j+4<=w; j+=4){
+    const __m128i eq = _mm_cmpeq_epi32(
+      _mm_loadu_si128((const __m128i*)(a + j)),
+      _mm_loadu_si128((const __m128i*)(b + j)));
+
+    if(_mm_movemask_epi8(eq) != 0xFFFF)break; //difference in these 4
+  } //for
+
+  while(j < w && a[j] == b[j])
+    j++;
+
+  return j;
+} //FindDiff
+
+/// Apply spans to a Wang tiling, stopping after a given number of cells or
+/// at the first malformed span. The row and column are tracked as cells are
+/// changed, so there is no division per cell.
+/// \param t [IN, OUT] Tiling.
+/// \param p Pointer to the first span.
+/// \param end Pointer past the last span.
+/// \param limit Maximum number of cells to change.
+/// \param applied [OUT] Number of cells changed.
+/// \return true if every span was well-formed.
+
+static bool ApplySpans(CWangTiler& t, const BYTE* p, const BYTE* end,
+  UINT64 limit, UINT64& applied)
+{
+  const size_t w = t.GetWidth();
+  const UINT64 cells = UINT64(w)*t.GetHeight(); //number of cells
+  UINT64 pos = 0; //cell index
+  applied = 0;
+
+  while(p < end && applied < limit){
+    UINT64 skip = 0, n = 0;
+
+    if(!GetVarint(p, end, skip) || !GetVarint(p, end, n) ||
+      skip > cells - pos || n > cells - pos - skip)return false;
+
+    pos += skip;
+
+    size_t i = size_t(pos/w), j = size_t(pos%w); //row and column
+    UINT* row = n > 0? t.GetRow(i): nullptr; //current row
+
+    for(UINT64 k=0; k<n && applied<limit; k++){
+      UINT64 x = 0;
+      if(!GetVarint(p, end, x) || x > 0xFFFFFFFF)return false;
+
+      row[j] ^= UINT(x);
+      applied++;
+
+      if(++j == w && k + 1 < n){ //next row
+        j = 0;
+        row = t.GetRow(++i);
+      } //if
+    } //for
+
+    pos += n;
+  } //while
+
+  return true;
+} //ApplySpans
+
+#pragma endregion Helper functions
+
+///////////////////////////////////////////////////////////////////////////////
+// Diff and patch
+
+#pragma region Diff and patch
+
+/// Make a delta that turns one Wang tiling into another of the same size.
+/// \param a First tiling.
+/// \param b Second tiling.
+/// \param delta [OUT] Delta.
+/// \return S_OK for success, E_FAIL if the tilings are different sizes.
+
+HRESULT DiffTilings(const CWangTiler& a, const CWangTiler& b,
+  std::vector<BYTE>& delta)
+{
+  const size_t w = a.GetWidth(), h = a.GetHeight();
+  if(b.GetWidth() != w || b.GetHeight() != h)return E_FAIL;
+
+  std::vector<BYTE> spans; //spans, written after the header
+  size_t last = 0; //cell index just after the previous span
+  size_t changed = 0; //number of changed cells
+
+  for(size_t i=0; i<h; i++){
+    const UINT* pa = a.GetRow(i);
+    const UINT* pb = b.GetRow(i);
+
+    for(size_t j=FindDiff(pa, pb, 0, w); j<w; j=FindDiff(pa, pb, j, w)){
+      size_t k = j + 1; //end of span
+      while(k < w && pa[k] != pb[k])k++;
+
+      PutVarint(spans, i*w + j - last);
+      PutVarint(spans, k - j);
+      changed += k - j;
+
+      for(; j<k; j++)
+        PutVarint(spans, pa[j] ^ pb[j]);
+
+      last = i*w + k;
+    } //for
+  } //for
+
+  delta.assign(g_nMagic, g_nMagic + 4);
+  PutVarint(delta, w);
+  PutVarint(delta, h);
+  PutVarint(delta, changed);
+  delta.insert(delta.end(), spans.begin(), spans.end());
+
+  return S_OK;
+} //DiffTilings
+
+/// Apply a delta to a Wang tiling. The delta is checked as it is read, and
+/// if it turns out to be malformed then the changes already made are undone,
+/// so the tiling is either fully patched or left as it was.
+/// \param t [IN, OUT] Tiling.
+/// \param delta Delta from `DiffTilings()`.
+/// \return S_OK for success, E_FAIL if the delta is malformed or is for a
+/// tiling of a different size.
+
+HRESULT PatchTiling(CWangTiler& t, const std::vector<BYTE>& delta){
+  const BYTE* p = delta.data();
+  const BYTE* end = p + delta.size();
+
+  if(delta.size() < 4 || memcmp(p, g_nMagic, 4) != 0)return E_FAIL;
+  p += 4;
+
+  UINT64 w = 0, h = 0, changed = 0;
+
+  if(!GetVarint(p, end, w) || !GetVarint(p, end, h) ||
+    !GetVarint(p, end, changed))return E_FAIL;
+
+  if(w != t.GetWidth() || h != t.GetHeight())return E_FAIL;
+
+  UINT64 applied = 0; //number of cells changed
+  const bool ok = ApplySpans(t, p, end, changed, applied) &&
+    applied == changed;
+
+  if(!ok){ //undo by applying the same cells a second time
+    UINT64 undone = 0; //number of cells changed back
+    ApplySpans(t, p, end, applied, undone);
+  } //if
+
+  return ok? S_OK: E_FAIL;
+} //PatchTiling
+
+#pragma endregion Diff and patch
@@ -0,0 +1,342 @@
+/// \file GridDictionary.cpp
+/// \brief Code for CGridDictionary.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <algorithm>
+#include <emmintrin.h>
+#include <intrin.h>
+
+#include "GridDictionary.h"
+
+/// A compressed grid is a byte-wise rANS stream with two 32-bit states, each
+/// kept between `RANSLOW` and 256 times that. The encoder codes cells from
+/// last to first, so that the decoder can decode them from first to last
+/// with the context of each cell already known. The stream starts with the
+/// final encoder states, least significant byte first, and decoding it ends
+/// with both states back at `RANSLOW` exactly when the stream is intact.
+
+static const UINT RANSLOW = 1 << 23; ///< Lower bound of rANS state.
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructors and destructors
+
+#pragma region Constructors and destructors
+
+/// Start with every tile equally likely in every context, which compresses
+/// Wang tiles to 3 bits per cell and is what the dictionary learns from if
+/// it is given no samples.
+
+CGridDictionary::CGridDictionary(){
+  for(UINT c=0; c<CONTEXTS; c++)
+    for(UINT s=0; s<SYMBOLS; s++)
+      m_nFreq[c][s] = USHORT((1 << PROBBITS)/SYMBOLS);
+
+  Build();
+} //constructor
+
+#pragma endregion Constructors and destructors
+
+///////////////////////////////////////////////////////////////////////////////
+// Training
+
+#pragma region Training
+
+/// Build the cumulative frequency tables from the symbol frequencies.
+
+void CGridDictionary::Build(){
+  for(UINT c=0; c<CONTEXTS; c++){
+    UINT sum = 0; //cumulative frequency
+
+    for(UINT s=0; s<SYMBOLS; s++){
+      m_nStart[c][s] = USHORT(sum);
+      sum += m_nFreq[c][s];
+      m_nEnd[c][s] = USHORT(sum);
+    } //for
+  } //for
+} //Build
+
+/// Train the dictionary on a sample of grids by counting how often each tile
+/// appears in each context. The counts for each context are smoothed by
+/// adding 1, so that every tile can still be coded in every context, and
+/// scaled so that they sum to a power of 2, with any rounding error going to
+/// the most frequent tile.
+/// \param v Sample grids.
+/// \return S_OK for success, E_FAIL if a sample has a tile index that is
+/// not a Wang tile.
+
+HRESULT CGridDictionary::Train(const std::vector<const CWangTiler*>& v){
+  std::vector<UINT64> count(CONTEXTS*SYMBOLS, 1); //smoothed counts
+
+  for(const CWangTiler* t: v){
+    const size_t w = t->GetWidth(), h = t->GetHeight();
+
+    for(size_t i=0; i<h; i++){
+      const UINT* row = t->GetRow(i);
+      const UINT* above = i > 0? t->GetRow(i - 1): nullptr;
+
+      for(size_t j=0; j<w; j++){
+        if(row[j] >= SYMBOLS)return E_FAIL;
+
+        const UINT c = (j > 0? row[j - 1]: 8)*9 + (above? above[j]: 8);
+        count[c*SYMBOLS + row[j]]++;
+      } //for
+    } //for
+  } //for
+
+  for(UINT c=0; c<CONTEXTS; c++){
+    const UINT64* p = &count[c*SYMBOLS]; //counts for this context
+    UINT64 total = 0; //sum of counts
+    UINT sum = 0; //sum of frequencies
+    UINT most = 0; //most frequent tile
+
+    for(UINT s=0; s<SYMBOLS; s++){
+      total += p[s];
+      if(p[s] > p[most])most = s;
+    } //for
+
+    for(UINT s=0; s<SYMBOLS; s++){
+      m_nFreq[c][s] = USHORT(max(1ULL, (p[s] << PROBBITS)/total));
+      sum += m_nFreq[c][s];
+    } //for
+
+    m_nFreq[c][most] = USHORT(m_nFreq[c][most] + (1 << PROBBITS) - sum);
+  } //for
+
+  Build();
+  return S_OK;
+} //Train
+
+#pragma endregion Training
+
+///////////////////////////////////////////////////////////////////////////////
+// Save and load
+
+#pragma region Save and load
+
+/// Append the dictionary to a byte vector as its symbol frequencies, context
+/// by context, each as a little-endian 16-bit number.
+/// \param v [IN, OUT] Bytes.
+
+void CGridDictionary::Save(std::vector<BYTE>& v) const{
+  for(UINT c=0; c<CONTEXTS; c++)
+    for(UINT s=0; s<SYMBOLS; s++){
+      v.push_back(BYTE(m_nFreq[c][s]));
+      v.push_back(BYTE(m_nFreq[c][s] >> 8));
+    } //for
+} //Save
+
+/// Load a dictionary saved by `Save()`. The frequencies are checked, since
+/// frequencies of 0 or that do not sum to the right total would let the
+/// decoder run off the end of its tables.
+/// \param p Pointer to the saved dictionary.
+/// \param n Number of bytes available, at least `GetSaveSize()`.
+/// \return S_OK for success, E_FAIL if the dictionary is truncated or bad,
+/// in which case this dictionary is unchanged.
+
+HRESULT CGridDictionary::Load(const BYTE* p, size_t n){
+  if(n < GetSaveSize())return E_FAIL;
+
+  USHORT freq[CONTEXTS][SYMBOLS]; //frequencies
+
+  for(UINT c=0; c<CONTEXTS; c++){
+    UINT sum = 0; //sum of frequencies
+
+    for(UINT s=0; s<SYMBOLS; s++){
+      freq[c][s] = USHORT(p[0] | p[1] << 8);
+      if(freq[c][s] == 0)return E_FAIL;
+
+      sum += freq[c][s];
+      p += 2;
+    } //for
+
+    if(sum != 1 << PROBBITS)return E_FAIL;
+  } //for
+
+  memcpy(m_nFreq, freq, sizeof(freq));
+  Build();
+
+  return S_OK;
+} //Load
+
+/// Get the size of a saved dictionary.
+/// \return Number of bytes written by `Save()`.
+
+const size_t CGridDictionary::GetSaveSize(){
+  return 2*CONTEXTS*SYMBOLS;
+} //GetSaveSize
+
+#pragma endregion Save and load
+
+///////////////////////////////////////////////////////////////////////////////
+// Compress and decompress
+
+#pragma region Compress and decompress
+
+/// Encode one cell, renormalizing first so that decoding it leaves the state
+/// in range.
+/// \param x [IN, OUT] rANS state.
+/// \param c Context.
+/// \param s Symbol.
+/// \param v [IN, OUT] Output bytes, in reverse order.
+
+void CGridDictionary::Encode(UINT& x, UINT c, UINT s,
+  std::vector<BYTE>& v) const
+{
+  const UINT f = m_nFreq[c][s]; //frequency
+
+  while(x >= (f << (31 - PROBBITS))){ //renormalize
+    v.push_back(BYTE(x));
+    x >>= 8;
+  } //while
+
+  x = ((x/f) << PROBBITS) + x%f + m_nStart[c][s];
+} //Encode
+
+/// Decode one cell. The symbol is found by comparing the low bits of the
+/// state against the 8 cumulative frequencies of its context at once with
+/// SSE2. Since they are sorted, the first one greater than it is found with
+/// a bit scan, which unlike a popcount needs nothing beyond SSE2.
+/// \param x [IN, OUT] rANS state.
+/// \param c Context.
+/// \param p [IN, OUT] Next input byte.
+/// \param end End of input.
+/// \return Symbol, or `SYMBOLS` if the input ran out.
+
+UINT CGridDictionary::Decode(UINT& x, UINT c, const BYTE*& p,
+  const BYTE* end) const
+{
+  const UINT slot = x & ((1 << PROBBITS) - 1);
+
+  const __m128i gt = _mm_cmpgt_epi16(
+    _mm_loadu_si128((const __m128i*)m_nEnd[c]), _mm_set1_epi16(short(slot)));
+  DWORD index = 0; //first byte of the first end greater than the slot
+  _BitScanForward(&index, DWORD(_mm_movemask_epi8(gt))); //last end always is
+  const UINT s = UINT(index)/2; //symbol
+
+  x = m_nFreq[c][s]*(x >> PROBBITS) + slot - m_nStart[c][s];
+
+  while(x < RANSLOW){ //renormalize
+    if(p == end)return SYMBOLS;
+    x = x << 8 | *p++;
+  } //while
+
+  return s;
+} //Decode
+
+/// Compress a grid. The rows are coded in pairs, the top row of each pair
+/// with one rANS state and the bottom row with another, so that the decoder
+/// can decode both at once, the bottom one a cell behind. The encoder visits
+/// the cells in exactly the reverse of the order that the decoder does, and
+/// both states share one stream of bytes that is reversed at the end. The
+/// grid size is not stored, since an archive keeps it in its index.
+/// \param cells Tile indices in row-major order.
+/// \param w Grid width.
+/// \param h Grid height.
+/// \param v [OUT] Compressed grid.
+/// \return S_OK for success, E_FAIL if a tile index is not a Wang tile.
+
+HRESULT CGridDictionary::Compress(const UINT* cells, UINT w, UINT h,
+  std::vector<BYTE>& v) const
+{
+  for(size_t k=0; k<size_t(w)*h; k++)
+    if(cells[k] >= SYMBOLS)return E_FAIL;
+
+  UINT x0 = RANSLOW, x1 = RANSLOW; //rANS states for top and bottom rows
+  v.clear();
+
+  for(size_t k=(size_t(h) + 1)/2; k-->0;){ //each pair of rows, backwards
+    const size_t i = 2*k; //top row number
+    const UINT* row0 = cells + i*w; //top row
+    const UINT* row1 = i + 1 < h? row0 + w: nullptr; //bottom row
+    const UINT* above = i > 0? row0 - w: nullptr; //row above top row
+
+    for(size_t j=w + 1; j-->0;){
+      if(row1 != nullptr && j > 0) //bottom row, a cell behind
+        Encode(x1, (j > 1? row1[j - 2]: 8)*9 + row0[j - 1], row1[j - 1], v);
+
+      if(j < w) //top row
+        Encode(x0, (j > 0? row0[j - 1]: 8)*9 + (above? above[j]: 8),
+          row0[j], v);
+    } //for
+  } //for
+
+  for(UINT k=4; k-->0;)
+    v.push_back(BYTE(x1 >> 8*k));
+
+  for(UINT k=4; k-->0;)
+    v.push_back(BYTE(x0 >> 8*k));
+
+  std::reverse(v.begin(), v.end());
+  return S_OK;
+} //Compress
+
+/// Decompress a grid, decoding each pair of rows with two rANS states in
+/// step so that the processor can overlap the work for the two rows.
+/// \param p Compressed grid.
+/// \param n Number of bytes of compressed grid.
+/// \param w Grid width.
+/// \param h Grid height.
+/// \param cells [OUT] Tile indices in row-major order.
+/// \return S_OK for success, E_FAIL if the compressed grid is corrupt.
+
+HRESULT CGridDictionary::Decompress(const BYTE* p, size_t n, UINT w, UINT h,
+  UINT* cells) const
+{
+  if(n < 8)return E_FAIL;
+
+  const BYTE* end = p + n; //end of compressed grid
+  UINT x0 = 0, x1 = 0; //rANS states for top and bottom rows
+
+  for(UINT k=0; k<4; k++){
+    x0 |= UINT(p[k]) << 8*k;
+    x1 |= UINT(p[k + 4]) << 8*k;
+  } //for
+
+  p += 8;
+
+  for(size_t i=0; i<h; i+=2){ //each pair of rows
+    UINT* row0 = cells + i*w; //top row
+    UINT* row1 = i + 1 < h? row0 + w: nullptr; //bottom row
+    const UINT* above = i > 0? row0 - w: nullptr; //row above top row
+    UINT left0 = 8, left1 = 8; //tiles to the left
+
+    for(size_t j=0; j<=w; j++){
+      if(j < w){ //top row
+        const UINT s = Decode(x0, left0*9 + (above? above[j]: 8), p, end);
+        if(s == SYMBOLS)return E_FAIL;
+        row0[j] = left0 = s;
+      } //if
+
+      if(row1 != nullptr && j > 0){ //bottom row, a cell behind
+        const UINT s = Decode(x1, left1*9 + row0[j - 1], p, end);
+        if(s == SYMBOLS)return E_FAIL;
+        row1[j - 1] = left1 = s;
+      } //if
+    } //for
+  } //for
+
+  return x0 == RANSLOW && x1 == RANSLOW && p == end? S_OK: E_FAIL;
+} //Decompress
+
+#pragma endregion Compress and decompress
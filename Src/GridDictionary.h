@@ -0,0 +1,75 @@
+/// \file GridDictionary.h
+/// \brief Interface for CGridDictionary.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef __GRIDDICTIONARY_H__
+#define __GRIDDICTIONARY_H__
+
+#include "Windows.h"
+#include <vector>
+
+#include "WangTiler.h"
+
+/// \brief Grid compression dictionary.
+///
+/// A dictionary holds the statistics of a family of small grids of Wang tile
+/// indices, trained once on a sample of them, so that each grid can then be
+/// compressed on its own without paying to learn those statistics again.
+/// Each cell is coded in the context of the tiles to its left and above it,
+/// which in a valid Wang tiling fix all but its parity bit, with a static
+/// rANS coder whose symbol frequencies for each of the 81 contexts are the
+/// dictionary. Grids of up to 256x256 cells typically compress to little
+/// more than 1 bit per cell, and less if the grids are biased.
+
+class CGridDictionary{
+  private:
+    static const UINT SYMBOLS = 8; ///< Number of tile indices.
+    static const UINT CONTEXTS = 81; ///< Contexts, 9 left times 9 above.
+    static const UINT PROBBITS = 12; ///< Frequencies sum to 2 to this.
+
+    USHORT m_nFreq[CONTEXTS][SYMBOLS]; ///< Symbol frequencies.
+    USHORT m_nStart[CONTEXTS][SYMBOLS]; ///< Cumulative frequency before.
+    USHORT m_nEnd[CONTEXTS][SYMBOLS]; ///< Cumulative frequency after.
+
+    void Build(); ///< Build cumulative frequencies.
+    void Encode(UINT& x, UINT c, UINT s,
+      std::vector<BYTE>& v) const; ///< Encode one cell.
+    UINT Decode(UINT& x, UINT c, const BYTE*& p,
+      const BYTE* end) const; ///< Decode one cell.
+
+  public:
+    CGridDictionary(); ///< Constructor.
+
+    HRESULT Train(const std::vector<const CWangTiler*>& v); ///< Train.
+    void Save(std::vector<BYTE>& v) const; ///< Append to bytes.
+    HRESULT Load(const BYTE* p, size_t n); ///< Load from bytes.
+    static const size_t GetSaveSize(); ///< Get size of saved dictionary.
+
+    HRESULT Compress(const UINT* cells, UINT w, UINT h,
+      std::vector<BYTE>& v) const; ///< Compress grid.
+    HRESULT Decompress(const BYTE* p, size_t n, UINT w, UINT h,
+      UINT* cells) const; ///< Decompress grid.
+}; //CGridDictionary
+
+#endif //__GRIDDICTIONARY_H__
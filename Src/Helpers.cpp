@@ -0,0 +1,107 @@
+/// \file Helpers.cpp
+/// \brief Code for portable helper functions.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <emmintrin.h>
+
+#include "Helpers.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Varint functions
+
+#pragma region Varint functions
+
+/// Append an unsigned LEB128 varint, 7 bits per byte with the high bit set
+/// on every byte but the last.
+/// \param v [IN, OUT] Bytes.
+/// \param n Number.
+
+void PutVarint(std::vector<BYTE>& v, UINT64 n){
+  while(n >= 0x80){
+    v.push_back(BYTE(n | 0x80));
+    n >>= 7;
+  } //while
+
+  v.push_back(BYTE(n));
+} //PutVarint
+
+/// Read an unsigned LEB128 varint.
+/// \param p [IN, OUT] Pointer to the next byte, advanced past the varint.
+/// \param end Pointer past the last byte.
+/// \param n [OUT] Number.
+/// \return true for success, false if the varint is truncated or too long.
+
+bool GetVarint(const BYTE*& p, const BYTE* end, UINT64& n){
+  n = 0;
+
+  for(UINT shift=0; shift<64 && p<end; shift+=7){
+    const BYTE b = *p++;
+    n |= UINT64(b & 0x7F) << shift;
+    if(b < 0x80)return true;
+  } //for
+
+  return false;
+} //GetVarint
+
+#pragma endregion Varint functions
+
+///////////////////////////////////////////////////////////////////////////////
+// Pixel functions
+
+#pragma region Pixel functions
+
+/// Get the sum of absolute differences between the bytes of two runs of
+/// 32-bit pixels, 4 pixels at a time using SSE2. Channels can be left out
+/// with a mask, for example 0x00FFFFFF to ignore alpha.
+/// \param a First run of pixels.
+/// \param b Second run of pixels.
+/// \param n Number of pixels in each run.
+/// \param mask Mask applied to each pixel first.
+/// \return Sum of absolute differences of all channels in the mask.
+
+UINT64 SumAbsDiff(const UINT* a, const UINT* b, size_t n, UINT mask){
+  const __m128i m = _mm_set1_epi32(int(mask));
+  __m128i acc = _mm_setzero_si128(); //two 64-bit partial sums
+  size_t j = 0;
+
+  for(; j + 4 <= n; j += 4)
+    acc = _mm_add_epi64(acc, _mm_sad_epu8(
+      _mm_and_si128(_mm_loadu_si128((const __m128i*)(a + j)), m),
+      _mm_and_si128(_mm_loadu_si128((const __m128i*)(b + j)), m)));
+
+  UINT64 lane[2]; //the partial sums, read in full on Win32 and x64
+  _mm_storeu_si128((__m128i*)lane, acc);
+  UINT64 sum = lane[0] + lane[1];
+
+  for(; j<n; j++) //leftover pixels
+    for(UINT k=0; k<32; k+=8){
+      const int x = ((a[j] & mask) >> k) & 0xFF;
+      const int y = ((b[j] & mask) >> k) & 0xFF;
+      sum += UINT(x > y? x - y: y - x);
+    } //for
+
+  return sum;
+} //SumAbsDiff
+
+#pragma endregion Pixel functions
@@ -0,0 +1,49 @@
+/// \file Helpers.h
+/// \brief Header for portable helper functions.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef __HELPERS_H__
+#define __HELPERS_H__
+
+#include "Windows.h"
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper functions
+
+#pragma region Helper functions
+
+//varints
+
+void PutVarint(std::vector<BYTE>&, UINT64); ///< Append varint.
+bool GetVarint(const BYTE*&, const BYTE*, UINT64&); ///< Read varint.
+
+//pixels
+
+UINT64 SumAbsDiff(const UINT*, const UINT*, size_t,
+  UINT mask=0xFFFFFFFF); ///< Sum of absolute differences.
+
+#pragma endregion Helper functions
+
+#endif //__HELPERS_H__
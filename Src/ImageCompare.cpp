@@ -0,0 +1,401 @@
+/// \file ImageCompare.cpp
+/// \brief Code for CImageCompare.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <emmintrin.h>
+#include <sstream>
+#include <wincodec.h>
+
+#include "ImageCompare.h"
+#include "WindowsHelpers.h"
+#include "ThreadPool.h"
+
+#pragma comment(lib,"Windowscodecs.lib")
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper functions
+
+#pragma region Helper functions
+
+/// \brief Partial comparison results.
+///
+/// Sums accumulated by one task over part of a band.
+
+struct SPartial{
+  UINT64 m_nSqError = 0; ///< Sum of squared channel errors.
+  UINT m_nMaxError = 0; ///< Maximum absolute channel error.
+  double m_fSSIM = 0; ///< Sum of SSIM over windows.
+  UINT64 m_nWindows = 0; ///< Number of SSIM windows.
+}; //SPartial
+
+/// Accumulate the squared error and maximum absolute error over the color
+/// channels of a row of pixels. Four pixels are processed at a time using
+/// SSE2, which every x64 processor has.
+/// \param a Row of first image.
+/// \param b Row of second image.
+/// \param w Row width in pixels.
+/// \param p [IN, OUT] Partial results.
+
+static void CompareRow(const UINT* a, const UINT* b, UINT w, SPartial& p){
+  const __m128i mask = _mm_set1_epi32(0x00FFFFFF); //drop alpha
+  const __m128i zero = _mm_setzero_si128();
+  __m128i sq = zero; //64-bit sums of squares
+  __m128i mx = zero; //byte maxima
+  UINT j = 0;
+
+  for(; j+4<=w; j+=4){
+    const __m128i x = _mm_loadu_si128((const __m128i*)(a + j));
+    const __m128i y = _mm_loadu_si128((const __m128i*)(b + j));
+    const __m128i d = _mm_and_si128(mask,
+      _mm_or_si128(_mm_subs_epu8(x, y), _mm_subs_epu8(y, x))); //|x - y|
+
+    mx = _mm_max_epu8(mx, d);
+
+    const __m128i lo = _mm_unpacklo_epi8(d, zero);
+    const __m128i hi = _mm_unpackhi_epi8(d, zero);
+    const __m128i s = _mm_add_epi32(_mm_madd_epi16(lo, lo),
+      _mm_madd_epi16(hi, hi)); //four 32-bit sums, each at most 4*255^2
+
+    sq = _mm_add_epi64(sq, _mm_unpacklo_epi32(s, zero));
+    sq = _mm_add_epi64(sq, _mm_unpackhi_epi32(s, zero));
+  } //for
+
+  UINT64 q[2];
+  BYTE m[16];
+  _mm_storeu_si128((__m128i*)q, sq);
+  _mm_storeu_si128((__m128i*)m, mx);
+
+  p.m_nSqError += q[0] + q[1];
+
+  for(int k=0; k<16; k++)
+    p.m_nMaxError = max(p.m_nMaxError, UINT(m[k]));
+
+  for(; j<w; j++) //leftovers
+    for(int c=0; c<24; c+=8){
+      const int d = int((a[j] >> c) & 0xFF) - int((b[j] >> c) & 0xFF);
+      p.m_nSqError += UINT64(d*d);
+      p.m_nMaxError = max(p.m_nMaxError, UINT(d < 0? -d: d));
+    } //for
+} //CompareRow
+
+/// Get the luma of a 32-bit ARGB pixel.
+/// \param c Pixel.
+/// \return Luma, scaled by 1024.
+
+static int Luma(UINT c){
+  return 306*int((c >> 16) & 0xFF) + 601*int((c >> 8) & 0xFF) +
+    117*int(c & 0xFF);
+} //Luma
+
+/// Accumulate SSIM over the windows in a row of windows, which is up to 8
+/// pixels high. Windows at the right edge may be narrower than 8 pixels.
+/// \param a Top row of first image.
+/// \param b Top row of second image.
+/// \param w Row width in pixels.
+/// \param rows Number of pixel rows, at most 8.
+/// \param p [IN, OUT] Partial results.
+
+static void CompareWindows(const UINT* a, const UINT* b, UINT w, UINT rows,
+  SPartial& p)
+{
+  const double C1 = 6.5025, C2 = 58.5225; //(0.01*255)^2, (0.03*255)^2
+
+  for(UINT j0=0; j0<w; j0+=8){
+    const UINT cols = min(8U, w - j0);
+    const double n = double(rows*cols);
+    double sx = 0, sy = 0, sxx = 0, syy = 0, sxy = 0;
+
+    for(UINT i=0; i<rows; i++)
+      for(UINT j=j0; j<j0 + cols; j++){
+        const double x = Luma(a[size_t(i)*w + j])/1024.0;
+        const double y = Luma(b[size_t(i)*w + j])/1024.0;
+        sx += x; sy += y; sxx += x*x; syy += y*y; sxy += x*y;
+      } //for
+
+    const double mx = sx/n, my = sy/n;
+    const double vx = sxx/n - mx*mx, vy = syy/n - my*my, cxy = sxy/n - mx*my;
+
+    p.m_fSSIM += ((2*mx*my + C1)*(2*cxy + C2))/
+      ((mx*mx + my*my + C1)*(vx + vy + C2));
+    p.m_nWindows++;
+  } //for
+} //CompareWindows
+
+#pragma endregion Helper functions
+
+///////////////////////////////////////////////////////////////////////////////
+// Comparison functions
+
+#pragma region Comparison functions
+
+/// Clear all accumulated results and set the image size.
+/// \param w Image width in pixels.
+/// \param h Image height in pixels.
+
+void CImageCompare::Reset(UINT w, UINT h){
+  m_nWidth = w;
+  m_nHeight = h;
+  m_nRows = 0;
+  m_nSqError = 0;
+  m_nMaxError = 0;
+  m_fSSIM = 0;
+  m_nWindows = 0;
+} //Reset
+
+/// Compare the next band of rows from each image. The band is split into
+/// strips of whole SSIM windows that are compared in parallel on the shared
+/// thread pool, and the partial results are merged afterwards in strip order
+/// so that the result does not depend on scheduling.
+/// \param a First image band, 32-bit ARGB in row-major order.
+/// \param b Second image band, 32-bit ARGB in row-major order.
+/// \param rows Number of rows in the band.
+/// \return S_OK for success, E_FAIL if the band is too big or, unless it is
+/// the last band, its height is not a multiple of 8.
+
+HRESULT CImageCompare::AddBand(const UINT* a, const UINT* b, UINT rows){
+  if(m_nRows + rows > m_nHeight)return E_FAIL; //too many rows
+  if(rows%8 != 0 && m_nRows + rows != m_nHeight)return E_FAIL; //misaligned
+
+  const UINT nStrips = (rows + 7)/8; //number of window rows
+  std::vector<SPartial> partial(nStrips);
+
+  CThreadPool::GetInstance().ParallelFor(nStrips, 1, [&](size_t k0, size_t k1){
+    for(size_t k=k0; k<k1; k++){
+      const UINT i0 = 8*UINT(k), n = min(8U, rows - i0);
+      const size_t offset = size_t(i0)*m_nWidth;
+
+      for(UINT i=0; i<n; i++)
+        CompareRow(a + offset + size_t(i)*m_nWidth,
+          b + offset + size_t(i)*m_nWidth, m_nWidth, partial[k]);
+
+      CompareWindows(a + offset, b + offset, m_nWidth, n, partial[k]);
+    } //for
+  }); //ParallelFor
+
+  for(const SPartial& p: partial){
+    m_nSqError += p.m_nSqError;
+    m_nMaxError = max(m_nMaxError, p.m_nMaxError);
+    m_fSSIM += p.m_fSSIM;
+    m_nWindows += p.m_nWindows;
+  } //for
+
+  m_nRows += rows;
+  return S_OK;
+} //AddBand
+
+#pragma endregion Comparison functions
+
+///////////////////////////////////////////////////////////////////////////////
+// Reader functions
+
+#pragma region Reader functions
+
+/// Determine whether every row of the images has been compared.
+/// \return true if all rows have been compared.
+
+const bool CImageCompare::IsComplete() const{
+  return m_nRows == m_nHeight;
+} //IsComplete
+
+/// Get the peak signal-to-noise ratio over the color channels.
+/// \return PSNR in decibels, or infinity if the images are identical.
+
+const double CImageCompare::GetPSNR() const{
+  const double n = 3.0*m_nWidth*m_nRows; //number of channel values
+  if(n == 0 || m_nSqError == 0)return INFINITY;
+  return 10.0*log10(255.0*255.0*n/m_nSqError);
+} //GetPSNR
+
+/// Get the mean structural similarity over the luma channel.
+/// \return SSIM, which is 1 for identical images.
+
+const double CImageCompare::GetSSIM() const{
+  return m_nWindows == 0? 1.0: m_fSSIM/m_nWindows;
+} //GetSSIM
+
+/// Reader function for `m_nMaxError`.
+/// \return `m_nMaxError`.
+
+const UINT CImageCompare::GetMaxError() const{
+  return m_nMaxError;
+} //GetMaxError
+
+/// Get the results as a JSON object. JSON has no infinity, so the PSNR of
+/// identical images is written as null.
+/// \return JSON object.
+
+std::string CImageCompare::GetJSON() const{
+  std::ostringstream s;
+  const double psnr = GetPSNR();
+
+  s.precision(6);
+  s << std::fixed;
+  s << "{\"width\": " << m_nWidth << ", \"height\": " << m_nHeight;
+  s << ", \"psnr\": ";
+  if(std::isinf(psnr))s << "null"; else s << psnr;
+  s << ", \"ssim\": " << GetSSIM();
+  s << ", \"max_error\": " << m_nMaxError;
+  s << ", \"complete\": " << (IsComplete()? "true": "false") << "}";
+
+  return s.str();
+} //GetJSON
+
+#pragma endregion Reader functions
+
+///////////////////////////////////////////////////////////////////////////////
+// Bitmap and file comparison
+
+#pragma region Bitmap and file comparison
+
+/// Compare two bitmaps of the same size, 256 rows at a time.
+/// \param a First bitmap.
+/// \param b Second bitmap.
+/// \param result [OUT] Comparison results.
+/// \return S_OK for success, E_FAIL if the sizes differ or pixels cannot be read.
+
+HRESULT CompareBitmaps(Gdiplus::Bitmap* a, Gdiplus::Bitmap* b,
+  CImageCompare& result)
+{
+  const UINT w = a->GetWidth(); //image width
+  const UINT h = a->GetHeight(); //image height
+  const UINT nBand = 256; //band height, a multiple of 8
+
+  if(w != b->GetWidth() || h != b->GetHeight())return E_FAIL;
+
+  std::vector<UINT> va, vb; //bands
+  result.Reset(w, h);
+
+  for(UINT y=0; y<h; y+=nBand){
+    const UINT rows = min(nBand, h - y);
+
+    if(FAILED(GetPixels(a, va, y, rows)) || FAILED(GetPixels(b, vb, y, rows)) ||
+      FAILED(result.AddBand(va.data(), vb.data(), rows)))
+      return E_FAIL;
+  } //for
+
+  return S_OK;
+} //CompareBitmaps
+
+/// Open the first frame of an image file with WIC, converted to 32-bit ARGB,
+/// without decoding any of its pixels yet.
+/// \param pFactory Pointer to a WIC imaging factory.
+/// \param name Name of image file.
+/// \param ppSource [OUT] Pointer to the converted frame, which the caller
+/// must release.
+/// \param w [OUT] Image width in pixels.
+/// \param h [OUT] Image height in pixels.
+/// \return S_OK for success, or a failure code.
+
+static HRESULT OpenImage(IWICImagingFactory* pFactory, const std::wstring& name,
+  IWICFormatConverter** ppSource, UINT& w, UINT& h)
+{
+  IWICBitmapDecoder* pDecoder = nullptr;
+  IWICBitmapFrameDecode* pFrame = nullptr;
+  IWICFormatConverter* pSource = nullptr;
+
+  HRESULT hr = pFactory->CreateDecoderFromFilename(name.c_str(), nullptr,
+    GENERIC_READ, WICDecodeMetadataCacheOnDemand, &pDecoder);
+
+  if(SUCCEEDED(hr))hr = pDecoder->GetFrame(0, &pFrame);
+  if(SUCCEEDED(hr))hr = pFactory->CreateFormatConverter(&pSource);
+
+  if(SUCCEEDED(hr)) //32-bit ARGB is BGRA in memory
+    hr = pSource->Initialize(pFrame, GUID_WICPixelFormat32bppBGRA,
+      WICBitmapDitherTypeNone, nullptr, 0.0, WICBitmapPaletteTypeCustom);
+
+  if(SUCCEEDED(hr))hr = pSource->GetSize(&w, &h);
+
+  if(pFrame)pFrame->Release(); //the converter keeps its own references
+  if(pDecoder)pDecoder->Release();
+
+  if(FAILED(hr) && pSource){
+    pSource->Release();
+    pSource = nullptr;
+  } //if
+
+  *ppSource = pSource;
+  return hr;
+} //OpenImage
+
+/// Compare two image files of the same size in any format that WIC can read,
+/// 256 rows at a time. Each band is decoded straight from the file with
+/// `IWICBitmapSource::CopyPixels()`, so neither image is ever in memory as a
+/// whole. The codecs decode only as far as the rows asked for, except for
+/// interlaced and progressive images, which some codecs have to decode in
+/// full. Images so wide that a band would not fit in the 32-bit buffer size
+/// that `CopyPixels()` takes are rejected.
+/// \param a Name of first image file.
+/// \param b Name of second image file.
+/// \param result [OUT] Comparison results.
+/// \return S_OK for success, E_FAIL for failure.
+
+HRESULT CompareImageFiles(const std::wstring& a, const std::wstring& b,
+  CImageCompare& result)
+{
+  const HRESULT hrCOM = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+  const UINT nBand = 256; //band height, a multiple of 8
+
+  IWICImagingFactory* pFactory = nullptr;
+  IWICFormatConverter* pA = nullptr; //first image
+  IWICFormatConverter* pB = nullptr; //second image
+  UINT w = 0, h = 0, wb = 0, hb = 0; //image sizes
+
+  HRESULT hr = CoCreateInstance(CLSID_WICImagingFactory, nullptr,
+    CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&pFactory));
+
+  if(SUCCEEDED(hr))hr = OpenImage(pFactory, a, &pA, w, h);
+  if(SUCCEEDED(hr))hr = OpenImage(pFactory, b, &pB, wb, hb);
+  if(SUCCEEDED(hr) && (w != wb || h != hb))hr = E_FAIL;
+
+  const size_t stride = 4*size_t(w); //bytes per row
+  if(stride*nBand > UINT_MAX)hr = E_FAIL; //band too big for CopyPixels
+
+  if(SUCCEEDED(hr)){
+    std::vector<UINT> va, vb; //bands
+    result.Reset(w, h);
+
+    for(UINT y=0; y<h && SUCCEEDED(hr); y+=nBand){
+      const UINT rows = min(nBand, h - y);
+      const WICRect rect = {0, INT(y), INT(w), INT(rows)}; //band
+      const size_t bytes = stride*rows; //bytes per band
+
+      va.resize(size_t(w)*rows);
+      vb.resize(size_t(w)*rows);
+
+      hr = pA->CopyPixels(&rect, UINT(stride), UINT(bytes), (BYTE*)va.data());
+      if(SUCCEEDED(hr))
+        hr = pB->CopyPixels(&rect, UINT(stride), UINT(bytes), (BYTE*)vb.data());
+      if(SUCCEEDED(hr))hr = result.AddBand(va.data(), vb.data(), rows);
+    } //for
+  } //if
+
+  if(pA)pA->Release();
+  if(pB)pB->Release();
+  if(pFactory)pFactory->Release();
+  if(SUCCEEDED(hrCOM))CoUninitialize();
+
+  return SUCCEEDED(hr)? S_OK: E_FAIL;
+} //CompareImageFiles
+
+#pragma endregion Bitmap and file comparison
@@ -0,0 +1,72 @@
+/// \file ImageCompare.h
+/// \brief Interface for CImageCompare.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef __IMAGECOMPARE_H__
+#define __IMAGECOMPARE_H__
+
+#include "Includes.h"
+
+/// \brief Image comparison.
+///
+/// Computes the peak signal-to-noise ratio, structural similarity, and maximum
+/// absolute error between two images of the same size, for use as a quality
+/// gate on lossy or approximate fast paths. The images are fed in one band of
+/// rows at a time, so they never need to be in memory all at once, and
+/// `CompareImageFiles()` decodes image files one band at a time to match. Each
+/// band is split among the workers of the shared thread pool. Alpha is ignored.
+///
+/// SSIM is computed on luma over non-overlapping 8x8 windows so that it can be
+/// accumulated band by band. This means that every band except the last must
+/// have a multiple of 8 rows.
+
+class CImageCompare{
+  private:
+    UINT m_nWidth = 0; ///< Image width in pixels.
+    UINT m_nHeight = 0; ///< Image height in pixels.
+    UINT m_nRows = 0; ///< Number of rows compared so far.
+
+    UINT64 m_nSqError = 0; ///< Sum of squared channel errors.
+    UINT m_nMaxError = 0; ///< Maximum absolute channel error.
+    double m_fSSIM = 0; ///< Sum of SSIM over windows.
+    UINT64 m_nWindows = 0; ///< Number of SSIM windows.
+
+  public:
+    void Reset(UINT w, UINT h); ///< Start a new comparison.
+
+    HRESULT AddBand(const UINT* a, const UINT* b, UINT rows); ///< Compare band.
+
+    const bool IsComplete() const; ///< All rows compared?
+    const double GetPSNR() const; ///< Get peak signal-to-noise ratio.
+    const double GetSSIM() const; ///< Get mean structural similarity.
+    const UINT GetMaxError() const; ///< Get maximum absolute error.
+    std::string GetJSON() const; ///< Get results as JSON.
+}; //CImageCompare
+
+HRESULT CompareBitmaps(Gdiplus::Bitmap* a, Gdiplus::Bitmap* b,
+  CImageCompare& result); ///< Compare bitmaps band by band.
+HRESULT CompareImageFiles(const std::wstring& a, const std::wstring& b,
+  CImageCompare& result); ///< Compare image files band by band.
+
+#endif //__IMAGECOMPARE_H__
@@ -35,5 +35,6 @@
 
 #include <cmath>
 #include <string>
+#include <vector>
 
 #endif //__INCLUDES_H__
\ No newline at end of file
@@ -0,0 +1,161 @@
+/// \file IncrementalTiler.cpp
+/// \brief Code for CIncrementalTiler.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <chrono>
+
+#include "IncrementalTiler.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructors and destructors
+
+#pragma region Constructors and destructors
+
+/// The Wang tiler must outlive the incremental tiler. Nothing is generated
+/// until `Start()` is called, and until then the tiling counts as finished.
+/// \param tiler Wang tiler to generate into.
+
+CIncrementalTiler::CIncrementalTiler(CWangTiler& tiler):
+  m_pTiler(&tiler), m_nRow(tiler.GetHeight()){
+} //constructor
+
+#pragma endregion Constructors and destructors
+
+///////////////////////////////////////////////////////////////////////////////
+// Generation functions
+
+#pragma region Generation functions
+
+/// Start generating a new tiling from the top left corner, abandoning any
+/// tiling that was partly generated.
+/// \param seed Seed, scrambled in the same way as by `CWangTiler::Seed()`.
+
+void CIncrementalTiler::Start(UINT seed){
+  m_cRandom.Seed(CWangTiler::Scramble(seed));
+  m_nRow = m_nCol = m_nChunkStart = 0;
+  if(m_pTiler->GetWidth() == 0)m_nRow = m_pTiler->GetHeight(); //empty
+} //Start
+
+/// Set a function to be called as each row is finished, with the row number.
+/// This should be done between tilings, not while one is being generated.
+/// \param f Row callback, or an empty function for none.
+
+void CIncrementalTiler::SetRowCallback(const std::function<void(size_t)>& f){
+  m_fnRow = f;
+} //SetRowCallback
+
+/// Set a function to be called after each chunk of a given number of rows is
+/// finished, and after the last row, with the first row and one past the last
+/// row of the chunk. This should be done between tilings, not while one is
+/// being generated.
+/// \param rows Rows per chunk, 0 for no chunk callback.
+/// \param f Chunk callback.
+
+void CIncrementalTiler::SetChunkCallback(size_t rows,
+  const std::function<void(size_t, size_t)>& f)
+{
+  m_nChunkRows = rows;
+  m_fnChunk = f;
+} //SetChunkCallback
+
+/// Move to the start of the next row and call the callbacks for the row that
+/// has just been finished.
+
+void CIncrementalTiler::FinishRow(){
+  const size_t i = m_nRow++;
+  m_nCol = 0;
+
+  if(m_fnRow)m_fnRow(i);
+
+  if(m_nChunkRows > 0 && m_fnChunk &&
+    (m_nRow - m_nChunkStart == m_nChunkRows ||
+     m_nRow == m_pTiler->GetHeight()))
+  {
+    m_fnChunk(m_nChunkStart, m_nRow);
+    m_nChunkStart = m_nRow;
+  } //if
+} //FinishRow
+
+/// Generate up to a given number of tiles, continuing from where the last
+/// call stopped. If there is a time budget then the clock is checked after
+/// each span of at most 64 tiles, and generation stops once the budget has
+/// been used up, so a step can overrun its budget by the time taken by one
+/// span and the callbacks that it triggers.
+/// \param tiles Largest number of tiles to generate.
+/// \param ms Time budget in milliseconds, 0 for none.
+/// \return Number of tiles generated.
+
+size_t CIncrementalTiler::Step(size_t tiles, double ms){
+  const size_t w = m_pTiler->GetWidth(), h = m_pTiler->GetHeight();
+  const auto t0 = std::chrono::steady_clock::now();
+  size_t n = 0; //number of tiles generated
+
+  while(n < tiles && m_nRow < h){
+    const size_t end = min(w, m_nCol + min(tiles - n, size_t(64))); //of span
+    UINT* row = m_pTiler->GetRow(m_nRow);
+
+    CWangTiler::FillSpan(row, m_nRow > 0? row - w: nullptr, m_nCol, end,
+      m_cRandom);
+    n += end - m_nCol;
+    m_nCol = end;
+
+    if(m_nCol == w)FinishRow();
+
+    if(ms > 0 && std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - t0).count() >= ms)break;
+  } //while
+
+  return n;
+} //Step
+
+#pragma endregion Generation functions
+
+///////////////////////////////////////////////////////////////////////////////
+// Reader functions
+
+#pragma region Reader functions
+
+/// Find out whether the tiling has been finished.
+/// \return true if every tile has been generated.
+
+const bool CIncrementalTiler::IsDone() const{
+  return m_nRow >= m_pTiler->GetHeight();
+} //IsDone
+
+/// Get the number of tiles generated so far in the current tiling.
+/// \return Number of tiles generated.
+
+const size_t CIncrementalTiler::GetGenerated() const{
+  return min(m_nRow, m_pTiler->GetHeight())*m_pTiler->GetWidth() + m_nCol;
+} //GetGenerated
+
+/// Get the number of rows finished so far in the current tiling. Rows before
+/// this one can be read from the Wang tiler.
+/// \return Number of rows finished.
+
+const size_t CIncrementalTiler::GetRowsDone() const{
+  return m_nRow;
+} //GetRowsDone
+
+#pragma endregion Reader functions
@@ -0,0 +1,82 @@
+/// \file IncrementalTiler.h
+/// \brief Interface for CIncrementalTiler.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef __INCREMENTALTILER_H__
+#define __INCREMENTALTILER_H__
+
+#include "Windows.h"
+#include <functional>
+
+#include "WangTiler.h"
+#include "Random.h"
+
+/// \brief Frame-budgeted incremental Wang tiling generator.
+///
+/// An incremental tiler generates a Wang tiling into an existing Wang tiler a
+/// few tiles at a time, so that a large tiling can be generated over many
+/// frames of a game loop without ever taking more than a bounded time in one
+/// frame. Each call to `Step()` generates at most a given number of tiles,
+/// or stops early when a time budget runs out, and the next call carries on
+/// from where it stopped, even in the middle of a row. The tiling is exactly
+/// the one that `CWangTiler::Seed()` and `CWangTiler::Generate()` would
+/// give for the same seed.
+///
+/// Everything is allocated when the incremental tiler is constructed and
+/// the callbacks are set, so stepping does no heap allocation. A row
+/// callback is called as each row is finished, and a chunk callback after
+/// each chunk of a given number of rows and after the last row.
+
+class CIncrementalTiler{
+  private:
+    CWangTiler* m_pTiler = nullptr; ///< Wang tiler to generate into.
+    CRandom m_cRandom; ///< Pseudo-random number generator.
+
+    size_t m_nRow = 0; ///< Row of the next tile.
+    size_t m_nCol = 0; ///< Column of the next tile.
+    size_t m_nChunkStart = 0; ///< First row of the current chunk.
+
+    size_t m_nChunkRows = 0; ///< Rows per chunk, 0 for no chunk callback.
+    std::function<void(size_t)> m_fnRow; ///< Row callback.
+    std::function<void(size_t, size_t)> m_fnChunk; ///< Chunk callback.
+
+    void FinishRow(); ///< Move to the next row.
+
+  public:
+    CIncrementalTiler(CWangTiler& tiler); ///< Constructor.
+
+    void Start(UINT seed); ///< Start generating a new tiling.
+    void SetRowCallback(
+      const std::function<void(size_t)>& f); ///< Set row callback.
+    void SetChunkCallback(size_t rows,
+      const std::function<void(size_t, size_t)>& f); ///< Set chunk callback.
+
+    size_t Step(size_t tiles, double ms=0); ///< Generate some tiles.
+
+    const bool IsDone() const; ///< Is the tiling finished?
+    const size_t GetGenerated() const; ///< Get number of tiles generated.
+    const size_t GetRowsDone() const; ///< Get number of rows finished.
+}; //CIncrementalTiler
+
+#endif //__INCREMENTALTILER_H__
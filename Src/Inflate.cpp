@@ -0,0 +1,405 @@
+/// \file Inflate.cpp
+/// \brief Code for the inflate function.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <array>
+
+#include "Inflate.h"
+
+/// Inflate decompresses raw DEFLATE data as described in RFC 1951, which is
+/// what zip archives and png files use, into a buffer whose size is known in
+/// advance. Huffman codes of up to `FASTBITS` bits are decoded with a single
+/// table lookup, and longer ones one bit at a time using the counts of codes
+/// of each length, which is rare since long codes are for rare symbols.
+
+static const UINT FASTBITS = 9; ///< Bits decoded by table lookup.
+
+/// Base lengths for length codes 257 through 285.
+static const USHORT g_nLengthBase[29] = {
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59,
+  67, 83, 99, 115, 131, 163, 195, 227, 258};
+
+/// Extra bits for length codes 257 through 285.
+static const BYTE g_nLengthExtra[29] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4,
+  5, 5, 5, 5, 0};
+
+/// Base distances for distance codes 0 through 29.
+static const USHORT g_nDistBase[30] = {
+  1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513,
+  769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+
+/// Extra bits for distance codes 0 through 29.
+static const BYTE g_nDistExtra[30] = {
+  0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10,
+  11, 11, 12, 12, 13, 13};
+
+/// Order in which code length code lengths are stored.
+static const BYTE g_nOrder[19] = {
+  16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+///////////////////////////////////////////////////////////////////////////////
+// Huffman codes
+
+#pragma region Huffman codes
+
+/// \brief Canonical Huffman code.
+///
+/// Each entry of the fast table is indexed by the next `FASTBITS` bits of
+/// input and holds a symbol shifted left by 4 bits plus the length of its
+/// code, or 0 if the code is longer than `FASTBITS` bits.
+
+struct SHuffman{
+  USHORT m_nFast[1 << FASTBITS]; ///< Fast lookup table.
+  USHORT m_nCount[16]; ///< Number of codes of each length.
+  USHORT m_nSymbol[288]; ///< Symbols in order of their codes.
+}; //SHuffman
+
+/// Build a canonical Huffman code from code lengths. Codes of equal length
+/// are consecutive integers in symbol order, and shorter codes come first.
+/// DEFLATE stores codes starting with their most significant bit, so the
+/// fast table is indexed by the bit-reversed code.
+/// \param length Code length of each symbol, 0 if the symbol is unused.
+/// \param n Number of symbols.
+/// \param h [OUT] Huffman code.
+/// \return true if the code lengths describe a code, false if there are too
+/// many codes of some length.
+
+static bool Build(const BYTE* length, UINT n, SHuffman& h){
+  memset(&h, 0, sizeof(h));
+
+  for(UINT s=0; s<n; s++)
+    h.m_nCount[length[s]]++;
+
+  h.m_nCount[0] = 0;
+  int left = 1; //number of codes left
+
+  for(UINT len=1; len<16; len++){
+    left = 2*left - h.m_nCount[len];
+    if(left < 0)return false; //over-subscribed
+  } //for
+
+  USHORT offset[16] = {0}; //index of first symbol of each length
+
+  for(UINT len=1; len<15; len++)
+    offset[len + 1] = offset[len] + h.m_nCount[len];
+
+  for(UINT s=0; s<n; s++)
+    if(length[s] > 0)
+      h.m_nSymbol[offset[length[s]]++] = USHORT(s);
+
+  UINT code = 0; //next code
+  UINT index = 0; //index of next symbol
+
+  for(UINT len=1; len<=FASTBITS; len++){
+    for(UINT k=0; k<h.m_nCount[len]; k++){
+      UINT r = 0; //code reversed
+
+      for(UINT b=0; b<len; b++)
+        r |= (code >> b & 1) << (len - 1 - b);
+
+      for(UINT i=r; i<(1U << FASTBITS); i+=1U << len)
+        h.m_nFast[i] = USHORT(h.m_nSymbol[index] << 4 | len);
+
+      code++;
+      index++;
+    } //for
+
+    code <<= 1;
+  } //for
+
+  return true;
+} //Build
+
+#pragma endregion Huffman codes
+
+///////////////////////////////////////////////////////////////////////////////
+// Decoder
+
+#pragma region Decoder
+
+/// \brief Inflate state.
+///
+/// Input is read into a 64-bit buffer a byte at a time, least significant
+/// bit first. Reading past the end of the input sets the error flag.
+
+struct SInflate{
+  const BYTE* m_pSrc = nullptr; ///< Next input byte.
+  const BYTE* m_pEnd = nullptr; ///< End of input.
+  UINT64 m_nBits = 0; ///< Bit buffer.
+  UINT m_nCount = 0; ///< Number of bits in bit buffer.
+
+  BYTE* m_pDest = nullptr; ///< Start of output.
+  size_t m_nPos = 0; ///< Number of bytes output.
+  size_t m_nSize = 0; ///< Size of output.
+
+  bool m_bError = false; ///< Whether the input is bad.
+
+  /// Fill the bit buffer with as many whole bytes as fit.
+
+  void Refill(){
+    while(m_nCount <= 56 && m_pSrc < m_pEnd){
+      m_nBits |= UINT64(*m_pSrc++) << m_nCount;
+      m_nCount += 8;
+    } //while
+  } //Refill
+
+  /// Read bits.
+  /// \param n Number of bits, at most 32.
+  /// \return Bits read, first bit least significant.
+
+  UINT Bits(UINT n){
+    if(m_nCount < n)Refill();
+
+    if(m_nCount < n){
+      m_bError = true;
+      return 0;
+    } //if
+
+    const UINT v = UINT(m_nBits & ((1ULL << n) - 1));
+    m_nBits >>= n;
+    m_nCount -= n;
+
+    return v;
+  } //Bits
+
+  /// Decode one symbol.
+  /// \param h Huffman code.
+  /// \return Symbol.
+
+  UINT Decode(const SHuffman& h){
+    if(m_nCount < 15)Refill();
+
+    const USHORT e = h.m_nFast[m_nBits & ((1 << FASTBITS) - 1)];
+
+    if(e != 0 && (e & 15) <= m_nCount){ //short code
+      m_nBits >>= e & 15;
+      m_nCount -= e & 15;
+      return e >> 4;
+    } //if
+
+    int code = 0, first = 0, index = 0; //long code, one bit at a time
+
+    for(UINT len=1; len<16; len++){
+      code |= int(Bits(1));
+      if(m_bError)return 0;
+
+      const int count = h.m_nCount[len];
+      if(code - count < first)return h.m_nSymbol[index + code - first];
+
+      index += count;
+      first = (first + count) << 1;
+      code <<= 1;
+    } //for
+
+    m_bError = true; //unused code
+    return 0;
+  } //Decode
+}; //SInflate
+
+/// Copy a stored block to the output.
+/// \param s [IN, OUT] Inflate state.
+/// \return true for success.
+
+static bool Stored(SInflate& s){
+  s.m_pSrc -= s.m_nCount/8; //give back whole bytes in the bit buffer
+  s.m_nBits = 0;
+  s.m_nCount = 0;
+
+  if(s.m_pEnd - s.m_pSrc < 4)return false;
+
+  const UINT len = s.m_pSrc[0] | s.m_pSrc[1] << 8; //length
+  const UINT nlen = s.m_pSrc[2] | s.m_pSrc[3] << 8; //ones complement
+  s.m_pSrc += 4;
+
+  if(len != (~nlen & 0xFFFF) || size_t(s.m_pEnd - s.m_pSrc) < len ||
+    s.m_nSize - s.m_nPos < len)return false;
+
+  memcpy(s.m_pDest + s.m_nPos, s.m_pSrc, len);
+  s.m_pSrc += len;
+  s.m_nPos += len;
+
+  return true;
+} //Stored
+
+/// Decode a block compressed with Huffman codes.
+/// \param s [IN, OUT] Inflate state.
+/// \param lit Literal and length code.
+/// \param dist Distance code.
+/// \return true for success.
+
+static bool Codes(SInflate& s, const SHuffman& lit, const SHuffman& dist){
+  for(;;){
+    const UINT sym = s.Decode(lit);
+    if(s.m_bError)return false;
+
+    if(sym < 256){ //literal
+      if(s.m_nPos == s.m_nSize)return false;
+      s.m_pDest[s.m_nPos++] = BYTE(sym);
+    } //if
+
+    else if(sym == 256)return true; //end of block
+
+    else{ //length and distance
+      if(sym > 285)return false;
+
+      const size_t len = g_nLengthBase[sym - 257] +
+        s.Bits(g_nLengthExtra[sym - 257]);
+      const UINT d = s.Decode(dist);
+      if(s.m_bError || d > 29)return false;
+
+      const size_t back = g_nDistBase[d] + s.Bits(g_nDistExtra[d]);
+
+      if(s.m_bError || back > s.m_nPos || s.m_nSize - s.m_nPos < len)
+        return false;
+
+      BYTE* p = s.m_pDest + s.m_nPos; //may overlap, so byte by byte
+
+      for(size_t i=0; i<len; i++)
+        p[i] = p[i - back];
+
+      s.m_nPos += len;
+    } //else
+  } //for
+} //Codes
+
+/// Decode a block compressed with the fixed Huffman codes, which are built
+/// the first time that they are needed.
+/// \param s [IN, OUT] Inflate state.
+/// \return true for success.
+
+static bool Fixed(SInflate& s){
+  static const std::array<SHuffman, 2> code = [](){ //literal and distance
+    std::array<SHuffman, 2> h;
+    BYTE length[288]; //code lengths
+
+    for(UINT i=0; i<288; i++)
+      length[i] = i < 144? 8: i < 256? 9: i < 280? 7: 8;
+
+    Build(length, 288, h[0]);
+    memset(length, 5, 30);
+    Build(length, 30, h[1]);
+
+    return h;
+  }(); //code
+
+  return Codes(s, code[0], code[1]);
+} //Fixed
+
+/// Decode a block compressed with Huffman codes that are stored at the start
+/// of the block, themselves compressed with a Huffman code for code lengths.
+/// \param s [IN, OUT] Inflate state.
+/// \return true for success.
+
+static bool Dynamic(SInflate& s){
+  const UINT nlen = s.Bits(5) + 257; //number of literal and length codes
+  const UINT ndist = s.Bits(5) + 1; //number of distance codes
+  const UINT ncode = s.Bits(4) + 4; //number of code length codes
+  if(s.m_bError || nlen > 286 || ndist > 30)return false;
+
+  BYTE length[286 + 30] = {0}; //code lengths
+  SHuffman lit, dist; //codes
+
+  for(UINT i=0; i<ncode; i++)
+    length[g_nOrder[i]] = BYTE(s.Bits(3));
+
+  if(s.m_bError || !Build(length, 19, lit))return false;
+
+  for(UINT i=0; i<nlen + ndist;){
+    const UINT sym = s.Decode(lit);
+    if(s.m_bError)return false;
+
+    if(sym < 16)length[i++] = BYTE(sym);
+
+    else{ //repeat
+      BYTE v = 0; //length to repeat
+      UINT k = 0; //number of repeats
+
+      if(sym == 16){
+        if(i == 0)return false;
+        v = length[i - 1];
+        k = 3 + s.Bits(2);
+      } //if
+
+      else if(sym == 17)k = 3 + s.Bits(3);
+      else k = 11 + s.Bits(7);
+
+      if(s.m_bError || i + k > nlen + ndist)return false;
+
+      while(k-- > 0)
+        length[i++] = v;
+    } //else
+  } //for
+
+  if(length[256] == 0)return false; //no end of block code
+
+  return Build(length, nlen, lit) && Build(length + nlen, ndist, dist) &&
+    Codes(s, lit, dist);
+} //Dynamic
+
+#pragma endregion Decoder
+
+///////////////////////////////////////////////////////////////////////////////
+// Inflate function
+
+#pragma region Inflate function
+
+/// Decompress raw DEFLATE data into a buffer of exactly the right size.
+/// \param src Compressed data.
+/// \param n Number of bytes of compressed data.
+/// \param dest [OUT] Buffer for the decompressed data.
+/// \param m Number of bytes of decompressed data.
+/// \return S_OK for success, E_FAIL if the data is corrupt or does not
+/// decompress to exactly `m` bytes.
+
+HRESULT Inflate(const BYTE* src, size_t n, BYTE* dest, size_t m){
+  SInflate s;
+
+  s.m_pSrc = src;
+  s.m_pEnd = src + n;
+  s.m_pDest = dest;
+  s.m_nSize = m;
+
+  bool last = false; //whether the last block has been read
+
+  while(!last){
+    last = s.Bits(1) != 0;
+    const UINT type = s.Bits(2); //block type
+    if(s.m_bError)return E_FAIL;
+
+    bool ok = false;
+
+    switch(type){
+      case 0: ok = Stored(s); break;
+      case 1: ok = Fixed(s); break;
+      case 2: ok = Dynamic(s); break;
+    } //switch
+
+    if(!ok)return E_FAIL;
+  } //while
+
+  return s.m_nPos == m? S_OK: E_FAIL;
+} //Inflate
+
+#pragma endregion Inflate function
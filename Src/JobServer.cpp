@@ -0,0 +1,365 @@
+/// \file JobServer.cpp
+/// \brief Code for CJobServer.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <winsock2.h>
+#include <afunix.h>
+
+#include "JobServer.h"
+#include "MemoryGovernor.h"
+
+#pragma comment(lib,"Ws2_32.lib")
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper functions
+
+#pragma region Helper functions
+
+/// Tile set folder names, indexed by `SJobRequest::m_nTileSet`.
+static const wchar_t* g_strTileSet[] = {
+  L"default", L"flowers", L"mud", L"grass"
+}; //g_strTileSet
+
+/// Number of tile sets.
+static const UINT NUMTILESETS = sizeof(g_strTileSet)/sizeof(g_strTileSet[0]);
+
+/// Receive exactly the requested number of bytes from a socket.
+/// \param s Socket.
+/// \param p [OUT] Buffer.
+/// \param n Number of bytes.
+/// \return true for success, false if the connection closed or failed.
+
+static bool RecvAll(SOCKET s, char* p, int n){
+  while(n > 0){
+    const int k = recv(s, p, n, 0);
+    if(k <= 0)return false;
+    p += k; n -= k;
+  } //while
+
+  return true;
+} //RecvAll
+
+/// Send exactly the requested number of bytes to a socket.
+/// \param s Socket.
+/// \param p Buffer.
+/// \param n Number of bytes.
+/// \return true for success, false if the connection closed or failed.
+
+static bool SendAll(SOCKET s, const char* p, int n){
+  while(n > 0){
+    const int k = send(s, p, n, 0);
+    if(k <= 0)return false;
+    p += k; n -= k;
+  } //while
+
+  return true;
+} //SendAll
+
+#pragma endregion Helper functions
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructors and destructors
+
+#pragma region Constructors and destructors
+
+/// Initialize Winsock. GDI+ must already be initialized.
+
+CJobServer::CJobServer():
+  m_vTileSet(NUMTILESETS, nullptr)
+{
+  WSADATA wsadata;
+  WSAStartup(MAKEWORD(2, 2), &wsadata);
+} //constructor
+
+/// Stop the server if it is still running, delete the tile sets before the
+/// tile cache that holds their tiles, then shut down Winsock.
+
+CJobServer::~CJobServer(){
+  Stop();
+
+  for(CTileSet* p: m_vTileSet)
+    delete p;
+
+  if(!m_strPath.empty())
+    DeleteFileW(m_strPath.c_str());
+
+  WSACleanup();
+} //destructor
+
+#pragma endregion Constructors and destructors
+
+///////////////////////////////////////////////////////////////////////////////
+// Server functions
+
+#pragma region Server functions
+
+/// Get the default socket path, which is in the temporary folder.
+/// \return Socket path.
+
+std::wstring CJobServer::GetDefaultPath(){
+  wchar_t path[MAX_PATH + 1] = {0};
+  GetTempPathW(MAX_PATH + 1, path);
+  return std::wstring(path) + L"WangTiling.sock";
+} //GetDefaultPath
+
+/// Create the listening socket. Any stale socket file left at the path by a
+/// server that did not shut down cleanly is deleted first.
+/// \param path Socket path.
+/// \return S_OK for success, E_FAIL for failure.
+
+HRESULT CJobServer::Listen(const std::wstring& path){
+  sockaddr_un addr = {0};
+  addr.sun_family = AF_UNIX;
+
+  const int n = WideCharToMultiByte(CP_UTF8, 0, path.c_str(), -1,
+    addr.sun_path, sizeof(addr.sun_path), nullptr, nullptr);
+  if(n == 0)return E_FAIL; //path too long
+
+  DeleteFileW(path.c_str());
+
+  const SOCKET s = socket(AF_UNIX, SOCK_STREAM, 0);
+  if(s == INVALID_SOCKET)return E_FAIL;
+
+  if(bind(s, (const sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR ||
+    listen(s, SOMAXCONN) == SOCKET_ERROR)
+  {
+    closesocket(s);
+    return E_FAIL;
+  } //if
+
+  m_nListen = s;
+  m_strPath = path;
+
+  return S_OK;
+} //Listen
+
+/// Accept connections and serve each of them on its own thread until a
+/// shutdown request is received, then wait for the connections to close.
+/// `Listen()` must have been called first.
+
+void CJobServer::Run(){
+  while(true){
+    const SOCKET s = accept(SOCKET(m_nListen), nullptr, nullptr);
+    if(s == INVALID_SOCKET)break; //listening socket closed by Stop()
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if(m_bStop){
+      closesocket(s);
+      break;
+    } //if
+
+    m_vSocket.push_back(s);
+    std::thread(&CJobServer::Serve, this, s).detach();
+  } //while
+
+  Stop();
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_cv.wait(lock, [&](){return m_vSocket.empty();});
+} //Run
+
+/// Stop accepting connections and shut down the open ones, which makes the
+/// threads serving them finish.
+
+void CJobServer::Stop(){
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_bStop = true;
+
+  if(m_nListen != UINT_PTR(INVALID_SOCKET)){
+    closesocket(SOCKET(m_nListen));
+    m_nListen = UINT_PTR(INVALID_SOCKET);
+  } //if
+
+  for(UINT_PTR s: m_vSocket)
+    shutdown(SOCKET(s), SD_BOTH);
+} //Stop
+
+/// Serve one connection. Requests are read and answered one at a time until
+/// the client disconnects, sends a malformed request, or asks the server to
+/// shut down. Result handles are only ever duplicated into the process at
+/// the other end of the socket, whose id is asked of the socket itself, so
+/// a client cannot have handles injected into some other process.
+/// \param s Connection socket.
+
+void CJobServer::Serve(UINT_PTR s){
+  HANDLE hProcess = nullptr; //client process
+  ULONG pid = 0; //client process id
+  DWORD bytes = 0; //bytes returned by WSAIoctl
+  SJobRequest req;
+
+  if(WSAIoctl(SOCKET(s), SIO_AF_UNIX_GETPEERPID, nullptr, 0, &pid,
+    sizeof(pid), &bytes, nullptr, nullptr) == 0)
+    hProcess = OpenProcess(PROCESS_DUP_HANDLE, FALSE, pid);
+
+  while(RecvAll(SOCKET(s), (char*)&req, sizeof(req))){
+    if(req.m_nMagic != JOB_MAGIC || req.m_nVersion != JOB_VERSION)
+      break; //not talking to us
+
+    SJobResponse resp;
+
+    if(req.m_eType == eJobType::Shutdown){
+      resp.m_hResult = S_OK;
+      SendAll(SOCKET(s), (const char*)&resp, sizeof(resp));
+      Stop();
+      break;
+    } //if
+
+    if(hProcess)
+      resp.m_hResult = RunJob(req, hProcess, resp);
+
+    if(!SendAll(SOCKET(s), (const char*)&resp, sizeof(resp)))
+      break;
+  } //while
+
+  if(hProcess)CloseHandle(hProcess);
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    closesocket(SOCKET(s));
+
+    for(size_t i=0; i<m_vSocket.size(); i++)
+      if(m_vSocket[i] == s){
+        m_vSocket[i] = m_vSocket.back();
+        m_vSocket.pop_back();
+        break;
+      } //if
+
+    m_cv.notify_all(); //under the lock, since Run() may be about to return
+  }
+} //Serve
+
+#pragma endregion Server functions
+
+///////////////////////////////////////////////////////////////////////////////
+// Job functions
+
+#pragma region Job functions
+
+/// Get a tile set, loading it the first time it is asked for. It then stays
+/// loaded for the lifetime of the server.
+/// \param n Tile set index.
+/// \return Pointer to the tile set, or nullptr if it could not be loaded.
+
+CTileSet* CJobServer::GetTileSet(UINT n){
+  if(n >= NUMTILESETS)return nullptr;
+
+  std::lock_guard<std::mutex> lock(m_mutexTileSet);
+
+  if(m_vTileSet[n] == nullptr){
+    CTileSet* p = new CTileSet(&m_cTileCache);
+    const std::wstring folder = std::wstring(L"tiles\\") + g_strTileSet[n];
+    std::wstring filename; //name of file that failed to load
+
+    if(SUCCEEDED(p->Load(folder, 8, filename)))
+      m_vTileSet[n] = p;
+    else delete p;
+  } //if
+
+  return m_vTileSet[n];
+} //GetTileSet
+
+/// Run one job. The memory for the job is reserved from the global memory
+/// governor, which may make it wait until other jobs finish. The tiling is
+/// generated from the seed in the request, so the same request always gets
+/// the same result however many jobs are running at once. The result is
+/// written directly into an unnamed file mapping, which is then duplicated
+/// into the client process with read access.
+/// \param req Request.
+/// \param hProcess Client process handle with `PROCESS_DUP_HANDLE` access.
+/// \param resp [OUT] Response, not including the result code.
+/// \return S_OK for success, E_FAIL for failure.
+
+HRESULT CJobServer::RunJob(const SJobRequest& req, HANDLE hProcess,
+  SJobResponse& resp)
+{
+  if(req.m_eType != eJobType::Generate && req.m_eType != eJobType::Render)
+    return E_FAIL;
+
+  const UINT w = req.m_nWidth, h = req.m_nHeight; //grid size
+  if(w == 0 || h == 0 || w > 0x10000 || h > 0x10000)return E_FAIL;
+
+  const bool bRender = req.m_eType == eJobType::Render;
+  CTileSet* pTileSet = nullptr;
+  UINT tw = 0, th = 0; //tile size, zero for no framebuffer
+
+  if(bRender){
+    pTileSet = GetTileSet(req.m_nTileSet);
+    if(pTileSet == nullptr)return E_FAIL;
+
+    tw = pTileSet->GetTileWidth();
+    th = pTileSet->GetTileHeight();
+  } //if
+
+  resp.m_nWidth = bRender? w*tw: w;
+  resp.m_nHeight = bRender? h*th: h;
+  resp.m_nBytes = 4*UINT64(resp.m_nWidth)*resp.m_nHeight;
+
+  const size_t bytes = CMemoryGovernor::GetTilingBytes(w, h, tw, th);
+  CMemoryGovernor& governor = CMemoryGovernor::GetInstance();
+  if(FAILED(governor.Reserve(bytes)))return E_FAIL;
+
+  HRESULT hr = E_FAIL;
+  HANDLE hMap = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr,
+    PAGE_READWRITE, DWORD(resp.m_nBytes >> 32), DWORD(resp.m_nBytes), nullptr);
+
+  if(hMap != nullptr){
+    BYTE* p = (BYTE*)MapViewOfFile(hMap, FILE_MAP_WRITE, 0, 0, 0);
+
+    if(p != nullptr){
+      CWangTiler tiler(w, h);
+      tiler.Seed(req.m_nSeed);
+      tiler.Generate();
+
+      if(bRender)
+        hr = pTileSet->Render(tiler, p, 4*size_t(resp.m_nWidth));
+
+      else{
+        UINT* q = (UINT*)p;
+
+        for(size_t i=0; i<h; i++)
+          for(size_t j=0; j<w; j++)
+            *q++ = UINT(tiler(i, j));
+
+        hr = S_OK;
+      } //else
+
+      UnmapViewOfFile(p);
+    } //if
+
+    HANDLE hDup = nullptr; //handle in client process
+
+    if(SUCCEEDED(hr) && DuplicateHandle(GetCurrentProcess(), hMap, hProcess,
+      &hDup, FILE_MAP_READ, FALSE, 0))
+      resp.m_nHandle = UINT64(UINT_PTR(hDup));
+    else hr = E_FAIL;
+
+    CloseHandle(hMap); //the client's handle keeps the mapping alive
+  } //if
+
+  governor.Release(bytes);
+  return hr;
+} //RunJob
+
+#pragma endregion Job functions
@@ -0,0 +1,119 @@
+/// \file JobServer.h
+/// \brief Interface for CJobServer.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef __JOBSERVER_H__
+#define __JOBSERVER_H__
+
+#include "Includes.h"
+#include "TileSet.h"
+
+#include <condition_variable>
+#include <mutex>
+
+#define JOB_MAGIC   0x474E4157 ///< Magic number, "WANG" in little-endian.
+#define JOB_VERSION 2 ///< Protocol version.
+
+/// \brief Job type.
+
+enum class eJobType: UINT{
+  Generate, ///< Generate a tiling, result is one UINT tile index per cell.
+  Render, ///< Render a tiling, result is 32-bit ARGB pixels.
+  Shutdown ///< Stop the server.
+}; //eJobType
+
+/// \brief Job request.
+///
+/// Sent by a client to the job server as raw bytes in native byte order.
+/// The tiling generated for a job depends only on its size and seed.
+
+struct SJobRequest{
+  UINT m_nMagic = JOB_MAGIC; ///< Magic number.
+  UINT m_nVersion = JOB_VERSION; ///< Protocol version.
+  eJobType m_eType = eJobType::Generate; ///< Job type.
+  UINT m_nTileSet = 0; ///< Tile set index.
+  UINT m_nWidth = 0; ///< Grid width in tiles.
+  UINT m_nHeight = 0; ///< Grid height in tiles.
+  UINT m_nSeed = 0; ///< Seed for the Wang tiler.
+}; //SJobRequest
+
+/// \brief Job response.
+///
+/// Sent by the job server in reply to each request. If the job succeeded
+/// then `m_nHandle` is a handle to an unnamed file mapping that the server
+/// has duplicated with read access into the client process, which the server
+/// identifies from the socket rather than trusting the client to say. The
+/// client maps it with `MapViewOfFile()` and closes it when done.
+
+struct SJobResponse{
+  UINT m_nMagic = JOB_MAGIC; ///< Magic number.
+  HRESULT m_hResult = E_FAIL; ///< S_OK for success, E_FAIL for failure.
+  UINT m_nWidth = 0; ///< Result width in cells or pixels.
+  UINT m_nHeight = 0; ///< Result height in cells or pixels.
+  UINT64 m_nBytes = 0; ///< Size of result in bytes.
+  UINT64 m_nHandle = 0; ///< File mapping handle in the client process.
+}; //SJobResponse
+
+/// \brief Job server.
+///
+/// A persistent local server that accepts job requests over a Unix domain
+/// socket and keeps tile sets loaded between jobs, so that clients pay the
+/// startup cost of loading tiles and initializing GDI+ once rather than once
+/// per job. Results are written directly into shared memory whose handle is
+/// passed to the client, so large framebuffers are never copied through the
+/// socket. Each connection is served by its own thread and may send any
+/// number of requests, one at a time. Jobs reserve their memory from the
+/// global memory governor and render on the shared thread pool.
+
+class CJobServer{
+  private:
+    UINT_PTR m_nListen = ~UINT_PTR(0); ///< Listening socket.
+    std::wstring m_strPath; ///< Socket path.
+    bool m_bStop = false; ///< Whether the server is stopping.
+
+    CTileCache m_cTileCache; ///< Tile cache.
+    std::vector<CTileSet*> m_vTileSet; ///< Tile sets, loaded on demand.
+    std::mutex m_mutexTileSet; ///< Guards tile sets.
+
+    std::vector<UINT_PTR> m_vSocket; ///< Open connection sockets.
+    std::mutex m_mutex; ///< Guards sockets and stop flag.
+    std::condition_variable m_cv; ///< Signalled when a connection closes.
+
+    CTileSet* GetTileSet(UINT n); ///< Get a tile set, loading if needed.
+    void Serve(UINT_PTR s); ///< Serve one connection.
+    HRESULT RunJob(const SJobRequest& req, HANDLE hProcess,
+      SJobResponse& resp); ///< Run one job.
+    void Stop(); ///< Stop accepting and close all connections.
+
+  public:
+    CJobServer(); ///< Constructor.
+    ~CJobServer(); ///< Destructor.
+
+    HRESULT Listen(const std::wstring& path); ///< Start listening.
+    void Run(); ///< Accept connections until shut down.
+
+    static std::wstring GetDefaultPath(); ///< Get default socket path.
+}; //CJobServer
+
+#endif //__JOBSERVER_H__
@@ -0,0 +1,519 @@
+/// \file JpegWriter.cpp
+/// \brief Code for CJpegWriter.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <fstream>
+#include <cmath>
+
+#include "JpegWriter.h"
+#include "ThreadPool.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Tables
+
+#pragma region Tables
+
+/// Zigzag order, that is, the natural index of the n-th coefficient.
+
+static const BYTE g_nZigzag[64] = {
+   0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+  12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+  35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+  58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63
+}; //g_nZigzag
+
+/// Base luma and chroma quantization tables in natural order from Annex K
+/// of the JPEG standard.
+
+static const BYTE g_nBaseQuant[2][64] = {
+  {
+    16, 11, 10, 16,  24,  40,  51,  61,  12, 12, 14, 19,  26,  58,  60,  55,
+    14, 13, 16, 24,  40,  57,  69,  56,  14, 17, 22, 29,  51,  87,  80,  62,
+    18, 22, 37, 56,  68, 109, 103,  77,  24, 35, 55, 64,  81, 104, 113,  92,
+    49, 64, 78, 87, 103, 121, 120, 101,  72, 92, 95, 98, 112, 100, 103,  99
+  },
+  {
+    17, 18, 24, 47, 99, 99, 99, 99,  18, 21, 26, 66, 99, 99, 99, 99,
+    24, 26, 56, 99, 99, 99, 99, 99,  47, 66, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,  99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,  99, 99, 99, 99, 99, 99, 99, 99
+  }
+}; //g_nBaseQuant
+
+/// Huffman code lengths for the standard tables from Annex K of the JPEG
+/// standard, in the order luma DC, chroma DC, luma AC, chroma AC.
+
+static const BYTE g_nHuffBits[4][16] = {
+  {0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0},
+  {0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0},
+  {0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d},
+  {0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77}
+}; //g_nHuffBits
+
+/// Huffman symbols for the standard DC tables.
+
+static const BYTE g_nHuffValDC[12] = {
+  0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11
+}; //g_nHuffValDC
+
+/// Huffman symbols for the standard luma AC table.
+
+static const BYTE g_nHuffValACLuma[162] = {
+  0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06,
+  0x13, 0x51, 0x61, 0x07, 0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08,
+  0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0, 0x24, 0x33, 0x62, 0x72,
+  0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+  0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45,
+  0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59,
+  0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75,
+  0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+  0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3,
+  0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6,
+  0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9,
+  0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+  0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4,
+  0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+}; //g_nHuffValACLuma
+
+/// Huffman symbols for the standard chroma AC table.
+
+static const BYTE g_nHuffValACChroma[162] = {
+  0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41,
+  0x51, 0x07, 0x61, 0x71, 0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91,
+  0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0, 0x15, 0x62, 0x72, 0xd1,
+  0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+  0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44,
+  0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58,
+  0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74,
+  0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+  0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a,
+  0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4,
+  0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7,
+  0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+  0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4,
+  0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+}; //g_nHuffValACChroma
+
+/// Huffman symbols in the same order as `g_nHuffBits`.
+
+static const BYTE* g_pHuffVal[4] = {
+  g_nHuffValDC, g_nHuffValDC, g_nHuffValACLuma, g_nHuffValACChroma
+}; //g_pHuffVal
+
+#pragma endregion Tables
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper functions
+
+#pragma region Helper functions
+
+/// \brief Huffman codes.
+///
+/// Code and length for every symbol of the four standard Huffman tables,
+/// generated from `g_nHuffBits` and `g_pHuffVal` as described in Annex C of the
+/// JPEG standard.
+
+struct SHuffmanCodes{
+  WORD m_nCode[4][256] = {{0}}; ///< Codes.
+  BYTE m_nSize[4][256] = {{0}}; ///< Code lengths in bits.
+
+  /// Generate codes in order of increasing length.
+
+  SHuffmanCodes(){
+    for(int t=0; t<4; t++){
+      UINT code = 0, k = 0;
+
+      for(UINT len=1; len<=16; len++){
+        for(UINT i=0; i<g_nHuffBits[t][len - 1]; i++, k++){
+          const BYTE v = g_pHuffVal[t][k];
+          m_nCode[t][v] = WORD(code++);
+          m_nSize[t][v] = BYTE(len);
+        } //for
+
+        code <<= 1;
+      } //for
+    } //for
+  } //constructor
+}; //SHuffmanCodes
+
+static const SHuffmanCodes g_cHuffman; ///< The standard Huffman codes.
+
+/// \brief Bit writer.
+///
+/// Appends bits most significant first to a byte buffer, stuffing a zero byte
+/// after every 0xFF as required in entropy coded segments.
+
+struct SBitWriter{
+  std::vector<BYTE>& m_vBuffer; ///< Output buffer.
+  UINT64 m_nAcc = 0; ///< Bit accumulator.
+  UINT m_nBits = 0; ///< Number of bits in the accumulator.
+
+  /// \param v Output buffer.
+  SBitWriter(std::vector<BYTE>& v): m_vBuffer(v){}
+
+  /// Append bits.
+  /// \param code Bits, right justified.
+  /// \param len Number of bits.
+
+  void Put(UINT code, UINT len){
+    m_nAcc = m_nAcc << len | (code & ((1 << len) - 1));
+    m_nBits += len;
+
+    while(m_nBits >= 8){
+      const BYTE b = BYTE(m_nAcc >> (m_nBits - 8));
+      m_vBuffer.push_back(b);
+      if(b == 0xFF)m_vBuffer.push_back(0); //byte stuffing
+      m_nBits -= 8;
+    } //while
+  } //Put
+
+  /// Pad the last byte with 1 bits.
+
+  void Flush(){
+    if(m_nBits > 0)
+      Put((1 << (8 - m_nBits)) - 1, 8 - m_nBits);
+  } //Flush
+}; //SBitWriter
+
+/// Get the JPEG magnitude category of a coefficient, that is, the number of
+/// bits needed to represent its absolute value.
+/// \param v Coefficient.
+/// \return Number of bits.
+
+static UINT Category(int v){
+  UINT n = 0;
+
+  for(UINT a=UINT(v < 0? -v: v); a; a>>=1)
+    n++;
+
+  return n;
+} //Category
+
+/// Huffman code one block of quantized coefficients in zigzag order.
+/// \param bw Bit writer.
+/// \param coeff Coefficients.
+/// \param pred [IN, OUT] DC predictor for this component.
+/// \param chroma 0 for luma, 1 for chroma.
+
+static void EncodeBlock(SBitWriter& bw, const short* coeff, int& pred,
+  int chroma)
+{
+  const int dc = chroma, ac = 2 + chroma; //table numbers
+  const int diff = coeff[0] - pred;
+  pred = coeff[0];
+
+  UINT n = Category(diff);
+  bw.Put(g_cHuffman.m_nCode[dc][n], g_cHuffman.m_nSize[dc][n]);
+  bw.Put(diff < 0? diff - 1: diff, n);
+
+  UINT run = 0; //number of zeros since last nonzero
+
+  for(UINT k=1; k<64; k++){
+    const int v = coeff[k];
+
+    if(v == 0)run++;
+
+    else{
+      for(; run>=16; run-=16) //zero run length
+        bw.Put(g_cHuffman.m_nCode[ac][0xF0], g_cHuffman.m_nSize[ac][0xF0]);
+
+      n = Category(v);
+      const UINT sym = run << 4 | n;
+      bw.Put(g_cHuffman.m_nCode[ac][sym], g_cHuffman.m_nSize[ac][sym]);
+      bw.Put(v < 0? v - 1: v, n);
+      run = 0;
+    } //else
+  } //for
+
+  if(run > 0) //end of block
+    bw.Put(g_cHuffman.m_nCode[ac][0], g_cHuffman.m_nSize[ac][0]);
+} //EncodeBlock
+
+/// Write a big-endian 16-bit unsigned integer to a stream.
+/// \param s Output stream.
+/// \param n Value to be written.
+
+static void Write16(std::ostream& s, UINT n){
+  s.put(char(n >> 8));
+  s.put(char(n));
+} //Write16
+
+#pragma endregion Helper functions
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructors and destructors
+
+#pragma region Constructors and destructors
+
+/// Scale the base quantization tables for the required quality using the
+/// formula from the Independent JPEG Group's library.
+/// \param quality Quality from 1 (worst) to 100 (best).
+
+CJpegWriter::CJpegWriter(UINT quality):
+  m_nQuality(min(100U, max(1U, quality)))
+{
+  const UINT scale = m_nQuality < 50? 5000/m_nQuality: 200 - 2*m_nQuality;
+
+  for(int t=0; t<2; t++)
+    for(int i=0; i<64; i++){
+      const UINT q = (g_nBaseQuant[t][i]*scale + 50)/100;
+      m_nQuant[t][i] = BYTE(min(255U, max(1U, q)));
+    } //for
+} //constructor
+
+#pragma endregion Constructors and destructors
+
+///////////////////////////////////////////////////////////////////////////////
+// Transform and coding
+
+#pragma region Transform and coding
+
+/// Convert an 8x8 block of pixels to YCbCr, apply the forward DCT to each
+/// component, then quantize and store the coefficients in zigzag order. This
+/// is only ever applied to the tiles, so clarity wins over speed.
+/// \param p Pointer to the top left pixel of the block.
+/// \param stride Distance between rows in pixels.
+/// \param dest [OUT] 3 blocks of 64 coefficients, Y then Cb then Cr.
+
+void CJpegWriter::Transform(const UINT* p, UINT stride, short* dest) const{
+  static const double PI = 3.14159265358979323846;
+  double c[8][8]; //DCT basis
+  double f[3][8][8]; //level-shifted component values
+
+  for(int u=0; u<8; u++)
+    for(int x=0; x<8; x++)
+      c[u][x] = (u == 0? sqrt(0.125): 0.5)*cos((2*x + 1)*u*PI/16);
+
+  for(int y=0; y<8; y++)
+    for(int x=0; x<8; x++){
+      const UINT n = p[y*stride + x];
+      const double r = (n >> 16) & 0xFF, g = (n >> 8) & 0xFF, b = n & 0xFF;
+
+      f[0][y][x] =  0.299*r    + 0.587*g    + 0.114*b - 128;
+      f[1][y][x] = -0.168736*r - 0.331264*g + 0.5*b;
+      f[2][y][x] =  0.5*r      - 0.418688*g - 0.081312*b;
+    } //for
+
+  for(int k=0; k<3; k++){
+    double t[8][8] = {{0}}; //rows transformed
+
+    for(int y=0; y<8; y++)
+      for(int u=0; u<8; u++)
+        for(int x=0; x<8; x++)
+          t[y][u] += c[u][x]*f[k][y][x];
+
+    for(int i=0; i<64; i++){
+      const int u = g_nZigzag[i] & 7, v = g_nZigzag[i] >> 3;
+      double F = 0;
+
+      for(int y=0; y<8; y++)
+        F += c[v][y]*t[y][u];
+
+      dest[64*k + i] = short(lround(F/m_nQuant[k > 0][g_nZigzag[i]]));
+    } //for
+  } //for
+} //Transform
+
+/// Entropy code one row of blocks, which is also one restart interval. The DC
+/// predictors start at zero, so rows can be coded independently of each other.
+/// \param tiler Wang tiler.
+/// \param row Block row number in the image.
+/// \param dest [OUT] Entropy coded segment for the row.
+
+void CJpegWriter::EncodeRow(const CWangTiler& tiler, size_t row,
+  std::vector<BYTE>& dest) const
+{
+  const size_t i = row/m_nTileHeight; //grid row
+  const size_t r = row%m_nTileHeight; //block row within tile
+  int pred[3] = {0}; //DC predictors
+
+  dest.clear();
+  SBitWriter bw(dest);
+
+  for(size_t j=0; j<tiler.GetWidth(); j++){
+    const short* p = m_vCoeff[tiler(i, j)].data() + 3*64*r*m_nTileWidth;
+
+    for(UINT b=0; b<m_nTileWidth; b++, p+=3*64)
+      for(int k=0; k<3; k++)
+        EncodeBlock(bw, p + 64*k, pred[k], k > 0);
+  } //for
+
+  bw.Flush();
+} //EncodeRow
+
+/// Transform and quantize every block of every tile and store the results in
+/// `m_vCoeff`. The blocks of each tile are stored in row-major order.
+/// \param tiles Tile pixels, 32-bit ARGB in row-major order.
+/// \param w Tile width in pixels.
+/// \param h Tile height in pixels.
+/// \return S_OK for success, E_FAIL if the tile size is not a multiple of 8.
+
+HRESULT CJpegWriter::Compress(const std::vector<std::vector<UINT>>& tiles,
+  UINT w, UINT h)
+{
+  if(w == 0 || h == 0 || w%8 != 0 || h%8 != 0)return E_FAIL;
+
+  m_nTileWidth  = w/8;
+  m_nTileHeight = h/8;
+  m_vCoeff.resize(tiles.size());
+
+  for(size_t t=0; t<tiles.size(); t++){
+    m_vCoeff[t].resize(size_t(3)*64*m_nTileWidth*m_nTileHeight);
+    short* dest = m_vCoeff[t].data();
+
+    for(UINT i=0; i<m_nTileHeight; i++)
+      for(UINT j=0; j<m_nTileWidth; j++, dest+=3*64)
+        Transform(&tiles[t][8*(i*w + j)], w, dest);
+  } //for
+
+  return S_OK;
+} //Compress
+
+#pragma endregion Transform and coding
+
+///////////////////////////////////////////////////////////////////////////////
+// Save function
+
+#pragma region Save function
+
+/// Save a Wang tiling as a baseline JPEG file. Batches of block rows are
+/// entropy coded in parallel on the shared thread pool, one task per row, and
+/// written out in order separated by restart markers, so memory use is
+/// bounded by the batch size.
+/// `Compress()` must have been called first.
+/// \param filename Name of the JPEG file.
+/// \param tiler Wang tiler.
+/// \return S_OK for success, E_FAIL for failure.
+
+HRESULT CJpegWriter::Save(const std::wstring& filename,
+  const CWangTiler& tiler) const
+{
+  if(m_vCoeff.empty())return E_FAIL; //nothing compressed
+
+  const size_t nGridWidth  = tiler.GetWidth();
+  const size_t nGridHeight = tiler.GetHeight();
+  const size_t w = 8*m_nTileWidth*nGridWidth; //image width
+  const size_t h = 8*m_nTileHeight*nGridHeight; //image height
+
+  if(w == 0 || h == 0 || w > 0xFFFF || h > 0xFFFF)
+    return E_FAIL; //too big for a JPEG header
+
+  for(size_t i=0; i<nGridHeight; i++) //make sure indices are in range
+    for(size_t j=0; j<nGridWidth; j++)
+      if(tiler(i, j) >= m_vCoeff.size())return E_FAIL;
+
+  std::ofstream s(filename, std::ios::binary);
+  if(!s.is_open())return E_FAIL;
+
+  Write16(s, 0xFFD8); //SOI
+
+  Write16(s, 0xFFE0); //APP0, JFIF 1.1, no thumbnail
+  Write16(s, 16);
+  s.write("JFIF\0", 5);
+  s.put(1); s.put(1); s.put(0);
+  Write16(s, 1); Write16(s, 1);
+  s.put(0); s.put(0);
+
+  for(int t=0; t<2; t++){ //DQT
+    Write16(s, 0xFFDB);
+    Write16(s, 67);
+    s.put(char(t));
+
+    for(int i=0; i<64; i++)
+      s.put(char(m_nQuant[t][g_nZigzag[i]]));
+  } //for
+
+  Write16(s, 0xFFC0); //SOF0
+  Write16(s, 17);
+  s.put(8); //precision
+  Write16(s, UINT(h));
+  Write16(s, UINT(w));
+  s.put(3); //components
+
+  for(int k=0; k<3; k++){
+    s.put(char(k + 1)); //component id
+    s.put(0x11); //no subsampling
+    s.put(char(k > 0)); //quantization table
+  } //for
+
+  for(int t=0; t<4; t++){ //DHT
+    UINT n = 0;
+
+    for(int i=0; i<16; i++)
+      n += g_nHuffBits[t][i];
+
+    Write16(s, 0xFFC4);
+    Write16(s, 19 + n);
+    s.put(char((t >> 1) << 4 | (t & 1))); //class and id
+    s.write((const char*)g_nHuffBits[t], 16);
+    s.write((const char*)g_pHuffVal[t], n);
+  } //for
+
+  const size_t nRowBlocks = w/8; //blocks per row, the restart interval
+
+  if(nRowBlocks > 0xFFFF)return E_FAIL;
+
+  Write16(s, 0xFFDD); //DRI
+  Write16(s, 4);
+  Write16(s, UINT(nRowBlocks));
+
+  Write16(s, 0xFFDA); //SOS
+  Write16(s, 12);
+  s.put(3);
+
+  for(int k=0; k<3; k++){
+    s.put(char(k + 1)); //component id
+    s.put(char(k > 0? 0x11: 0x00)); //DC and AC tables
+  } //for
+
+  s.put(0); s.put(63); s.put(0); //spectral selection, approximation
+
+  //entropy coded data
+
+  const size_t nRows = h/8; //number of block rows
+  CThreadPool& pool = CThreadPool::GetInstance();
+  std::vector<std::vector<BYTE>> buffer(4*pool.GetSize()); //one per row in batch
+
+  for(size_t r0=0; r0<nRows; r0+=buffer.size()){ //for each batch
+    const size_t n = min(buffer.size(), nRows - r0); //rows in this batch
+
+    pool.ParallelFor(n, 1, [&](size_t k0, size_t k1){
+      for(size_t k=k0; k<k1; k++)
+        EncodeRow(tiler, r0 + k, buffer[k]);
+    }); //ParallelFor
+
+    for(size_t k=0; k<n; k++){
+      s.write((const char*)buffer[k].data(), buffer[k].size());
+
+      if(r0 + k + 1 < nRows) //restart marker between intervals
+        Write16(s, 0xFFD0 + UINT((r0 + k)%8));
+    } //for
+  } //for
+
+  Write16(s, 0xFFD9); //EOI
+
+  return s.good()? S_OK: E_FAIL;
+} //Save
+
+#pragma endregion Save function
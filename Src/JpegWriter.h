@@ -0,0 +1,68 @@
+/// \file JpegWriter.h
+/// \brief Interface for CJpegWriter.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef __JPEGWRITER_H__
+#define __JPEGWRITER_H__
+
+#include "Windows.h"
+#include <string>
+#include <vector>
+
+#include "WangTiler.h"
+
+/// \brief Tile-aware baseline JPEG writer.
+///
+/// If the tile width and height are multiples of 8 then every 8x8 block of a
+/// Wang tiling image lies inside exactly one tile, so its quantized DCT
+/// coefficients depend only on the tile. The JPEG writer therefore transforms
+/// and quantizes each tile once, and saving a tiling only runs the Huffman
+/// coder over the reused coefficient blocks. The image is coded 4:4:4 with
+/// a restart marker after every row of blocks so that the rows can be entropy
+/// coded in parallel.
+
+class CJpegWriter{
+  private:
+    UINT m_nQuality = 90; ///< Quality from 1 to 100.
+    BYTE m_nQuant[2][64] = {0}; ///< Luma and chroma quantization tables.
+
+    UINT m_nTileWidth = 0; ///< Tile width in blocks.
+    UINT m_nTileHeight = 0; ///< Tile height in blocks.
+
+    std::vector<std::vector<short>> m_vCoeff; ///< Coefficients per tile.
+
+    void Transform(const UINT* p, UINT stride, short* dest) const; ///< DCT.
+    void EncodeRow(const CWangTiler& tiler, size_t row,
+      std::vector<BYTE>& dest) const; ///< Entropy code one row of blocks.
+
+  public:
+    CJpegWriter(UINT quality=90); ///< Constructor.
+
+    HRESULT Compress(const std::vector<std::vector<UINT>>& tiles,
+      UINT w, UINT h); ///< Transform and quantize tiles.
+    HRESULT Save(const std::wstring& filename,
+      const CWangTiler& tiler) const; ///< Save tiling as JPEG.
+}; //CJpegWriter
+
+#endif //__JPEGWRITER_H__
@@ -0,0 +1,430 @@
+/// \file LoadTest.cpp
+/// \brief Code for CLoadTest.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <thread>
+
+#include "LoadTest.h"
+#include "GridDelta.h"
+#include "MemoryGovernor.h"
+#include "ThreadPool.h"
+
+static const char* g_szOpName[] = {
+  "generate", "render", "encode", "query"
+}; ///< Operation names, indexed by `eLoadOp`.
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructors and destructors
+
+#pragma region Constructors and destructors
+
+/// Generate the tiling that query operations read from.
+/// \param pTileSet Pointer to tile set for rendering, or **nullptr** if the
+/// mix does not include rendering.
+/// \param w Tiling width in tiles.
+/// \param h Tiling height in tiles.
+
+CLoadTest::CLoadTest(const CTileSet* pTileSet, size_t w, size_t h):
+  m_pTileSet(pTileSet), m_nWidth(w), m_nHeight(h)
+{
+  m_pShared = new CWangTiler(w, h);
+  m_pShared->Generate();
+
+  if(m_pTileSet == nullptr)
+    m_nWeight[UINT(eLoadOp::Render)] = 0;
+} //constructor
+
+/// Delete the shared tiling.
+
+CLoadTest::~CLoadTest(){
+  delete m_pShared;
+} //destructor
+
+#pragma endregion Constructors and destructors
+
+///////////////////////////////////////////////////////////////////////////////
+// Settings
+
+#pragma region Settings
+
+/// Set the operation mix from a comma-separated list of operation names and
+/// weights, for example `generate:4,query:1`. Operations that are not listed
+/// get weight 0.
+/// \param mix Operation mix.
+/// \return S_OK for success, E_FAIL if an operation name is not recognized,
+/// rendering is asked for without a tile set, or every weight is 0.
+
+HRESULT CLoadTest::SetMix(const std::wstring& mix){
+  UINT weight[NUMOPS] = {0}; //new weights
+  size_t i = 0; //start of current item
+
+  while(i < mix.size()){
+    size_t j = mix.find(L',', i); //end of current item
+    if(j == std::wstring::npos)j = mix.size();
+
+    const std::wstring item = mix.substr(i, j - i);
+    const size_t k = item.find(L':'); //name separator
+    const std::wstring name = item.substr(0, k);
+    const std::string ascii(name.begin(), name.end()); //name as ASCII
+    UINT op = 0;
+
+    while(op < NUMOPS && ascii != g_szOpName[op])
+      op++;
+
+    if(op == NUMOPS)return E_FAIL; //unknown operation
+
+    weight[op] = k == std::wstring::npos? 1:
+      UINT(wcstoul(item.c_str() + k + 1, nullptr, 10));
+    i = j + 1;
+  } //while
+
+  if(weight[UINT(eLoadOp::Render)] > 0 && m_pTileSet == nullptr)return E_FAIL;
+
+  UINT total = 0;
+
+  for(UINT op=0; op<NUMOPS; op++)
+    total += weight[op];
+
+  if(total == 0)return E_FAIL;
+
+  for(UINT op=0; op<NUMOPS; op++)
+    m_nWeight[op] = weight[op];
+
+  return S_OK;
+} //SetMix
+
+/// Set the time for which each concurrency level runs.
+/// \param ms Time in milliseconds.
+
+void CLoadTest::SetDuration(DWORD ms){
+  m_nDuration = max(DWORD(1), ms);
+} //SetDuration
+
+#pragma endregion Settings
+
+///////////////////////////////////////////////////////////////////////////////
+// Histogram functions
+
+#pragma region Histogram functions
+
+/// Record the latency of an operation. The histogram bucket is four times
+/// the base 2 logarithm of the latency in nanoseconds.
+/// \param h Histogram.
+/// \param ns Latency in nanoseconds.
+
+void CLoadTest::Record(SHistogram& h, UINT64 ns){
+  const UINT b = UINT(4*std::log2(double(ns) + 1)); //histogram bucket
+  h.m_nBucket[min(b, NUMBUCKETS - 1)]++;
+  h.m_nCount++;
+  h.m_nTotal += ns;
+  h.m_nMax = max(h.m_nMax, ns);
+} //Record
+
+/// Get statistics from a histogram. Percentiles are taken to be at the
+/// geometric midpoint of the histogram bucket they fall in.
+/// \param h Histogram.
+/// \param seconds Measured time in seconds.
+/// \return Statistics.
+
+SLoadStats CLoadTest::GetStats(const SHistogram& h, double seconds){
+  SLoadStats stats;
+
+  stats.m_nOps = h.m_nCount;
+  if(stats.m_nOps == 0)return stats;
+
+  stats.m_fThroughput = seconds > 0? stats.m_nOps/seconds: 0;
+  stats.m_fMean = h.m_nTotal/1e6/stats.m_nOps;
+  stats.m_fMax = h.m_nMax/1e6;
+
+  auto percentile = [&](double f){
+    const UINT64 rank = UINT64(std::ceil(f*stats.m_nOps)); //1-based
+    UINT64 sum = 0;
+    UINT i = 0;
+
+    while(i < NUMBUCKETS - 1 && (sum += h.m_nBucket[i]) < rank)
+      i++;
+
+    return min(stats.m_fMax, (std::exp2((i + 0.5)/4) - 1)/1e6);
+  }; //percentile
+
+  stats.m_fP50 = percentile(0.5);
+  stats.m_fP90 = percentile(0.9);
+  stats.m_fP99 = percentile(0.99);
+
+  return stats;
+} //GetStats
+
+#pragma endregion Histogram functions
+
+///////////////////////////////////////////////////////////////////////////////
+// Run functions
+
+#pragma region Run functions
+
+/// Run one client. The client allocates everything it needs up front, so
+/// that allocation is not measured, then signals that it is ready and waits
+/// for the signal to go. It then picks operations at random according to the
+/// mix and times each one until the signal to stop. Each client keeps two
+/// tilers and generates into them alternately, so that it always has a pair
+/// to encode a delta between.
+/// \param seed Seed for the client's pseudo-random number generator.
+/// \param go Set when all clients are ready.
+/// \param stop Set when the time is up.
+/// \param ready [IN, OUT] Number of clients ready.
+/// \param starved [IN, OUT] Number of clients without a render buffer.
+/// \param hist [OUT] Array of histograms, one per operation.
+
+void CLoadTest::Client(UINT seed, const std::atomic<bool>& go,
+  const std::atomic<bool>& stop, std::atomic<UINT>& ready,
+  std::atomic<UINT>& starved, SHistogram* hist) const
+{
+  std::default_random_engine r(seed);
+  UINT weight[NUMOPS]; //this client's weights
+  UINT total = 0; //total weight
+
+  for(UINT op=0; op<NUMOPS; op++)
+    weight[op] = m_nWeight[op];
+
+  CWangTiler* pTiler[2] = { //alternate tilers
+    new CWangTiler(m_nWidth, m_nHeight), new CWangTiler(m_nWidth, m_nHeight)};
+  pTiler[0]->Seed(seed);
+  pTiler[0]->Generate();
+  pTiler[1]->Seed(~seed);
+  pTiler[1]->Generate();
+  UINT cur = 0; //current tiler
+
+  std::vector<UINT> buffer; //render buffer
+  std::vector<BYTE> delta; //encoded delta
+  size_t bytes = 0; //bytes reserved
+  size_t stride = 0; //render buffer stride in bytes
+
+  if(weight[UINT(eLoadOp::Render)] > 0){
+    const UINT tw = m_pTileSet->GetTileWidth(), th = m_pTileSet->GetTileHeight();
+    bytes = CMemoryGovernor::GetTilingBytes(m_nWidth, m_nHeight, tw, th);
+
+    if(CMemoryGovernor::GetInstance().TryReserve(bytes)){
+      buffer.resize(m_nWidth*tw*m_nHeight*th);
+      stride = 4*m_nWidth*tw;
+    } //if
+
+    else{ //over budget, so leave rendering out
+      bytes = 0;
+      weight[UINT(eLoadOp::Render)] = 0;
+      starved++;
+    } //else
+  } //if
+
+  for(UINT op=0; op<NUMOPS; op++)
+    total += weight[op];
+
+  ready++;
+  while(!go)std::this_thread::yield();
+
+  std::uniform_int_distribution<UINT> pick(0, max(1U, total) - 1);
+  std::uniform_int_distribution<size_t> row(0, m_nHeight - 1);
+  std::uniform_int_distribution<size_t> col(0, m_nWidth - 1);
+  volatile size_t sink = 0; //keeps queries from being optimized away
+
+  while(total > 0 && !stop){
+    UINT x = pick(r), op = 0; //choose an operation by weight
+
+    while(x >= weight[op])
+      x -= weight[op++];
+
+    const auto t0 = std::chrono::steady_clock::now();
+
+    switch(eLoadOp(op)){
+      case eLoadOp::Generate:
+        cur ^= 1;
+        pTiler[cur]->Seed(r());
+        pTiler[cur]->Generate();
+        break;
+
+      case eLoadOp::Render:
+        m_pTileSet->Render(*pTiler[cur], (BYTE*)buffer.data(), stride);
+        break;
+
+      case eLoadOp::Encode:
+        DiffTilings(*pTiler[cur ^ 1], *pTiler[cur], delta);
+        break;
+
+      case eLoadOp::Query:
+        for(UINT k=0; k<QUERYCELLS; k++)
+          sink += (*m_pShared)(row(r), col(r));
+        break;
+
+      default: break;
+    } //switch
+
+    Record(hist[op], UINT64(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - t0).count()));
+  } //while
+
+  CMemoryGovernor::GetInstance().Release(bytes);
+  delete pTiler[0];
+  delete pTiler[1];
+} //Client
+
+/// Run the load test at 1, 2, 4, and so on up to `n` client threads, always
+/// including `n` itself. The clients are plain threads rather than thread
+/// pool tasks, since they stand for independent callers of the API; the
+/// operations that they call still share the thread pool. Each level starts
+/// only when every client is ready, and its time is measured from then until
+/// the last client has finished its last operation.
+/// \param n Maximum number of client threads.
+/// \return S_OK for success, E_FAIL if `n` is 0 or the tiling is empty.
+
+HRESULT CLoadTest::Run(UINT n){
+  if(n == 0 || m_nWidth == 0 || m_nHeight == 0)return E_FAIL;
+
+  m_vLevel.clear();
+
+  for(UINT t=1; t<=n; t=(t == n? n + 1: min(2*t, n))){
+    std::vector<std::vector<SHistogram>> hist(t,
+      std::vector<SHistogram>(NUMOPS)); //per client, per operation
+    std::vector<std::thread> client;
+    std::atomic<bool> go(false), stop(false);
+    std::atomic<UINT> ready(0), starved(0);
+
+    for(UINT i=0; i<t; i++)
+      client.emplace_back(&CLoadTest::Client, this, 0x9E3779B9U*(i + 1),
+        std::cref(go), std::cref(stop), std::ref(ready), std::ref(starved),
+        hist[i].data());
+
+    while(ready < t)std::this_thread::yield();
+
+    const auto t0 = std::chrono::steady_clock::now();
+    go = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(m_nDuration));
+    stop = true;
+
+    for(std::thread& c: client)
+      c.join();
+
+    SLoadLevel level;
+    level.m_nThreads = t;
+    level.m_nStarved = starved;
+    level.m_fSeconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - t0).count();
+
+    SHistogram all; //over all operations
+
+    for(UINT op=0; op<NUMOPS; op++){
+      SHistogram h; //over all clients
+
+      for(UINT i=0; i<t; i++){
+        const SHistogram& g = hist[i][op];
+
+        for(UINT b=0; b<NUMBUCKETS; b++)
+          h.m_nBucket[b] += g.m_nBucket[b];
+
+        h.m_nCount += g.m_nCount;
+        h.m_nTotal += g.m_nTotal;
+        h.m_nMax = max(h.m_nMax, g.m_nMax);
+      } //for
+
+      level.m_sOp[op] = GetStats(h, level.m_fSeconds);
+
+      for(UINT b=0; b<NUMBUCKETS; b++)
+        all.m_nBucket[b] += h.m_nBucket[b];
+
+      all.m_nCount += h.m_nCount;
+      all.m_nTotal += h.m_nTotal;
+      all.m_nMax = max(all.m_nMax, h.m_nMax);
+    } //for
+
+    level.m_sTotal = GetStats(all, level.m_fSeconds);
+    m_vLevel.push_back(level);
+  } //for
+
+  return S_OK;
+} //Run
+
+#pragma endregion Run functions
+
+///////////////////////////////////////////////////////////////////////////////
+// Reader functions
+
+#pragma region Reader functions
+
+/// Reader function for the results.
+/// \return Results for each concurrency level in increasing order.
+
+const std::vector<SLoadLevel>& CLoadTest::GetLevels() const{
+  return m_vLevel;
+} //GetLevels
+
+/// Get the results as a JSON object, including the thread pool and memory
+/// governor statistics at the end of the run. Throughput is in operations
+/// per second and latency in milliseconds.
+/// \return JSON string.
+
+std::string CLoadTest::GetJSON() const{
+  auto json = [](const SLoadStats& s){
+    return "{\"ops\": " + std::to_string(s.m_nOps) +
+      ", \"opspersec\": " + std::to_string(s.m_fThroughput) +
+      ", \"meanms\": " + std::to_string(s.m_fMean) +
+      ", \"p50ms\": " + std::to_string(s.m_fP50) +
+      ", \"p90ms\": " + std::to_string(s.m_fP90) +
+      ", \"p99ms\": " + std::to_string(s.m_fP99) +
+      ", \"maxms\": " + std::to_string(s.m_fMax) + "}";
+  }; //json
+
+  std::string s = "{\"width\": " + std::to_string(m_nWidth) +
+    ", \"height\": " + std::to_string(m_nHeight) +
+    ", \"durationms\": " + std::to_string(m_nDuration) + ", \"mix\": {";
+
+  for(UINT op=0; op<NUMOPS; op++){
+    if(op > 0)s += ", ";
+    s += std::string("\"") + g_szOpName[op] + "\": " +
+      std::to_string(m_nWeight[op]);
+  } //for
+
+  s += "}, \"levels\": [";
+
+  for(size_t i=0; i<m_vLevel.size(); i++){
+    const SLoadLevel& level = m_vLevel[i];
+    if(i > 0)s += ", ";
+
+    s += "{\"threads\": " + std::to_string(level.m_nThreads) +
+      ", \"starved\": " + std::to_string(level.m_nStarved) +
+      ", \"seconds\": " + std::to_string(level.m_fSeconds) +
+      ", \"total\": " + json(level.m_sTotal);
+
+    for(UINT op=0; op<NUMOPS; op++)
+      if(m_nWeight[op] > 0)
+        s += std::string(", \"") + g_szOpName[op] + "\": " +
+          json(level.m_sOp[op]);
+
+    s += "}";
+  } //for
+
+  return s + "], \"pool\": " + CThreadPool::GetInstance().GetJSON() +
+    ", \"memory\": " + CMemoryGovernor::GetInstance().GetJSON() + "}";
+} //GetJSON
+
+#pragma endregion Reader functions
@@ -0,0 +1,124 @@
+/// \file LoadTest.h
+/// \brief Interface for CLoadTest.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef __LOADTEST_H__
+#define __LOADTEST_H__
+
+#include "Windows.h"
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "WangTiler.h"
+#include "TileSet.h"
+
+/// \brief Load test operation.
+
+enum class eLoadOp{
+  Generate, Render, Encode, Query, Size
+}; //eLoadOp
+
+/// \brief Load test statistics for one operation at one concurrency level.
+///
+/// Percentiles are read from a histogram with four buckets per octave, so
+/// they are accurate to within about 19 percent.
+
+struct SLoadStats{
+  UINT64 m_nOps = 0; ///< Number of operations completed.
+  double m_fThroughput = 0; ///< Operations per second.
+  double m_fMean = 0; ///< Mean latency in milliseconds.
+  double m_fP50 = 0; ///< Median latency in milliseconds.
+  double m_fP90 = 0; ///< 90th percentile latency in milliseconds.
+  double m_fP99 = 0; ///< 99th percentile latency in milliseconds.
+  double m_fMax = 0; ///< Maximum latency in milliseconds.
+}; //SLoadStats
+
+/// \brief Load test results for one concurrency level.
+
+struct SLoadLevel{
+  UINT m_nThreads = 0; ///< Number of client threads.
+  UINT m_nStarved = 0; ///< Clients that could not reserve a render buffer.
+  double m_fSeconds = 0; ///< Measured time in seconds.
+  SLoadStats m_sTotal; ///< Statistics over all operations.
+  SLoadStats m_sOp[UINT(eLoadOp::Size)]; ///< Statistics per operation.
+}; //SLoadLevel
+
+/// \brief Concurrency scaling load test.
+///
+/// The load test drives the core API from 1, 2, 4, and so on up to N client
+/// threads at once, each running a random mix of operations for a fixed
+/// time: generating a tiling, rendering it with a tile set, encoding it as a
+/// delta against the client's previous tiling, and looking up random cells
+/// of a tiling shared by all clients. Each concurrency level records the
+/// throughput and latency percentiles of every operation, so that the point
+/// where the thread pool, the memory governor, or memory bandwidth saturates
+/// shows up as throughput that stops growing and latency that starts to.
+/// Render buffers are reserved from the memory governor, and a client that
+/// cannot get one leaves rendering out of its mix.
+
+class CLoadTest{
+  private:
+    static const UINT NUMOPS = UINT(eLoadOp::Size); ///< Number of operations.
+    static const UINT NUMBUCKETS = 128; ///< Latency histogram buckets.
+    static const UINT QUERYCELLS = 1024; ///< Cells looked up per query.
+
+    /// \brief Latency histogram for one operation in one client.
+
+    struct SHistogram{
+      UINT64 m_nBucket[NUMBUCKETS] = {0}; ///< Counts per bucket.
+      UINT64 m_nCount = 0; ///< Number of operations.
+      UINT64 m_nTotal = 0; ///< Total latency in nanoseconds.
+      UINT64 m_nMax = 0; ///< Maximum latency in nanoseconds.
+    }; //SHistogram
+
+    const CTileSet* m_pTileSet = nullptr; ///< Tile set for rendering.
+    size_t m_nWidth = 0; ///< Tiling width in tiles.
+    size_t m_nHeight = 0; ///< Tiling height in tiles.
+    UINT m_nWeight[NUMOPS] = {1, 1, 1, 1}; ///< Operation mix weights.
+    DWORD m_nDuration = 1000; ///< Time per level in milliseconds.
+
+    CWangTiler* m_pShared = nullptr; ///< Tiling shared by queries.
+    std::vector<SLoadLevel> m_vLevel; ///< Results per level.
+
+    void Client(UINT seed, const std::atomic<bool>& go,
+      const std::atomic<bool>& stop, std::atomic<UINT>& ready,
+      std::atomic<UINT>& starved, SHistogram* hist) const; ///< Client thread.
+    static void Record(SHistogram& h, UINT64 ns); ///< Record latency.
+    static SLoadStats GetStats(const SHistogram& h,
+      double seconds); ///< Get stats from histogram.
+
+  public:
+    CLoadTest(const CTileSet* pTileSet, size_t w, size_t h); ///< Constructor.
+    ~CLoadTest(); ///< Destructor.
+
+    HRESULT SetMix(const std::wstring& mix); ///< Set operation mix.
+    void SetDuration(DWORD ms); ///< Set time per level.
+    HRESULT Run(UINT n); ///< Run up to n clients.
+
+    const std::vector<SLoadLevel>& GetLevels() const; ///< Get results.
+    std::string GetJSON() const; ///< Get results as JSON.
+}; //CLoadTest
+
+#endif //__LOADTEST_H__
@@ -26,6 +26,7 @@
 #include "Includes.h"
 
 #include "CMain.h"
+#include "CommandLine.h"
 
 static CMain* g_pMain = nullptr; ///< Pointer to the main class.
 
@@ -71,6 +72,23 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam){
           SaveBitmap(hWnd, g_pMain->GetBitmap());
           break;
 
+        case IDM_EXPORT_BC1: //export block-compressed texture
+        case IDM_EXPORT_BC7:
+          g_pMain->ExportDDS(nMenuId);
+          break;
+
+        case IDM_EXPORT_JPEG: //export JPEG preview
+          g_pMain->ExportJPEG();
+          break;
+
+        case IDM_EXPORT_ATLAS: //export tile atlas for shaders
+          g_pMain->ExportAtlas();
+          break;
+
+        case IDM_EXPORT_SVG: //export SVG for print
+          g_pMain->ExportSVG();
+          break;
+
         case IDM_FILE_QUIT: //so long, farewell, auf weidersehn, goodbye!
           SendMessage(hWnd, WM_CLOSE, 0, 0);
           break;
@@ -84,6 +102,12 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam){
           InvalidateRect(hWnd, nullptr, FALSE); //show in window
           break;
 
+        case IDM_TILESET_BLEND:
+          g_pMain->ToggleBlend(); //switch renderer
+          g_pMain->Draw(); //draw with current tiling
+          InvalidateRect(hWnd, nullptr, FALSE); //show in window
+          break;
+
         case IDM_HELP_HELP:
           ShellExecute(0, 0, 
             "https://ian-parberry.github.io/wangtiler/html/", 
@@ -106,10 +130,11 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam){
 
 /// \brief Winmain.  
 ///
-/// Initialize a window and start the message pump. 
+/// If the command line names a command line tool then run it and exit,
+/// otherwise initialize a window and start the message pump. 
 /// \param hInst Handle to the current instance.
 /// \param hPrev Unused.
-/// \param lpStr Unused.
+/// \param lpStr Unused, see `RunCommandLine()`.
 /// \param nShow Nonzero if window is to be shown.
 /// \return 0 If this application terminates correctly, otherwise an error code.
 
@@ -117,6 +142,9 @@ int WINAPI wWinMain(HINSTANCE hInst, HINSTANCE hPrev, LPWSTR lpStr, int nShow){
   UNREFERENCED_PARAMETER(hPrev); //nope
   UNREFERENCED_PARAMETER(lpStr); //nope nope
 
+  int nExitCode = 0; //exit code from command line tool
+  if(RunCommandLine(nExitCode))return nExitCode; //no window needed
+
   InitWindow(hInst, nShow, WndProc); //create and show a window
 
   MSG msg; //current message
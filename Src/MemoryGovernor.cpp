@@ -0,0 +1,236 @@
+/// \file MemoryGovernor.cpp
+/// \brief Code for CMemoryGovernor.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <chrono>
+
+#include "MemoryGovernor.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructors and destructors
+
+#pragma region Constructors and destructors
+
+/// If no budget is given then the budget is half of physical memory, or the
+/// available address space if that is smaller.
+/// \param budget Budget in bytes, or 0 for the default.
+
+CMemoryGovernor::CMemoryGovernor(size_t budget){
+  if(budget == 0){
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+
+    if(GlobalMemoryStatusEx(&status))
+      budget = size_t(min(status.ullTotalPhys/2, status.ullAvailVirtual));
+    else budget = size_t(1) << 30; //1GB if all else fails
+  } //if
+
+  m_nBudget = budget;
+  m_sStats.nBudget = budget;
+} //constructor
+
+#pragma endregion Constructors and destructors
+
+///////////////////////////////////////////////////////////////////////////////
+// Reservation functions
+
+#pragma region Reservation functions
+
+/// Grant a reservation and update the statistics. The mutex must be held.
+/// \param bytes Number of bytes.
+
+void CMemoryGovernor::Grant(size_t bytes){
+  m_nInUse += bytes;
+  m_sStats.nPeak = max(m_sStats.nPeak, m_nInUse);
+  m_sStats.nReservations++;
+} //Grant
+
+/// Reserve memory, waiting if necessary until it is available and every
+/// earlier waiting reservation has been granted. A waiting reservation also
+/// stops waiting and fails if the budget is lowered below its size, so that
+/// it does not hold up the reservations behind it forever.
+/// \param bytes Number of bytes.
+/// \param ms Maximum wait in milliseconds, or INFINITE.
+/// \return S_OK if the memory was reserved, E_FAIL if the reservation is
+/// larger than the budget or timed out.
+
+HRESULT CMemoryGovernor::Reserve(size_t bytes, DWORD ms){
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  if(bytes > m_nBudget)return E_FAIL; //would never fit
+
+  if(m_listQueue.empty() && m_nInUse + bytes <= m_nBudget){ //fast path
+    Grant(bytes);
+    return S_OK;
+  } //if
+
+  //join the queue and wait to be at its head with enough memory free
+
+  const auto t0 = std::chrono::steady_clock::now();
+  const auto it = m_listQueue.insert(m_listQueue.end(), bytes);
+  m_sStats.nWaits++;
+
+  auto ready = [&](){ //granted, or will never be if the budget was lowered
+    return bytes > m_nBudget ||
+      (it == m_listQueue.begin() && m_nInUse + bytes <= m_nBudget);
+  }; //ready
+
+  bool granted = true;
+
+  if(ms == INFINITE)m_cv.wait(lock, ready);
+  else granted = m_cv.wait_for(lock, std::chrono::milliseconds(ms), ready);
+
+  m_listQueue.erase(it);
+  m_cv.notify_all(); //the next in line may be able to go too
+
+  const double wait = std::chrono::duration<double, std::milli>(
+    std::chrono::steady_clock::now() - t0).count();
+  m_sStats.fTotalWait += wait;
+  m_sStats.fMaxWait = max(m_sStats.fMaxWait, wait);
+
+  if(!granted){
+    m_sStats.nTimeouts++;
+    return E_FAIL;
+  } //if
+
+  if(bytes > m_nBudget)return E_FAIL; //would never fit now
+
+  Grant(bytes);
+  return S_OK;
+} //Reserve
+
+/// Reserve memory only if it is available immediately and no other
+/// reservation is waiting.
+/// \param bytes Number of bytes.
+/// \return true if the memory was reserved.
+
+bool CMemoryGovernor::TryReserve(size_t bytes){
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if(!m_listQueue.empty() || m_nInUse + bytes > m_nBudget)
+    return false;
+
+  Grant(bytes);
+  return true;
+} //TryReserve
+
+/// Release a reservation made by `Reserve()` or `TryReserve()` and wake up
+/// any waiting reservations.
+/// \param bytes Number of bytes, which must match the reservation.
+
+void CMemoryGovernor::Release(size_t bytes){
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_nInUse -= min(bytes, m_nInUse);
+  }
+
+  m_cv.notify_all();
+} //Release
+
+#pragma endregion Reservation functions
+
+///////////////////////////////////////////////////////////////////////////////
+// Budget and statistics
+
+#pragma region Budget and statistics
+
+/// Set the budget. Reducing it below the memory currently reserved does not
+/// revoke anything, it just makes reservations wait until enough has been
+/// released. Any reservation larger than the new budget fails, including
+/// one that is already waiting.
+/// \param budget Budget in bytes.
+
+void CMemoryGovernor::SetBudget(size_t budget){
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_nBudget = budget;
+    m_sStats.nBudget = budget;
+  }
+
+  m_cv.notify_all();
+} //SetBudget
+
+/// Reader function for `m_nBudget`.
+/// \return `m_nBudget`.
+
+const size_t CMemoryGovernor::GetBudget(){
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_nBudget;
+} //GetBudget
+
+/// Get a snapshot of the statistics.
+/// \return Statistics.
+
+const SMemoryStats CMemoryGovernor::GetStats(){
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  SMemoryStats stats = m_sStats;
+  stats.nInUse = m_nInUse;
+  stats.nQueued = m_listQueue.size();
+
+  return stats;
+} //GetStats
+
+/// Get a snapshot of the statistics as a JSON object.
+/// \return JSON string.
+
+std::string CMemoryGovernor::GetJSON(){
+  const SMemoryStats s = GetStats();
+  const double mean = s.nWaits > 0? s.fTotalWait/s.nWaits: 0;
+
+  return "{\"budget\": " + std::to_string(s.nBudget) +
+    ", \"inuse\": " + std::to_string(s.nInUse) +
+    ", \"peak\": " + std::to_string(s.nPeak) +
+    ", \"queued\": " + std::to_string(s.nQueued) +
+    ", \"reservations\": " + std::to_string(s.nReservations) +
+    ", \"waits\": " + std::to_string(s.nWaits) +
+    ", \"timeouts\": " + std::to_string(s.nTimeouts) +
+    ", \"meanwaitms\": " + std::to_string(mean) +
+    ", \"maxwaitms\": " + std::to_string(s.fMaxWait) + "}";
+} //GetJSON
+
+/// Get the global memory governor shared by every job in the process.
+/// \return Reference to the global governor.
+
+CMemoryGovernor& CMemoryGovernor::GetInstance(){
+  static CMemoryGovernor governor;
+  return governor;
+} //GetInstance
+
+/// Estimate the memory used by a job that generates a Wang tiling and draws
+/// it, which is the tile index grid plus a 32-bit framebuffer.
+/// \param w Grid width in tiles.
+/// \param h Grid height in tiles.
+/// \param tw Tile width in pixels.
+/// \param th Tile height in pixels.
+/// \return Number of bytes.
+
+size_t CMemoryGovernor::GetTilingBytes(size_t w, size_t h, UINT tw, UINT th){
+  const size_t grid = w*h*sizeof(UINT);
+  const size_t frame = 4*w*tw*h*th;
+
+  return grid + frame;
+} //GetTilingBytes
+
+#pragma endregion Budget and statistics
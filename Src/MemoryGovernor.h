@@ -0,0 +1,91 @@
+/// \file MemoryGovernor.h
+/// \brief Interface for CMemoryGovernor.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef __MEMORYGOVERNOR_H__
+#define __MEMORYGOVERNOR_H__
+
+#include "Windows.h"
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <string>
+
+/// \brief Memory governor statistics.
+
+struct SMemoryStats{
+  size_t nBudget = 0; ///< Budget in bytes.
+  size_t nInUse = 0; ///< Bytes currently reserved.
+  size_t nPeak = 0; ///< Peak bytes reserved.
+  size_t nQueued = 0; ///< Number of reservations currently waiting.
+  UINT64 nReservations = 0; ///< Number of successful reservations.
+  UINT64 nWaits = 0; ///< Number of reservations that had to wait.
+  UINT64 nTimeouts = 0; ///< Number of reservations that timed out.
+  double fTotalWait = 0; ///< Total wait time in milliseconds.
+  double fMaxWait = 0; ///< Longest wait time in milliseconds.
+}; //SMemoryStats
+
+/// \brief Memory governor.
+///
+/// The memory governor enforces a global budget on the memory used by
+/// concurrent jobs. A job reserves its estimated number of bytes before
+/// allocating and releases them when it is done. If the budget is exhausted
+/// then the reservation blocks until enough memory has been released.
+/// Waiting reservations are granted strictly in the order they were made, so
+/// a large job cannot be starved by a stream of small ones. A reservation
+/// larger than the whole budget fails instead of waiting forever, even if the
+/// budget is only lowered below it while it waits.
+/// All functions are thread-safe.
+
+class CMemoryGovernor{
+  private:
+    size_t m_nBudget = 0; ///< Budget in bytes.
+    size_t m_nInUse = 0; ///< Bytes currently reserved.
+    std::list<size_t> m_listQueue; ///< Waiting reservations, oldest first.
+
+    SMemoryStats m_sStats; ///< Statistics.
+
+    std::mutex m_mutex; ///< Guards everything.
+    std::condition_variable m_cv; ///< Signalled when memory may be available.
+
+    void Grant(size_t bytes); ///< Grant reservation with lock held.
+
+  public:
+    CMemoryGovernor(size_t budget=0); ///< Constructor.
+
+    HRESULT Reserve(size_t bytes, DWORD ms=INFINITE); ///< Reserve, waiting.
+    bool TryReserve(size_t bytes); ///< Reserve without waiting.
+    void Release(size_t bytes); ///< Release reservation.
+
+    void SetBudget(size_t budget); ///< Set budget.
+    const size_t GetBudget(); ///< Get budget.
+    const SMemoryStats GetStats(); ///< Get statistics.
+    std::string GetJSON(); ///< Get statistics as JSON.
+
+    static CMemoryGovernor& GetInstance(); ///< Get global governor.
+    static size_t GetTilingBytes(size_t w, size_t h,
+      UINT tw, UINT th); ///< Estimate memory used by a tiling job.
+}; //CMemoryGovernor
+
+#endif //__MEMORYGOVERNOR_H__
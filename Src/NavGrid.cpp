@@ -0,0 +1,529 @@
+/// \file NavGrid.cpp
+/// \brief Code for CNavGrid.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+
+#include "NavGrid.h"
+#include "ThreadPool.h"
+
+static const UINT NAV_INFINITY = UINT_MAX; ///< Cost of an unreachable cell.
+static const size_t NAV_NONE = size_t(-1); ///< No cell.
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructors and destructors
+
+#pragma region Constructors and destructors
+
+/// \param chunk Cluster width and height in tiles.
+
+CNavGrid::CNavGrid(UINT chunk):
+  m_nChunk(max(1U, chunk)){
+} //constructor
+
+#pragma endregion Constructors and destructors
+
+///////////////////////////////////////////////////////////////////////////////
+// Bake function
+
+#pragma region Bake function
+
+/// Bake the navigation grid from a Wang tiling by copying navigation mask
+/// rows, one row of tiles per task on the shared thread pool, and discard
+/// any cached cluster summaries. This must not be called while a query is
+/// running, nor on a tiling with super-tiles, since those cells hold filler
+/// tiles (see `CSuperTiler`).
+/// \param tiler Wang tiler.
+/// \param tileset Tile set with navigation masks.
+/// \return S_OK for success, E_FAIL if the tile set has no navigation masks
+/// or the tiling refers to a missing tile.
+
+HRESULT CNavGrid::Bake(const CWangTiler& tiler, const CTileSet& tileset){
+  const size_t k = tileset.GetNavSize(); //mask size
+  if(k == 0)return E_FAIL;
+
+  const size_t w = tiler.GetWidth(), h = tiler.GetHeight();
+
+  for(size_t i=0; i<h; i++) //make sure indices are in range
+    for(size_t j=0; j<w; j++)
+      if(tiler(i, j) >= tileset.GetSize())return E_FAIL;
+
+  m_nWidth = w*k;
+  m_nHeight = h*k;
+  m_vCost.resize(m_nWidth*m_nHeight);
+
+  CThreadPool::GetInstance().ParallelFor(h, 1, [&](size_t i0, size_t i1){
+    for(size_t i=i0; i<i1; i++)
+      for(size_t j=0; j<w; j++){
+        const BYTE* pSrc = tileset.GetNavMask(UINT(tiler(i, j)));
+        BYTE* p = &m_vCost[i*k*m_nWidth + j*k];
+
+        for(size_t y=0; y<k; y++)
+          memcpy(p + y*m_nWidth, pSrc + y*k, k);
+      } //for
+  }); //ParallelFor
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  m_nClusterSize = m_nChunk*k;
+  m_nClustersX = (m_nWidth + m_nClusterSize - 1)/m_nClusterSize;
+  m_nClustersY = (m_nHeight + m_nClusterSize - 1)/m_nClusterSize;
+  m_vCluster.clear();
+  m_vCluster.resize(m_nClustersX*m_nClustersY);
+  m_nReady = 0;
+
+  return S_OK;
+} //Bake
+
+#pragma endregion Bake function
+
+///////////////////////////////////////////////////////////////////////////////
+// Cluster functions
+
+#pragma region Cluster functions
+
+/// Get the cluster that a cell is in.
+/// \param cell Cell index in row-major order.
+/// \return Cluster index in row-major order.
+
+size_t CNavGrid::GetClusterIndex(size_t cell) const{
+  const size_t x = cell%m_nWidth, y = cell/m_nWidth;
+  return (y/m_nClusterSize)*m_nClustersX + x/m_nClusterSize;
+} //GetClusterIndex
+
+/// Get the rectangle of cells in a cluster. Clusters at the right and
+/// bottom of the grid may be smaller than the rest.
+/// \param c Cluster index.
+/// \return Rectangle of cells.
+
+CNavGrid::SRect CNavGrid::GetClusterRect(size_t c) const{
+  SRect r;
+
+  r.m_nX0 = (c%m_nClustersX)*m_nClusterSize;
+  r.m_nY0 = (c/m_nClustersX)*m_nClusterSize;
+  r.m_nX1 = min(r.m_nX0 + m_nClusterSize, m_nWidth);
+  r.m_nY1 = min(r.m_nY0 + m_nClusterSize, m_nHeight);
+
+  return r;
+} //GetClusterRect
+
+/// Add the transition nodes along one side of a cluster border. A run of
+/// border cells that can be walked on from both sides gets a node at each
+/// end if it is at least 6 cells long, otherwise one in the middle. Both
+/// clusters that share a border find the same runs, so every node has a
+/// partner across the border.
+/// \param a First border cell on this side.
+/// \param b First border cell on the other side.
+/// \param step Distance between consecutive border cells.
+/// \param n Number of border cells.
+/// \param v [IN, OUT] Nodes on this side.
+
+void CNavGrid::AddEntrances(size_t a, size_t b, size_t step, size_t n,
+  std::vector<size_t>& v) const
+{
+  size_t start = 0; //start of current run
+
+  for(size_t i=0; i<=n; i++){
+    const bool open = i < n &&
+      m_vCost[a + i*step] > 0 && m_vCost[b + i*step] > 0;
+
+    if(!open){
+      if(i - start >= 6){ //long run
+        v.push_back(a + start*step);
+        v.push_back(a + (i - 1)*step);
+      } //if
+
+      else if(i > start) //short run
+        v.push_back(a + ((start + i - 1)/2)*step);
+
+      start = i + 1;
+    } //if
+  } //for
+} //AddEntrances
+
+/// Compute a cluster summary: find the transition nodes on each border that
+/// has a cluster on the other side, then find the cheapest path inside the
+/// cluster from each node to all of the others.
+/// \param c Cluster index.
+/// \param cluster [OUT] Cluster summary.
+
+void CNavGrid::Summarize(size_t c, SCluster& cluster) const{
+  const SRect r = GetClusterRect(c);
+  const size_t W = m_nWidth;
+  std::vector<size_t>& v = cluster.m_vNode;
+
+  if(r.m_nX0 > 0) //left
+    AddEntrances(r.m_nY0*W + r.m_nX0, r.m_nY0*W + r.m_nX0 - 1, W,
+      r.m_nY1 - r.m_nY0, v);
+
+  if(r.m_nX1 < m_nWidth) //right
+    AddEntrances(r.m_nY0*W + r.m_nX1 - 1, r.m_nY0*W + r.m_nX1, W,
+      r.m_nY1 - r.m_nY0, v);
+
+  if(r.m_nY0 > 0) //top
+    AddEntrances(r.m_nY0*W + r.m_nX0, (r.m_nY0 - 1)*W + r.m_nX0, 1,
+      r.m_nX1 - r.m_nX0, v);
+
+  if(r.m_nY1 < m_nHeight) //bottom
+    AddEntrances((r.m_nY1 - 1)*W + r.m_nX0, r.m_nY1*W + r.m_nX0, 1,
+      r.m_nX1 - r.m_nX0, v);
+
+  std::sort(v.begin(), v.end());
+  v.erase(std::unique(v.begin(), v.end()), v.end());
+
+  const size_t n = v.size();
+  const size_t lw = r.m_nX1 - r.m_nX0; //cluster width
+  std::vector<UINT> dist; //distances from one node
+
+  cluster.m_vCost.assign(n*n, NAV_INFINITY);
+
+  for(size_t i=0; i<n; i++){
+    Search(v[i], NAV_NONE, r, dist, nullptr);
+
+    for(size_t j=0; j<n; j++)
+      cluster.m_vCost[i*n + j] =
+        dist[(v[j]/W - r.m_nY0)*lw + v[j]%W - r.m_nX0];
+  } //for
+} //Summarize
+
+/// Get a cluster summary, computing it first if this is the first time that
+/// it has been asked for. The summary is computed without holding the mutex,
+/// so that a query that needs a new summary does not hold up queries in
+/// other clusters, and is then stored under a short lock. If two queries
+/// need the same new summary at once then both compute it and the first to
+/// finish stores it. Summaries never move once the grid is baked, so the
+/// reference stays valid until the next bake.
+/// \param c Cluster index.
+/// \return Cluster summary.
+
+const CNavGrid::SCluster& CNavGrid::GetCluster(size_t c){
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_vCluster[c].m_bReady)return m_vCluster[c];
+  }
+
+  SCluster summary; //computed outside the lock
+  Summarize(c, summary);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  SCluster& cluster = m_vCluster[c];
+
+  if(!cluster.m_bReady){
+    cluster.m_vNode = std::move(summary.m_vNode);
+    cluster.m_vCost = std::move(summary.m_vCost);
+    cluster.m_bReady = true;
+    m_nReady++;
+  } //if
+
+  return cluster;
+} //GetCluster
+
+#pragma endregion Cluster functions
+
+///////////////////////////////////////////////////////////////////////////////
+// Search functions
+
+#pragma region Search functions
+
+/// Find the cheapest paths inside a rectangle from a source cell. With a
+/// destination this is A* with the Manhattan distance as heuristic, which is
+/// admissible since every cell costs at least 1, and it stops when the
+/// destination is reached. Without one it is Dijkstra's algorithm over the
+/// whole rectangle.
+/// \param src Source cell, inside the rectangle.
+/// \param dest Destination cell inside the rectangle, or `NAV_NONE`.
+/// \param r Rectangle.
+/// \param dist [OUT] Cost from the source to each cell of the rectangle in
+/// row-major order, `NAV_INFINITY` if unreachable or not yet reached.
+/// \param pPath [OUT] Pointer to the path from source to destination
+/// inclusive, or **nullptr** if it is not wanted.
+/// \return true if the destination was reached, or if there is none.
+
+bool CNavGrid::Search(size_t src, size_t dest, const SRect& r,
+  std::vector<UINT>& dist, std::vector<size_t>* pPath) const
+{
+  const size_t W = m_nWidth;
+  const size_t lw = r.m_nX1 - r.m_nX0, lh = r.m_nY1 - r.m_nY0;
+  const size_t s = (src/W - r.m_nY0)*lw + src%W - r.m_nX0; //local source
+  const size_t d = dest == NAV_NONE? NAV_NONE:
+    (dest/W - r.m_nY0)*lw + dest%W - r.m_nX0; //local destination
+
+  auto h = [&](size_t i){ //heuristic
+    if(d == NAV_NONE)return UINT(0);
+    const size_t x = i%lw, y = i/lw, dx = d%lw, dy = d/lw;
+    return UINT((x > dx? x - dx: dx - x) + (y > dy? y - dy: dy - y));
+  }; //h
+
+  typedef std::pair<UINT, size_t> SEntry; //estimate and local cell
+  std::priority_queue<SEntry, std::vector<SEntry>, std::greater<SEntry>> open;
+  std::vector<size_t> parent(pPath? lw*lh: 0, NAV_NONE);
+
+  dist.assign(lw*lh, NAV_INFINITY);
+  dist[s] = 0;
+  open.push(SEntry(h(s), s));
+
+  while(!open.empty()){
+    const SEntry e = open.top();
+    open.pop();
+
+    const size_t i = e.second;
+    if(e.first - h(i) > dist[i])continue; //stale entry
+    if(i == d)break;
+
+    const size_t x = i%lw, y = i/lw;
+    const size_t nbr[4] = { //neighbors, NAV_NONE if outside
+      x > 0? i - 1: NAV_NONE, x + 1 < lw? i + 1: NAV_NONE,
+      y > 0? i - lw: NAV_NONE, y + 1 < lh? i + lw: NAV_NONE};
+
+    for(size_t j: nbr){
+      if(j == NAV_NONE)continue;
+
+      const BYTE c = m_vCost[(r.m_nY0 + j/lw)*W + r.m_nX0 + j%lw];
+      if(c == 0 || dist[i] + c >= dist[j])continue;
+
+      dist[j] = dist[i] + c;
+      if(pPath)parent[j] = i;
+      open.push(SEntry(dist[j] + h(j), j));
+    } //for
+  } //while
+
+  if(d == NAV_NONE)return true;
+  if(dist[d] == NAV_INFINITY)return false;
+
+  if(pPath){
+    const size_t n = pPath->size(); //append after existing cells
+
+    for(size_t i=d; i!=NAV_NONE; i=parent[i])
+      pPath->push_back((r.m_nY0 + i/lw)*W + r.m_nX0 + i%lw);
+
+    std::reverse(pPath->begin() + n, pPath->end());
+  } //if
+
+  return true;
+} //Search
+
+/// Find the cheapest path between two cells, or nearly the cheapest, using
+/// HPA*. If both cells are in the same cluster and there is a path inside it
+/// then that is used. Otherwise the source and destination are connected to
+/// the transition nodes of their clusters, A* finds a path through the graph
+/// of transition nodes, and each of its steps is refined into cells.
+/// \param x0 Source column.
+/// \param y0 Source row.
+/// \param x1 Destination column.
+/// \param y1 Destination row.
+/// \param path [OUT] Cells of the path, source and destination inclusive, as
+/// indices in row-major order.
+/// \param pCost [OUT] Pointer to the path cost, or **nullptr**.
+/// \return S_OK if a path was found, E_FAIL if either end is outside the
+/// grid or cannot be walked on, or there is no path.
+
+HRESULT CNavGrid::FindPath(size_t x0, size_t y0, size_t x1, size_t y1,
+  std::vector<size_t>& path, UINT* pCost)
+{
+  path.clear();
+
+  if(x0 >= m_nWidth || y0 >= m_nHeight || x1 >= m_nWidth || y1 >= m_nHeight)
+    return E_FAIL;
+
+  const size_t W = m_nWidth;
+  const size_t src = y0*W + x0, dest = y1*W + x1;
+  if(m_vCost[src] == 0 || m_vCost[dest] == 0)return E_FAIL;
+
+  const size_t cs = GetClusterIndex(src), cd = GetClusterIndex(dest);
+  const SRect rs = GetClusterRect(cs), rd = GetClusterRect(cd);
+  std::vector<UINT> dist; //scratch distances
+
+  auto local = [&](const SRect& r, size_t cell){ //index of cell in r
+    return (cell/W - r.m_nY0)*(r.m_nX1 - r.m_nX0) + cell%W - r.m_nX0;
+  }; //local
+
+  auto cost = [&](){ //sum of costs of cells entered
+    UINT total = 0;
+
+    for(size_t i=1; i<path.size(); i++)
+      total += m_vCost[path[i]];
+
+    return total;
+  }; //cost
+
+  if(cs == cd && Search(src, dest, rs, dist, &path)){ //path inside cluster
+    if(pCost)*pCost = cost();
+    return S_OK;
+  } //if
+
+  path.clear();
+
+  std::vector<UINT> from; //costs from source within its cluster
+  std::vector<UINT> to; //costs to destination within its cluster
+  Search(src, NAV_NONE, rs, from, nullptr);
+  Search(dest, NAV_NONE, rd, to, nullptr);
+
+  auto h = [&](size_t cell){ //Manhattan distance to destination
+    const size_t x = cell%W, y = cell/W;
+    return UINT((x > x1? x - x1: x1 - x) + (y > y1? y - y1: y1 - y));
+  }; //h
+
+  typedef std::pair<UINT, size_t> SEntry; //estimate and cell
+  std::priority_queue<SEntry, std::vector<SEntry>, std::greater<SEntry>> open;
+  std::unordered_map<size_t, UINT> g; //best known cost from source
+  std::unordered_map<size_t, size_t> parent; //previous abstract node
+
+  auto relax = [&](size_t u, size_t v, UINT c){ //edge u to v of cost c
+    if(c == NAV_INFINITY)return;
+
+    const UINT gv = g[u] + c;
+    auto it = g.find(v);
+
+    if(it == g.end() || gv < it->second){
+      g[v] = gv;
+      parent[v] = u;
+      open.push(SEntry(gv + h(v), v));
+    } //if
+  }; //relax
+
+  g[src] = 0;
+  open.push(SEntry(h(src), src));
+  bool found = false;
+
+  while(!open.empty()){
+    const SEntry e = open.top();
+    open.pop();
+
+    const size_t u = e.second;
+    if(e.first - h(u) > g[u])continue; //stale entry
+
+    if(u == dest){
+      found = true;
+      break;
+    } //if
+
+    const size_t c = GetClusterIndex(u);
+    const SCluster& cluster = GetCluster(c);
+    const std::vector<size_t>& v = cluster.m_vNode;
+
+    if(u == src) //source to nodes of its cluster
+      for(size_t n: v)
+        relax(u, n, from[local(rs, n)]);
+
+    if(c == cd){ //to destination in its cluster
+      const UINT d = to[local(rd, u)]; //cost from destination to u
+      if(d != NAV_INFINITY)relax(u, dest, d - m_vCost[u] + m_vCost[dest]);
+    } //if
+
+    const auto it = std::lower_bound(v.begin(), v.end(), u);
+    if(it == v.end() || *it != u)continue; //not a transition node
+
+    const size_t i = it - v.begin(); //index of u in cluster
+
+    for(size_t j=0; j<v.size(); j++) //other nodes of the same cluster
+      if(j != i)relax(u, v[j], cluster.m_vCost[i*v.size() + j]);
+
+    const size_t x = u%W, y = u/W;
+    const size_t nbr[4] = { //neighbors, NAV_NONE if outside the grid
+      x > 0? u - 1: NAV_NONE, x + 1 < W? u + 1: NAV_NONE,
+      y > 0? u - W: NAV_NONE, y + 1 < m_nHeight? u + W: NAV_NONE};
+
+    for(size_t p: nbr){ //partners across cluster borders
+      if(p == NAV_NONE || m_vCost[p] == 0)continue;
+
+      const size_t cp = GetClusterIndex(p);
+      if(cp == c)continue;
+
+      const std::vector<size_t>& w = GetCluster(cp).m_vNode;
+      if(std::binary_search(w.begin(), w.end(), p))
+        relax(u, p, m_vCost[p]);
+    } //for
+  } //while
+
+  if(!found)return E_FAIL;
+
+  std::vector<size_t> node; //abstract path, destination first
+
+  for(size_t u=dest; u!=src; u=parent[u])
+    node.push_back(u);
+
+  node.push_back(src);
+  std::reverse(node.begin(), node.end());
+  path.push_back(src);
+
+  for(size_t i=1; i<node.size(); i++){ //refine each step
+    const size_t a = node[i - 1], b = node[i];
+    const size_t ca = GetClusterIndex(a);
+
+    if(ca != GetClusterIndex(b))path.push_back(b); //border crossing
+
+    else{ //path inside one cluster, without repeating its first cell
+      path.pop_back();
+      Search(a, b, GetClusterRect(ca), dist, &path);
+    } //else
+  } //for
+
+  if(pCost)*pCost = cost();
+  return S_OK;
+} //FindPath
+
+#pragma endregion Search functions
+
+///////////////////////////////////////////////////////////////////////////////
+// Reader functions
+
+#pragma region Reader functions
+
+/// Reader function for the width.
+/// \return Width in cells.
+
+const size_t CNavGrid::GetWidth() const{
+  return m_nWidth;
+} //GetWidth
+
+/// Reader function for the height.
+/// \return Height in cells.
+
+const size_t CNavGrid::GetHeight() const{
+  return m_nHeight;
+} //GetHeight
+
+/// Get the movement cost of a cell.
+/// \param x Column.
+/// \param y Row.
+/// \return Movement cost, 0 if the cell cannot be walked on.
+
+const BYTE CNavGrid::GetCost(size_t x, size_t y) const{
+  return m_vCost[y*m_nWidth + x];
+} //GetCost
+
+/// Get the number of cluster summaries that have been computed since the
+/// grid was baked.
+/// \return Number of cluster summaries.
+
+const size_t CNavGrid::GetClustersReady(){
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_nReady;
+} //GetClustersReady
+
+#pragma endregion Reader functions
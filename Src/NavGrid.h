@@ -0,0 +1,112 @@
+/// \file NavGrid.h
+/// \brief Interface for CNavGrid.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef __NAVGRID_H__
+#define __NAVGRID_H__
+
+#include "Windows.h"
+#include <mutex>
+#include <vector>
+
+#include "WangTiler.h"
+#include "TileSet.h"
+
+/// \brief Navigation grid with hierarchical pathfinding.
+///
+/// The navigation grid is baked from a Wang tiling by copying each tile's
+/// navigation mask from the tile set into place, giving a grid of movement
+/// costs in which 0 means that a cell cannot be walked on. Paths move
+/// between edge-adjacent cells, and the cost of a path is the sum of the
+/// costs of the cells that it enters.
+///
+/// Path queries use HPA*. The grid is divided into square clusters aligned
+/// to chunks of the tiling. Wherever a run of cells along the border between
+/// two clusters can be walked on from both sides there is an entrance, with a
+/// transition node at each end of a long run or in the middle of a short one.
+/// A cluster's summary is the list of its transition nodes and the cost of
+/// the cheapest path inside the cluster between every pair of them. A query
+/// searches the graph of transition nodes with A* and then refines each
+/// step of the abstract path with A* inside one cluster. Summaries are
+/// computed the first time a query needs them and cached, so a query on a
+/// huge map only pays for the clusters near the path. Queries are
+/// thread-safe.
+
+class CNavGrid{
+  private:
+    /// \brief Cluster summary.
+
+    struct SCluster{
+      bool m_bReady = false; ///< Whether the summary has been computed.
+      std::vector<size_t> m_vNode; ///< Transition nodes, sorted.
+      std::vector<UINT> m_vCost; ///< Path costs between nodes, row-major.
+    }; //SCluster
+
+    /// \brief Rectangle of cells, including the first row and column but
+    /// excluding the last.
+
+    struct SRect{
+      size_t m_nX0 = 0; ///< First column.
+      size_t m_nY0 = 0; ///< First row.
+      size_t m_nX1 = 0; ///< One past the last column.
+      size_t m_nY1 = 0; ///< One past the last row.
+    }; //SRect
+
+    size_t m_nWidth = 0; ///< Width in cells.
+    size_t m_nHeight = 0; ///< Height in cells.
+    std::vector<BYTE> m_vCost; ///< Movement cost per cell, 0 if blocked.
+
+    UINT m_nChunk = 8; ///< Cluster size in tiles.
+    size_t m_nClusterSize = 0; ///< Cluster size in cells.
+    size_t m_nClustersX = 0; ///< Number of clusters across.
+    size_t m_nClustersY = 0; ///< Number of clusters down.
+    std::vector<SCluster> m_vCluster; ///< Cluster summaries.
+    size_t m_nReady = 0; ///< Number of summaries computed.
+    std::mutex m_mutex; ///< Guards cluster summaries.
+
+    size_t GetClusterIndex(size_t cell) const; ///< Get cluster of a cell.
+    SRect GetClusterRect(size_t c) const; ///< Get cells of a cluster.
+    void AddEntrances(size_t a, size_t b, size_t step, size_t n,
+      std::vector<size_t>& v) const; ///< Add border nodes.
+    const SCluster& GetCluster(size_t c); ///< Get cluster summary.
+    void Summarize(size_t c, SCluster& cluster) const; ///< Compute summary.
+
+    bool Search(size_t src, size_t dest, const SRect& r,
+      std::vector<UINT>& dist, std::vector<size_t>* pPath) const; ///< A*.
+
+  public:
+    CNavGrid(UINT chunk=8); ///< Constructor.
+
+    HRESULT Bake(const CWangTiler& tiler,
+      const CTileSet& tileset); ///< Bake from a tiling.
+    HRESULT FindPath(size_t x0, size_t y0, size_t x1, size_t y1,
+      std::vector<size_t>& path, UINT* pCost=nullptr); ///< Find a path.
+
+    const size_t GetWidth() const; ///< Get width in cells.
+    const size_t GetHeight() const; ///< Get height in cells.
+    const BYTE GetCost(size_t x, size_t y) const; ///< Get movement cost.
+    const size_t GetClustersReady(); ///< Get number of summaries computed.
+}; //CNavGrid
+
+#endif //__NAVGRID_H__
@@ -0,0 +1,106 @@
+/// \file Random.h
+/// \brief Interface and code for CRandom.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef __RANDOM_H__
+#define __RANDOM_H__
+
+#include "Windows.h"
+
+/// \brief Pseudo-random number generator.
+///
+/// A PCG32 generator, which has 64 bits of state and returns 32 bits at a
+/// time. Everything is `constexpr` so that the same generator can be run by
+/// the compiler, and it gives the same sequence for the same seed with every
+/// compiler and standard library, which `std::default_random_engine` and
+/// `std::uniform_int_distribution` do not. Since everything is `constexpr`,
+/// the code is here rather than in a .cpp file.
+
+class CRandom{
+  private:
+    UINT64 m_nState = 0; ///< State.
+
+  public:
+    constexpr CRandom(UINT seed=0); ///< Constructor.
+
+    constexpr void Seed(UINT seed); ///< Seed the generator.
+    constexpr UINT Next(); ///< Get 32 pseudo-random bits.
+    constexpr UINT GetBits(UINT n); ///< Get n pseudo-random bits.
+}; //CRandom
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructors and destructors
+
+#pragma region Constructors and destructors
+
+/// \param seed Seed.
+
+constexpr CRandom::CRandom(UINT seed){
+  Seed(seed);
+} //constructor
+
+#pragma endregion Constructors and destructors
+
+///////////////////////////////////////////////////////////////////////////////
+// Generator functions
+
+#pragma region Generator functions
+
+/// Seed the generator the way that the PCG32 reference code does.
+/// \param seed Seed.
+
+constexpr void CRandom::Seed(UINT seed){
+  m_nState = 0;
+  Next();
+  m_nState += seed;
+  Next();
+} //Seed
+
+/// Advance the state with a linear congruential step and return a permuted
+/// version of the old state: an xor-shift of its high bits, rotated by an
+/// amount taken from its top 5 bits.
+/// \return 32 pseudo-random bits.
+
+constexpr UINT CRandom::Next(){
+  const UINT64 old = m_nState;
+  m_nState = old*6364136223846793005ULL + 1442695040888963407ULL;
+
+  const UINT x = UINT(((old >> 18) ^ old) >> 27); //xor-shifted
+  const UINT r = UINT(old >> 59); //rotation
+
+  return x >> r | x << ((32 - r) & 31);
+} //Next
+
+/// Get a small number of pseudo-random bits, taken from the top of the next
+/// 32, since those are the best bits of a PCG32 output.
+/// \param n Number of bits, from 1 to 32.
+/// \return Number from 0 to \f$2^n - 1\f$.
+
+constexpr UINT CRandom::GetBits(UINT n){
+  return Next() >> (32 - n);
+} //GetBits
+
+#pragma endregion Generator functions
+
+#endif //__RANDOM_H__
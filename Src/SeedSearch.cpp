@@ -0,0 +1,196 @@
+/// \file SeedSearch.cpp
+/// \brief Code for CSeedSearch.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <algorithm>
+#include <cmath>
+
+#include "SeedSearch.h"
+#include "ThreadPool.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructors and destructors
+
+#pragma region Constructors and destructors
+
+/// \param w Tiling width in tiles.
+/// \param h Tiling height in tiles.
+/// \param k Number of best seeds to keep.
+
+CSeedSearch::CSeedSearch(size_t w, size_t h, size_t k):
+  m_nWidth(w), m_nHeight(h), m_nK(max(size_t(1), k)),
+  m_fThreshold(-INFINITY), m_nEvaluated(0), m_nAborted(0)
+{
+  m_vHeap.reserve(m_nK + 1);
+} //constructor
+
+#pragma endregion Constructors and destructors
+
+///////////////////////////////////////////////////////////////////////////////
+// Top K functions
+
+#pragma region Top K functions
+
+/// Compare seeds by score, breaking ties in favor of the smaller seed.
+/// \param a A seed and its score.
+/// \param b Another seed and its score.
+/// \return true if `a` is better than `b`.
+
+bool CSeedSearch::Better(const SSeedScore& a, const SSeedScore& b){
+  return a.m_fScore > b.m_fScore ||
+    (a.m_fScore == b.m_fScore && a.m_nSeed < b.m_nSeed);
+} //Better
+
+/// Offer a seed for the top K. The heap has the worst kept seed at the top,
+/// and once it is full the threshold is that seed's score, which tasks
+/// read without locking to decide whether to abandon a tiling.
+/// \param s Seed and score.
+
+void CSeedSearch::Offer(const SSeedScore& s){
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if(m_vHeap.size() == m_nK){
+    if(!Better(s, m_vHeap.front()))return; //not good enough
+    std::pop_heap(m_vHeap.begin(), m_vHeap.end(), Better);
+    m_vHeap.pop_back();
+  } //if
+
+  m_vHeap.push_back(s);
+  std::push_heap(m_vHeap.begin(), m_vHeap.end(), Better);
+
+  if(m_vHeap.size() == m_nK)
+    m_fThreshold = m_vHeap.front().m_fScore;
+} //Offer
+
+#pragma endregion Top K functions
+
+///////////////////////////////////////////////////////////////////////////////
+// Search function
+
+#pragma region Search function
+
+/// Search a range of seeds on the shared thread pool. This can be called
+/// more than once to search several ranges, and the top K accumulates.
+/// A tiling is abandoned when the metric's bound falls strictly below the
+/// threshold, so that ties are always resolved by seed. The range must not
+/// run past the largest seed, since it would wrap around to seed 0 and
+/// search seeds that may have been searched already.
+/// \param first First seed.
+/// \param count Number of seeds.
+/// \param metric Tiling metric, which is cloned for each task.
+/// \return S_OK for success, E_FAIL if the range runs past `UINT_MAX`.
+
+HRESULT CSeedSearch::Run(UINT first, UINT count, const CTilingMetric& metric){
+  if(UINT64(first) + count > UINT64(UINT_MAX) + 1)return E_FAIL; //wraps
+
+  CThreadPool::GetInstance().ParallelFor(count, 4096, [&](size_t k0, size_t k1){
+    CWangTiler tiler(m_nWidth, m_nHeight);
+    CTilingMetric* pMetric = metric.Clone();
+    UINT64 evaluated = 0, aborted = 0; //local counts
+
+    for(size_t k=k0; k<k1; k++){
+      const UINT seed = first + UINT(k);
+      bool abort = false;
+
+      tiler.Seed(seed);
+      pMetric->Reset(tiler);
+
+      for(size_t i=0; i<m_nHeight && !abort; i++){
+        tiler.GenerateRow(i);
+        pMetric->AddRow(tiler, i);
+        abort = pMetric->GetBound() < m_fThreshold;
+      } //for
+
+      if(abort)aborted++;
+
+      else{
+        SSeedScore s;
+        s.m_nSeed = seed;
+        s.m_fScore = pMetric->GetScore(tiler);
+        evaluated++;
+
+        if(s.m_fScore >= m_fThreshold) //worth locking for
+          Offer(s);
+      } //else
+    } //for
+
+    delete pMetric;
+    m_nEvaluated += evaluated;
+    m_nAborted += aborted;
+  }); //ParallelFor
+
+  return S_OK;
+} //Run
+
+#pragma endregion Search function
+
+///////////////////////////////////////////////////////////////////////////////
+// Reader functions
+
+#pragma region Reader functions
+
+/// Get the best seeds found so far.
+/// \param v [OUT] Seeds and scores, best first.
+
+void CSeedSearch::GetResults(std::vector<SSeedScore>& v){
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  v = m_vHeap;
+  std::sort(v.begin(), v.end(), Better);
+} //GetResults
+
+/// Get the number of seeds whose tilings were scored in full.
+/// \return Number of seeds.
+
+const UINT64 CSeedSearch::GetEvaluated() const{
+  return m_nEvaluated;
+} //GetEvaluated
+
+/// Get the number of seeds whose tilings were abandoned early.
+/// \return Number of seeds.
+
+const UINT64 CSeedSearch::GetAborted() const{
+  return m_nAborted;
+} //GetAborted
+
+/// Get the results as a JSON object.
+/// \return JSON string.
+
+std::string CSeedSearch::GetJSON(){
+  std::vector<SSeedScore> v;
+  GetResults(v);
+
+  std::string s = "{\"evaluated\": " + std::to_string(GetEvaluated()) +
+    ", \"aborted\": " + std::to_string(GetAborted()) + ", \"best\": [";
+
+  for(size_t i=0; i<v.size(); i++){
+    if(i > 0)s += ", ";
+    s += "{\"seed\": " + std::to_string(v[i].m_nSeed) +
+      ", \"score\": " + std::to_string(v[i].m_fScore) + "}";
+  } //for
+
+  return s + "]}";
+} //GetJSON
+
+#pragma endregion Reader functions
@@ -0,0 +1,82 @@
+/// \file SeedSearch.h
+/// \brief Interface for CSeedSearch.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef __SEEDSEARCH_H__
+#define __SEEDSEARCH_H__
+
+#include "Windows.h"
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "TilingMetric.h"
+
+/// \brief Seed and score.
+
+struct SSeedScore{
+  UINT m_nSeed = 0; ///< Seed.
+  double m_fScore = 0; ///< Score.
+}; //SSeedScore
+
+/// \brief Seed search.
+///
+/// Generates the Wang tilings for a range of seeds in parallel, scores each
+/// of them with a tiling metric, and keeps the best K. Each task reuses one
+/// tiler and one metric for a whole chunk of seeds, so there is no
+/// allocation per seed. Tilings are generated and scored one row at a time,
+/// and a tiling is abandoned as soon as the metric's bound says that it
+/// cannot make the top K. Ties are broken in favor of the smaller seed, so
+/// the result does not depend on the order in which seeds are evaluated.
+
+class CSeedSearch{
+  private:
+    size_t m_nWidth = 0; ///< Tiling width in tiles.
+    size_t m_nHeight = 0; ///< Tiling height in tiles.
+    size_t m_nK = 0; ///< Number of best seeds to keep.
+
+    std::vector<SSeedScore> m_vHeap; ///< Best seeds, worst at the top.
+    std::mutex m_mutex; ///< Guards heap.
+    std::atomic<double> m_fThreshold; ///< Score of worst kept seed.
+
+    std::atomic<UINT64> m_nEvaluated; ///< Number of seeds scored in full.
+    std::atomic<UINT64> m_nAborted; ///< Number of seeds abandoned.
+
+    static bool Better(const SSeedScore& a, const SSeedScore& b); ///< Compare.
+    void Offer(const SSeedScore& s); ///< Offer seed for top K.
+
+  public:
+    CSeedSearch(size_t w, size_t h, size_t k); ///< Constructor.
+
+    HRESULT Run(UINT first, UINT count,
+      const CTilingMetric& metric); ///< Search.
+
+    void GetResults(std::vector<SSeedScore>& v); ///< Get best seeds.
+    const UINT64 GetEvaluated() const; ///< Get number of seeds scored.
+    const UINT64 GetAborted() const; ///< Get number of seeds abandoned.
+    std::string GetJSON(); ///< Get results as JSON.
+}; //CSeedSearch
+
+#endif //__SEEDSEARCH_H__
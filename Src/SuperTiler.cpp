@@ -0,0 +1,351 @@
+/// \file SuperTiler.cpp
+/// \brief Code for CSuperTiler.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <algorithm>
+
+#include "SuperTiler.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructors and destructors
+
+#pragma region Constructors and destructors
+
+/// Seed the pseudo-random number generator from the clock, the same way that
+/// the Wang tiler does.
+
+CSuperTiler::CSuperTiler(){
+  m_cRandom.Seed(timeGetTime()); //reset PRNG
+} //constructor
+
+#pragma endregion Constructors and destructors
+
+///////////////////////////////////////////////////////////////////////////////
+// Occupancy functions
+
+#pragma region Occupancy functions
+
+/// Test whether any of a run of cells in one row is occupied. The run may
+/// straddle two words of the bitset, but no more.
+/// \param i Row number.
+/// \param j Column of the first cell.
+/// \param n Number of cells, less than 64.
+/// \return true if any of the cells is occupied.
+
+bool CSuperTiler::TestSpan(size_t i, size_t j, size_t n) const{
+  const size_t b = i*m_nWidth + j; //index of first bit
+  const size_t k = b & 63; //offset into word
+  UINT64 bits = m_vOccupied[b >> 6] >> k;
+
+  if(k + n > 64) //straddles next word
+    bits |= m_vOccupied[(b >> 6) + 1] << (64 - k);
+
+  return (bits & ((UINT64(1) << n) - 1)) != 0;
+} //TestSpan
+
+/// Mark a run of cells in one row as occupied.
+/// \param i Row number.
+/// \param j Column of the first cell.
+/// \param n Number of cells.
+
+void CSuperTiler::SetSpan(size_t i, size_t j, size_t n){
+  for(size_t b=i*m_nWidth + j; n>0; b++, n--)
+    m_vOccupied[b >> 6] |= UINT64(1) << (b & 63);
+} //SetSpan
+
+/// Test whether a super-tile fits with its top left corner at a given cell.
+/// It must lie inside the tiling, and neither it nor the ring of cells
+/// around it may be occupied.
+/// \param i Row number.
+/// \param j Column number.
+/// \param s Super-tile size in tiles.
+/// \return true if the super-tile fits.
+
+bool CSuperTiler::Fits(size_t i, size_t j, UINT s) const{
+  if(i + s > m_nHeight || j + s > m_nWidth)return false;
+
+  const size_t i0 = i > 0? i - 1: 0; //first row of ring
+  const size_t i1 = min(i + s + 1, m_nHeight); //one past last row of ring
+  const size_t j0 = j > 0? j - 1: 0; //first column of ring
+  const size_t j1 = min(j + s + 1, m_nWidth); //one past last column of ring
+
+  for(size_t r=i0; r<i1; r++)
+    if(TestSpan(r, j0, j1 - j0))
+      return false;
+
+  return true;
+} //Fits
+
+/// Test whether a cell is covered by a super-tile.
+/// \param i Row number.
+/// \param j Column number.
+/// \return true if cell `(i, j)` is covered by a super-tile.
+
+const bool CSuperTiler::IsOccupied(size_t i, size_t j) const{
+  if(i >= m_nHeight || j >= m_nWidth)return false;
+  const size_t b = i*m_nWidth + j; //index of bit
+  return (m_vOccupied[b >> 6] >> (b & 63) & 1) != 0;
+} //IsOccupied
+
+#pragma endregion Occupancy functions
+
+///////////////////////////////////////////////////////////////////////////////
+// Generate functions
+
+#pragma region Generate functions
+
+/// Seed the pseudo-random number generator, so that the super-tiles placed
+/// next depend only on the seed. The seed is scrambled first, the same way
+/// that the Wang tiler does it.
+/// \param seed Seed.
+
+void CSuperTiler::Seed(UINT seed){
+  m_cRandom.Seed(CWangTiler::Scramble(seed));
+} //Seed
+
+/// Remove all super-tiles, leaving an ordinary Wang tiling.
+
+void CSuperTiler::Clear(){
+  m_nWidth = m_nHeight = 0;
+  m_vOccupied.clear();
+  m_vPlacement.clear();
+} //Clear
+
+/// Scatter super-tiles over the tiling. Each cell in row-major order is
+/// chosen as a top left corner with probability `density`, and a super-tile
+/// chosen uniformly at random is placed there if it fits. The placements are
+/// therefore made in row-major order of their top left corners.
+/// \param tileset Tile set containing the super-tiles.
+/// \param density Probability of trying to place a super-tile at a cell.
+
+void CSuperTiler::Plan(const CTileSet& tileset, float density){
+  const UINT n = tileset.GetSuperTileCount();
+  if(n == 0)return;
+
+  const UINT64 threshold = UINT64(double(density)*4294967296.0); //32 bits
+
+  for(size_t i=0; i<m_nHeight; i++)
+    for(size_t j=0; j<m_nWidth; j++)
+      if(m_cRandom.Next() < threshold){
+        const UINT t = UINT(UINT64(m_cRandom.Next())*n >> 32); //super-tile
+        const UINT s = tileset.GetSuperTile(t).m_nSize;
+
+        if(Fits(i, j, s)){
+          for(size_t r=i; r<i + s; r++)
+            SetSpan(r, j, s);
+
+          m_vPlacement.push_back({i, j, t});
+        } //if
+      } //if
+} //Plan
+
+/// Generate the tiles around the super-tiles in row-major order. A tile takes
+/// its top and left colors from its neighbors, or from the perimeter of the
+/// super-tile that is its neighbor, just as in an ordinary Wang tiling. That
+/// leaves only the parity bit free, and it is forced when the tile is just
+/// above or just to the left of a super-tile so that the tile's bottom or
+/// right color matches. Since super-tiles do not touch, no tile is forced
+/// both ways. The tiles under each super-tile are generated in the same way
+/// with a free parity bit.
+///
+/// Three arrays record which placement, if any, covers each column in the
+/// previous, current, and next rows.
+/// \param tiler Wang tiler.
+/// \param tileset Tile set containing the super-tiles.
+
+void CSuperTiler::Fill(CWangTiler& tiler, const CTileSet& tileset){
+  const size_t n = m_vPlacement.size();
+  size_t first = 0; //first placement that may cover the current row
+
+  std::vector<int> above(m_nWidth, -1); //placements covering the row above
+  std::vector<int> cover(m_nWidth, -1); //placements covering this row
+  std::vector<int> below(m_nWidth, -1); //placements covering the row below
+
+  auto Cover = [&](size_t i, std::vector<int>& v){ //placements covering row i
+    std::fill(v.begin(), v.end(), -1);
+
+    while(first < n && m_vPlacement[first].m_nRow +
+      tileset.GetSuperTile(m_vPlacement[first].m_nType).m_nSize <= i)
+      first++; //rows are only ever asked for in increasing order
+
+    for(size_t k=first; k<n && m_vPlacement[k].m_nRow <= i; k++){
+      const SSuperPlacement& p = m_vPlacement[k];
+      const UINT s = tileset.GetSuperTile(p.m_nType).m_nSize;
+
+      if(i < p.m_nRow + s)
+        for(size_t j=p.m_nCol; j<p.m_nCol + s; j++)
+          v[j] = int(k);
+    } //for
+  }; //Cover
+
+  Cover(0, cover);
+
+  for(size_t i=0; i<m_nHeight; i++){
+    Cover(i + 1, below);
+
+    UINT* row = tiler.GetRow(i);
+    const UINT* prev = i > 0? tiler.GetRow(i - 1): nullptr;
+
+    for(size_t j=0; j<m_nWidth; j++){
+      UINT top = 0, left = 0, parity = m_cRandom.GetBits(1);
+
+      if(i == 0)top = m_cRandom.GetBits(1);
+
+      else if(above[j] >= 0 && cover[j] != above[j]){ //super-tile above
+        const SSuperPlacement& p = m_vPlacement[above[j]];
+        top = tileset.GetSuperTile(p.m_nType).m_vBottom[j - p.m_nCol];
+      } //else if
+
+      else top = CWangTiler::GetBottomColor(prev[j]);
+
+      if(j == 0)left = m_cRandom.GetBits(1);
+
+      else if(cover[j - 1] >= 0 && cover[j] != cover[j - 1]){ //super-tile left
+        const SSuperPlacement& p = m_vPlacement[cover[j - 1]];
+        left = tileset.GetSuperTile(p.m_nType).m_vRight[i - p.m_nRow];
+      } //else if
+
+      else left = CWangTiler::GetRightColor(row[j - 1]);
+
+      if(cover[j] < 0){ //not under a super-tile
+        if(below[j] >= 0){ //super-tile below
+          const SSuperPlacement& p = m_vPlacement[below[j]];
+          parity = top ^ tileset.GetSuperTile(p.m_nType).m_vTop[j - p.m_nCol];
+        } //if
+
+        else if(j + 1 < m_nWidth && cover[j + 1] >= 0){ //super-tile right
+          const SSuperPlacement& p = m_vPlacement[cover[j + 1]];
+          parity = left ^ tileset.GetSuperTile(p.m_nType).m_vLeft[i - p.m_nRow];
+        } //else if
+      } //if
+
+      row[j] = top << 2 | left << 1 | parity;
+    } //for
+
+    above.swap(cover);
+    cover.swap(below);
+  } //for
+} //Fill
+
+/// Generate a Wang tiling with super-tiles scattered over it. If the tile
+/// set has no super-tiles, then this generates an ordinary Wang tiling.
+/// \param tiler Wang tiler.
+/// \param tileset Tile set containing the super-tiles.
+/// \param density Probability of trying to place a super-tile at a cell.
+
+void CSuperTiler::Generate(CWangTiler& tiler, const CTileSet& tileset,
+  float density)
+{
+  Clear();
+
+  m_nWidth  = tiler.GetWidth();
+  m_nHeight = tiler.GetHeight();
+  m_vOccupied.assign((m_nWidth*m_nHeight + 63)/64 + 1, 0);
+
+  Plan(tileset, density);
+  Fill(tiler, tileset);
+} //Generate
+
+#pragma endregion Generate functions
+
+///////////////////////////////////////////////////////////////////////////////
+// Export functions
+
+#pragma region Export functions
+
+/// Flatten the super-tiles into ordinary tiles for exporters that work a
+/// whole tile at a time. Each super-tile image is cut into cell-sized pieces
+/// that are appended to the tile pixels, and the cells under each placed
+/// super-tile refer to its pieces instead of the filler tiles, so that an
+/// exporter draws every super-tile image over its footprint without knowing
+/// about super-tiles. The pieces of a super-tile are appended once however
+/// many times it is placed.
+/// \param tiler Wang tiler with the super-tiles placed by `Generate()`.
+/// \param tileset Tile set containing the super-tiles.
+/// \param dest [OUT] Wang tiler the same size as `tiler` for the flattened
+/// tile indices.
+/// \param tiles [IN, OUT] Tile pixels, 32-bit ARGB in row-major order, one
+/// entry per tile in the tile set, with the pieces appended on return.
+/// \return S_OK for success, E_FAIL if the sizes do not match.
+
+HRESULT CSuperTiler::Flatten(const CWangTiler& tiler, const CTileSet& tileset,
+  CWangTiler& dest, std::vector<std::vector<UINT>>& tiles) const
+{
+  const size_t w = tiler.GetWidth(), h = tiler.GetHeight();
+  if(dest.GetWidth() != w || dest.GetHeight() != h)return E_FAIL;
+  if(!m_vPlacement.empty() && (m_nWidth != w || m_nHeight != h))return E_FAIL;
+
+  const UINT tw = tileset.GetTileWidth(); //tile width
+  const UINT th = tileset.GetTileHeight(); //tile height
+
+  for(size_t i=0; i<h; i++)
+    memcpy(dest.GetRow(i), tiler.GetRow(i), w*sizeof(UINT));
+
+  std::vector<UINT> first(tileset.GetSuperTileCount(), 0); //first pieces
+
+  for(UINT t=0; t<tileset.GetSuperTileCount(); t++){
+    const SSuperTile& super = tileset.GetSuperTile(t);
+    const std::vector<UINT>& v = super.m_pTile->GetPixels();
+    const size_t stride = size_t(super.m_nSize)*tw; //image width
+
+    first[t] = UINT(tiles.size());
+
+    for(UINT r=0; r<super.m_nSize; r++)
+      for(UINT c=0; c<super.m_nSize; c++){
+        std::vector<UINT> piece(size_t(tw)*th);
+
+        for(UINT y=0; y<th; y++)
+          memcpy(&piece[size_t(y)*tw], &v[(size_t(r)*th + y)*stride + c*tw],
+            tw*sizeof(UINT));
+
+        tiles.push_back(std::move(piece));
+      } //for
+  } //for
+
+  for(const SSuperPlacement& p: m_vPlacement){
+    const UINT s = tileset.GetSuperTile(p.m_nType).m_nSize;
+
+    for(UINT r=0; r<s; r++)
+      for(UINT c=0; c<s; c++)
+        dest.GetRow(p.m_nRow + r)[p.m_nCol + c] = first[p.m_nType] + r*s + c;
+  } //for
+
+  return S_OK;
+} //Flatten
+
+#pragma endregion Export functions
+
+///////////////////////////////////////////////////////////////////////////////
+// Reader functions
+
+#pragma region Reader functions
+
+/// Reader function for the super-tile placements.
+/// \return Placements in row-major order of their top left corners.
+
+const std::vector<SSuperPlacement>& CSuperTiler::GetPlacements() const{
+  return m_vPlacement;
+} //GetPlacements
+
+#pragma endregion Reader functions
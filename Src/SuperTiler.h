@@ -0,0 +1,102 @@
+/// \file SuperTiler.h
+/// \brief Interface for CSuperTiler.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef __SUPERTILER_H__
+#define __SUPERTILER_H__
+
+#include "Windows.h"
+#include <vector>
+
+#include "Random.h"
+#include "WangTiler.h"
+#include "TileSet.h"
+
+/// \brief Super-tile placement.
+///
+/// The position of one super-tile in a tiling, given by the cell under its
+/// top left corner, and its index into the tile set's super-tiles.
+
+struct SSuperPlacement{
+  size_t m_nRow = 0; ///< Top row.
+  size_t m_nCol = 0; ///< Left column.
+  UINT m_nType = 0; ///< Super-tile index.
+}; //SSuperPlacement
+
+/// \brief Super-tiler.
+///
+/// The super-tiler scatters super-tiles, which cover a square of 2x2 or 3x3
+/// cells, pseudo-randomly over a Wang tiling and then generates the rest of
+/// the tiling around them so that every edge between a super-tile and an
+/// ordinary tile matches. Occupied cells are kept in a bitset with one bit
+/// per cell, so testing whether a super-tile fits takes a handful of word
+/// operations however large the tiling is. Super-tiles are never placed next
+/// to each other, not even diagonally, so that no tile is constrained by two
+/// super-tiles at once.
+///
+/// The cells under a super-tile hold filler tiles that match the tiles above
+/// and to the left of them, but their right and bottom edges do not in
+/// general match the tiles beyond the super-tile, so the index array is not
+/// a valid Wang tiling while any super-tiles are placed. Code that draws the
+/// tiling must handle the placements: `CTileSet::Render()` and `CSvgWriter`
+/// draw each super-tile image once at its top left cell, and `Flatten()`
+/// turns the super-tiles into cell-sized pieces for exporters that work a
+/// whole tile at a time. Code that reads per-tile data other than images,
+/// such as navigation and collision masks, must not be given a tiling with
+/// super-tiles.
+
+class CSuperTiler{
+  private:
+    size_t m_nWidth = 0; ///< Width in tiles.
+    size_t m_nHeight = 0; ///< Height in tiles.
+
+    std::vector<UINT64> m_vOccupied; ///< Occupancy bitset, one bit per cell.
+    std::vector<SSuperPlacement> m_vPlacement; ///< Placements by row.
+
+    CRandom m_cRandom; ///< Pseudo-random number generator.
+
+    bool TestSpan(size_t i, size_t j, size_t n) const; ///< Test cells in a row.
+    void SetSpan(size_t i, size_t j, size_t n); ///< Occupy cells in a row.
+    bool Fits(size_t i, size_t j, UINT s) const; ///< Test for room.
+
+    void Plan(const CTileSet& tileset, float density); ///< Place super-tiles.
+    void Fill(CWangTiler& tiler, const CTileSet& tileset); ///< Fill in tiles.
+
+  public:
+    CSuperTiler(); ///< Constructor.
+
+    void Seed(UINT seed); ///< Seed the pseudo-random number generator.
+    void Clear(); ///< Remove all super-tiles.
+    void Generate(CWangTiler& tiler, const CTileSet& tileset,
+      float density=0.05f); ///< Generate tiling with super-tiles.
+
+    HRESULT Flatten(const CWangTiler& tiler, const CTileSet& tileset,
+      CWangTiler& dest,
+      std::vector<std::vector<UINT>>& tiles) const; ///< Flatten super-tiles.
+
+    const bool IsOccupied(size_t i, size_t j) const; ///< Test a cell.
+    const std::vector<SSuperPlacement>& GetPlacements() const; ///< Get placements.
+}; //CSuperTiler
+
+#endif //__SUPERTILER_H__
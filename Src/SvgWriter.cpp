@@ -0,0 +1,269 @@
+/// \file SvgWriter.cpp
+/// \brief Code for CSvgWriter.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "SvgWriter.h"
+#include "SuperTiler.h"
+
+static const size_t BUFFERSIZE = 1 << 20; ///< Output buffer size in bytes.
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper functions
+
+#pragma region Helper functions
+
+/// Encode bytes as base64.
+/// \param v Bytes.
+/// \param s [OUT] Base64 string.
+
+static void Base64(const std::vector<BYTE>& v, std::string& s){
+  static const char digit[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+  s.clear();
+  s.reserve(4*((v.size() + 2)/3));
+
+  size_t i = 0;
+
+  for(; i+3<=v.size(); i+=3){ //whole groups of 3 bytes
+    const UINT n = v[i] << 16 | v[i + 1] << 8 | v[i + 2];
+    s += digit[n >> 18];
+    s += digit[(n >> 12) & 63];
+    s += digit[(n >> 6) & 63];
+    s += digit[n & 63];
+  } //for
+
+  if(i < v.size()){ //1 or 2 bytes left over
+    const bool two = i + 1 < v.size();
+    const UINT n = v[i] << 16 | (two? v[i + 1] << 8: 0);
+    s += digit[n >> 18];
+    s += digit[(n >> 12) & 63];
+    s += two? digit[(n >> 6) & 63]: '=';
+    s += '=';
+  } //if
+} //Base64
+
+/// Append a string to the output buffer.
+/// \param s Null-terminated string.
+
+void CSvgWriter::Put(const char* s){
+  m_strBuffer += s;
+} //Put
+
+/// Append an unsigned number in decimal to the output buffer, without going
+/// through a temporary string.
+/// \param n Number.
+
+void CSvgWriter::Put(size_t n){
+  char digit[24]; //digits in reverse order
+  int k = 0;
+
+  do{
+    digit[k++] = char('0' + n%10);
+    n /= 10;
+  }while(n > 0);
+
+  while(k > 0)
+    m_strBuffer += digit[--k];
+} //Put
+
+/// Write the output buffer to the stream once it is full.
+/// \param force Whether to write it even if it is not full.
+
+void CSvgWriter::Flush(bool force){
+  if(force || m_strBuffer.size() >= BUFFERSIZE){
+    m_pStream->write(m_strBuffer.data(), m_strBuffer.size());
+    m_strBuffer.clear();
+  } //if
+} //Flush
+
+/// Append a symbol holding one embedded PNG image to the output buffer,
+/// writing the buffer out before and after the image data.
+/// \param c First character of the symbol id.
+/// \param n Number that ends the symbol id.
+/// \param base64 Base64 PNG data.
+/// \param w Image width in pixels.
+/// \param h Image height in pixels.
+
+void CSvgWriter::PutSymbol(char c, size_t n, const std::string& base64,
+  size_t w, size_t h)
+{
+  Put("<symbol id=\"");
+  m_strBuffer += c; Put(n);
+  Put("\" width=\""); Put(w);
+  Put("\" height=\""); Put(h);
+  Put("\"><image width=\""); Put(w);
+  Put("\" height=\""); Put(h);
+  Put("\" xlink:href=\"data:image/png;base64,");
+  Flush();
+  Put(base64.c_str());
+  Put("\"/></symbol>\n");
+  Flush();
+} //PutSymbol
+
+#pragma endregion Helper functions
+
+///////////////////////////////////////////////////////////////////////////////
+// Build and save
+
+#pragma region Build and save
+
+/// Set the tile images, base64-encoding them ready to be embedded.
+/// \param png PNG file contents per tile.
+/// \param w Tile width in pixels.
+/// \param h Tile height in pixels.
+/// \return S_OK for success, E_FAIL if there are no tiles.
+
+HRESULT CSvgWriter::Build(const std::vector<std::vector<BYTE>>& png,
+  UINT w, UINT h)
+{
+  if(png.empty() || w == 0 || h == 0)return E_FAIL;
+
+  m_nTileWidth = w;
+  m_nTileHeight = h;
+  m_vBase64.resize(png.size());
+
+  for(size_t i=0; i<png.size(); i++)
+    Base64(png[i], m_vBase64[i]);
+
+  return S_OK;
+} //Build
+
+/// Set the super-tile images, base64-encoding them ready to be embedded.
+/// These are only needed to save a tiling with super-tiles.
+/// \param png PNG file contents per super-tile.
+/// \param size Width and height in tiles per super-tile.
+/// \return S_OK for success, E_FAIL if the sizes do not match.
+
+HRESULT CSvgWriter::BuildSuper(const std::vector<std::vector<BYTE>>& png,
+  const std::vector<UINT>& size)
+{
+  if(png.size() != size.size())return E_FAIL;
+
+  m_vSuperSize = size;
+  m_vSuperBase64.resize(png.size());
+
+  for(size_t i=0; i<png.size(); i++)
+    Base64(png[i], m_vSuperBase64[i]);
+
+  return S_OK;
+} //BuildSuper
+
+/// Save a Wang tiling as an SVG file. The image size is the size of the
+/// tiling in pixels and the view box matches it, so it scales to any size
+/// when printed. References use `xlink:href`, which SVG 2 renderers still
+/// accept, so that print RIPs and older renderers that only understand
+/// SVG 1.1 can read the file too. The buffer is checked after every cell
+/// and written out once it reaches `BUFFERSIZE`, so however wide a row is,
+/// it never grows much beyond that.
+/// A super-tile is one `<use>` of its symbol in the row of its top left
+/// cell, and the other cells that it covers are left out. `Build()` must
+/// have been called first, and `BuildSuper()` too if there are super-tiles.
+/// \param filename Name of the SVG file.
+/// \param tiler Wang tiler.
+/// \param pSuper Pointer to the super-tiler, or **nullptr** for none.
+/// \return S_OK for success, E_FAIL for failure.
+
+HRESULT CSvgWriter::Save(const std::wstring& filename, const CWangTiler& tiler,
+  const CSuperTiler* pSuper)
+{
+  if(m_vBase64.empty())return E_FAIL; //nothing built
+
+  const size_t nGridWidth  = tiler.GetWidth();
+  const size_t nGridHeight = tiler.GetHeight();
+  const size_t w = nGridWidth*m_nTileWidth; //image width
+  const size_t h = nGridHeight*m_nTileHeight; //image height
+
+  for(size_t i=0; i<nGridHeight; i++) //make sure indices are in range
+    for(size_t j=0; j<nGridWidth; j++)
+      if(tiler(i, j) >= m_vBase64.size())return E_FAIL;
+
+  const std::vector<SSuperPlacement>* pPlacement = nullptr; //super-tiles
+
+  if(pSuper != nullptr && !pSuper->GetPlacements().empty()){
+    pPlacement = &pSuper->GetPlacements();
+
+    for(const SSuperPlacement& p: *pPlacement){ //make sure they are in range
+      if(p.m_nType >= m_vSuperBase64.size())return E_FAIL;
+      const UINT n = m_vSuperSize[p.m_nType];
+      if(p.m_nRow + n > nGridHeight || p.m_nCol + n > nGridWidth)return E_FAIL;
+    } //for
+  } //if
+
+  std::ofstream s(filename, std::ios::binary);
+  if(!s.is_open())return E_FAIL;
+
+  m_pStream = &s;
+  m_strBuffer.reserve(BUFFERSIZE + 4096);
+
+  Put("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+  Put("<svg xmlns=\"http://www.w3.org/2000/svg\" ");
+  Put("xmlns:xlink=\"http://www.w3.org/1999/xlink\" version=\"1.1\" ");
+  Put("width=\""); Put(w);
+  Put("\" height=\""); Put(h);
+  Put("\" viewBox=\"0 0 "); Put(w); Put(" "); Put(h); Put("\">\n");
+
+  for(size_t t=0; t<m_vBase64.size(); t++) //one symbol per tile
+    PutSymbol('t', t, m_vBase64[t], m_nTileWidth, m_nTileHeight);
+
+  if(pPlacement != nullptr)
+    for(size_t t=0; t<m_vSuperBase64.size(); t++) //one symbol per super-tile
+      PutSymbol('s', t, m_vSuperBase64[t], m_vSuperSize[t]*m_nTileWidth,
+        m_vSuperSize[t]*m_nTileHeight);
+
+  size_t k = 0; //next placement, in row-major order of top left cells
+
+  for(size_t i=0; i<nGridHeight; i++){ //one group per row
+    Put("<g transform=\"translate(0 "); Put(i*m_nTileHeight); Put(")\">");
+
+    for(size_t j=0; j<nGridWidth; j++){
+      if(pPlacement != nullptr && k < pPlacement->size() &&
+        (*pPlacement)[k].m_nRow == i && (*pPlacement)[k].m_nCol == j)
+      { //top left cell of a super-tile
+        Put("<use xlink:href=\"#s"); Put((*pPlacement)[k++].m_nType);
+        Put("\" x=\""); Put(j*m_nTileWidth); Put("\"/>");
+      } //if
+
+      else if(pPlacement == nullptr || !pSuper->IsOccupied(i, j)){
+        Put("<use xlink:href=\"#t"); Put(tiler(i, j));
+        Put("\" x=\""); Put(j*m_nTileWidth); Put("\"/>");
+      } //else if
+
+      Flush();
+    } //for
+
+    Put("</g>\n");
+  } //for
+
+  Put("</svg>\n");
+  Flush(true);
+
+  m_pStream = nullptr;
+  m_strBuffer.clear();
+  m_strBuffer.shrink_to_fit();
+
+  return s.good()? S_OK: E_FAIL;
+} //Save
+
+#pragma endregion Build and save
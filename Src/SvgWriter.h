@@ -0,0 +1,75 @@
+/// \file SvgWriter.h
+/// \brief Interface for CSvgWriter.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef __SVGWRITER_H__
+#define __SVGWRITER_H__
+
+#include "Windows.h"
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "WangTiler.h"
+
+class CSuperTiler;
+
+/// \brief Streaming SVG writer.
+///
+/// Saves a Wang tiling as a resolution-independent SVG file. Each tile image
+/// is embedded once as a base64-encoded PNG inside a `<symbol>`, and each cell
+/// of the tiling is a single `<use>` element that refers to its tile's
+/// symbol, grouped by row so that only the x coordinate is needed per cell.
+/// Super-tiles get a symbol each too, and a placed super-tile is a single
+/// `<use>` at its top left cell in place of the cells that it covers.
+/// The file is written in one pass through a large buffer, so the time taken
+/// and memory used do not depend on building a document tree.
+
+class CSvgWriter{
+  private:
+    UINT m_nTileWidth = 0; ///< Tile width in pixels.
+    UINT m_nTileHeight = 0; ///< Tile height in pixels.
+    std::vector<std::string> m_vBase64; ///< Base64 PNG data per tile.
+    std::vector<std::string> m_vSuperBase64; ///< Base64 PNG per super-tile.
+    std::vector<UINT> m_vSuperSize; ///< Size in tiles per super-tile.
+
+    std::string m_strBuffer; ///< Output buffer.
+    std::ofstream* m_pStream = nullptr; ///< Output stream.
+
+    void Put(const char* s); ///< Append string to buffer.
+    void Put(size_t n); ///< Append number to buffer.
+    void Flush(bool force=false); ///< Write buffer to stream if full.
+    void PutSymbol(char c, size_t n, const std::string& base64,
+      size_t w, size_t h); ///< Append symbol.
+
+  public:
+    HRESULT Build(const std::vector<std::vector<BYTE>>& png,
+      UINT w, UINT h); ///< Set tile images.
+    HRESULT BuildSuper(const std::vector<std::vector<BYTE>>& png,
+      const std::vector<UINT>& size); ///< Set super-tile images.
+    HRESULT Save(const std::wstring& filename, const CWangTiler& tiler,
+      const CSuperTiler* pSuper=nullptr); ///< Save tiling as SVG.
+}; //CSvgWriter
+
+#endif //__SVGWRITER_H__
@@ -0,0 +1,284 @@
+/// \file TextureBomber.cpp
+/// \brief Code for CTextureBomber.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <emmintrin.h>
+
+#include "TextureBomber.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructors and destructors
+
+#pragma region Constructors and destructors
+
+/// \param border Blend width in pixels on each side of a cell edge, at most
+/// half the tile width and height.
+/// \param jitter Maximum jitter in pixels, at most `border`.
+/// \param seed Seed for jitter.
+
+CTextureBomber::CTextureBomber(UINT border, UINT jitter, UINT seed):
+  m_nBorder(border), m_nJitter(jitter), m_nSeed(seed){
+} //constructor
+
+#pragma endregion Constructors and destructors
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper functions
+
+#pragma region Helper functions
+
+/// Reflect a coordinate that is less than one length outside a range back
+/// into it, repeating the edge pixel the way mirrored texture addressing
+/// does.
+/// \param k Coordinate.
+/// \param n Length of range.
+/// \return Reflected coordinate, from 0 to `n - 1`.
+
+static int Reflect(int k, int n){
+  return k < 0? -k - 1: k >= n? 2*n - k - 1: k;
+} //Reflect
+
+/// Blend 4 pixels of one row into 4 pixels of another, one byte channel at
+/// a time in 16 bits, as `(a*(256 - w) + b*w + 128)/256`. This cannot
+/// overflow since the weights sum to 256.
+/// \param a First 4 pixels.
+/// \param b Second 4 pixels.
+/// \param wlo Weights of `b` for the channels of the first 2 pixels.
+/// \param whi Weights of `b` for the channels of the last 2 pixels.
+/// \return Blended pixels.
+
+static __m128i Lerp(__m128i a, __m128i b, __m128i wlo, __m128i whi){
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i full = _mm_set1_epi16(256);
+  const __m128i half = _mm_set1_epi16(128);
+
+  const __m128i lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(
+    _mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), _mm_sub_epi16(full, wlo)),
+    _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), wlo)), half), 8);
+
+  const __m128i hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(
+    _mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), _mm_sub_epi16(full, whi)),
+    _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), whi)), half), 8);
+
+  return _mm_packus_epi16(lo, hi);
+} //Lerp
+
+/// Blend a run of pixels from two rows with a weight per pixel.
+/// \param a First row.
+/// \param b Second row.
+/// \param w Weight of `b` for each pixel, out of 256, repeated once per
+/// channel.
+/// \param n Number of pixels.
+/// \param out [OUT] Blended pixels, which may be the same as `a` or `b`.
+
+static void Blend(const UINT* a, const UINT* b, const USHORT* w, size_t n,
+  UINT* out)
+{
+  size_t k = 0; //pixel index
+
+  for(; k+4<=n; k+=4)
+    _mm_storeu_si128((__m128i*)(out + k), Lerp(
+      _mm_loadu_si128((const __m128i*)(a + k)),
+      _mm_loadu_si128((const __m128i*)(b + k)),
+      _mm_loadu_si128((const __m128i*)(w + 4*k)),
+      _mm_loadu_si128((const __m128i*)(w + 4*k + 8))));
+
+  for(; k<n; k++){
+    const BYTE* p = (const BYTE*)(a + k);
+    const BYTE* q = (const BYTE*)(b + k);
+    BYTE* r = (BYTE*)(out + k);
+
+    for(UINT c=0; c<4; c++)
+      r[c] = BYTE((p[c]*(256 - w[4*k]) + q[c]*w[4*k] + 128) >> 8);
+  } //for
+} //Blend
+
+/// Blend two rows of pixels with the same weight for every pixel.
+/// \param a First row.
+/// \param b Second row.
+/// \param w Weight of `b`, out of 256.
+/// \param n Number of pixels.
+/// \param out [OUT] Blended pixels, which may be the same as `a` or `b`.
+
+static void Blend(const UINT* a, const UINT* b, USHORT w, size_t n,
+  UINT* out)
+{
+  const __m128i ww = _mm_set1_epi16(short(w));
+  size_t k = 0; //pixel index
+
+  for(; k+4<=n; k+=4)
+    _mm_storeu_si128((__m128i*)(out + k), Lerp(
+      _mm_loadu_si128((const __m128i*)(a + k)),
+      _mm_loadu_si128((const __m128i*)(b + k)), ww, ww));
+
+  for(; k<n; k++){
+    const BYTE* p = (const BYTE*)(a + k);
+    const BYTE* q = (const BYTE*)(b + k);
+    BYTE* r = (BYTE*)(out + k);
+
+    for(UINT c=0; c<4; c++)
+      r[c] = BYTE((p[c]*(256 - w) + q[c]*w + 128) >> 8);
+  } //for
+} //Blend
+
+/// Get the jitter for a cell, which depends only on the seed and the cell's
+/// row and column, so that any band of the output can be rendered on its
+/// own.
+/// \param i Row number.
+/// \param j Column number.
+/// \param dx [OUT] Horizontal jitter, from `-m_nJitter` to `m_nJitter`.
+/// \param dy [OUT] Vertical jitter, from `-m_nJitter` to `m_nJitter`.
+
+void CTextureBomber::GetJitter(size_t i, size_t j, int& dx, int& dy) const{
+  const UINT h = CWangTiler::Scramble(UINT(i)*0x9E3779B9 ^
+    CWangTiler::Scramble(UINT(j) ^ m_nSeed)); //hash of cell
+  const UINT n = 2*m_nJitter + 1; //number of possible offsets
+
+  dx = int((h & 0xFFFF)%n) - int(m_nJitter);
+  dy = int((h >> 16)%n) - int(m_nJitter);
+} //GetJitter
+
+#pragma endregion Helper functions
+
+///////////////////////////////////////////////////////////////////////////////
+// Render function
+
+#pragma region Render function
+
+/// Render a Wang tiling into a 32-bit ARGB pixel buffer the same size as
+/// `CTileSet::Render()` fills, one row of tiles per task on the shared
+/// thread pool. Each tile is first extended by mirroring into a copy with a
+/// margin wide enough for the border plus the jitter. Each output row is
+/// then composed from the row of patches that it lies in: the part of each
+/// patch away from its left and right borders is copied, and the part
+/// across each cell edge is blended between the two patches with a
+/// smoothstep weight. Rows within the border of a cell edge are composed
+/// from both rows of patches and those two rows are blended in the same
+/// way. The cost over a plain copy is therefore proportional to the border
+/// width divided by the tile size. The tiling must not have super-tiles,
+/// since the cells under them hold filler tiles.
+/// \param tileset Tile set.
+/// \param tiler Wang tiler.
+/// \param pDest Destination pixels, large enough for the whole tiling.
+/// \param nStride Bytes per destination row.
+/// \param priority Thread pool priority.
+/// \return S_OK for success, E_FAIL if the tiling refers to a missing tile
+/// or the border or jitter is too large for the tiles.
+
+HRESULT CTextureBomber::Render(const CTileSet& tileset,
+  const CWangTiler& tiler, BYTE* pDest, size_t nStride,
+  ePriority priority) const
+{
+  const size_t gw = tiler.GetWidth(), gh = tiler.GetHeight(); //grid size
+  const UINT tw = tileset.GetTileWidth(), th = tileset.GetTileHeight();
+  const UINT b = m_nBorder; //border
+
+  if(tw == 0 || 2*b > min(tw, th) || m_nJitter > b)return E_FAIL;
+
+  for(size_t i=0; i<gh; i++) //make sure indices are in range
+    for(size_t j=0; j<gw; j++)
+      if(tiler(i, j) >= tileset.GetSize())return E_FAIL;
+
+  const UINT m = b + m_nJitter; //margin
+  const UINT ew = tw + 2*m, eh = th + 2*m; //extended tile size
+  std::vector<std::vector<UINT>> ext(tileset.GetSize()); //extended tiles
+
+  for(UINT t=0; t<tileset.GetSize(); t++){
+    const UINT* p = tileset.GetTile(t)->GetPixels().data();
+    ext[t].resize(size_t(ew)*eh);
+
+    for(UINT y=0; y<eh; y++){
+      const UINT* src = p + size_t(Reflect(int(y) - int(m), int(th)))*tw;
+
+      for(UINT x=0; x<ew; x++)
+        ext[t][size_t(y)*ew + x] = src[Reflect(int(x) - int(m), int(tw))];
+    } //for
+  } //for
+
+  std::vector<USHORT> ramp(2*b); //weight of second patch across an edge
+  std::vector<USHORT> ramp4(8*b); //same, repeated once per channel
+
+  for(UINT k=0; k<2*b; k++){
+    const float x = (k + 0.5f)/(2*b); //position across border
+    ramp[k] = USHORT(256*x*x*(3 - 2*x) + 0.5f); //smoothstep
+
+    for(UINT c=0; c<4; c++)
+      ramp4[4*k + c] = ramp[k];
+  } //for
+
+  //compose row Y of the output from the patches in row r of the tiling
+
+  auto Compose = [&](size_t r, size_t Y, UINT* out){
+    int dx = 0, dy = 0; //jitter
+    GetJitter(r, 0, dx, dy);
+
+    for(size_t j=0; j<gw; j++){
+      const size_t v = Y - r*th - dy + m; //row in extended tile
+      const UINT* src = ext[tiler(r, j)].data() + v*ew; //extended tile row
+      const size_t c = m - dx; //column of left edge of cell in extended tile
+
+      const size_t x0 = j*tw + (j > 0? b: 0); //start of copy
+      const size_t x1 = (j + 1)*tw - (j + 1 < gw? b: 0); //end of copy
+      memcpy(out + x0, src + c + x0 - j*tw, 4*(x1 - x0));
+
+      if(j + 1 < gw){ //blend with next patch
+        GetJitter(r, j + 1, dx, dy);
+
+        const size_t vn = Y - r*th - dy + m; //row in next extended tile
+        const UINT* next = ext[tiler(r, j + 1)].data() + vn*ew; //its row
+
+        Blend(src + c + x1 - j*tw, next + m - dx - b, ramp4.data(), 2*b,
+          out + x1); //the margin is at least b + dx, so m - dx - b >= 0
+      } //if
+    } //for
+  }; //Compose
+
+  const size_t w = gw*tw; //output width
+
+  CThreadPool::GetInstance().ParallelFor(gh, 1, [&](size_t i0, size_t i1){
+    std::vector<UINT> row(w); //neighboring row of patches
+
+    for(size_t i=i0; i<i1; i++)
+      for(UINT y=0; y<th; y++){
+        const size_t Y = i*th + y; //output row
+        UINT* out = (UINT*)(pDest + Y*nStride);
+
+        Compose(i, Y, out);
+
+        if(y < b && i > 0){ //blend with row above
+          Compose(i - 1, Y, row.data());
+          Blend(row.data(), out, ramp[y + b], w, out);
+        } //if
+
+        else if(y + b >= th && i + 1 < gh){ //blend with row below
+          Compose(i + 1, Y, row.data());
+          Blend(out, row.data(), ramp[y + b - th], w, out);
+        } //else if
+      } //for
+  }, priority); //ParallelFor
+
+  return S_OK;
+} //Render
+
+#pragma endregion Render function
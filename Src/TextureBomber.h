@@ -0,0 +1,65 @@
+/// \file TextureBomber.h
+/// \brief Interface for CTextureBomber.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef __TEXTUREBOMBER_H__
+#define __TEXTUREBOMBER_H__
+
+#include "Windows.h"
+#include <vector>
+
+#include "TileSet.h"
+
+/// \brief Texture-bombing renderer.
+///
+/// An alternative to `CTileSet::Render()` for tile sets whose tile
+/// boundaries stay visible. Each cell of the Wang tiling places its tile
+/// image as a patch that is jittered by a few pixels, in a direction that
+/// depends only on the seed and the cell, and that extends past the cell
+/// into a feathered border where it is blended with its neighbors. Tiles are
+/// extended beyond their edges by mirroring, so a jittered patch never runs
+/// out of pixels. The blending weights across each cell boundary sum to 1,
+/// so no normalization is needed, and pixels away from the borders are
+/// copied exactly as `CTileSet::Render()` copies them. Super-tiles are not
+/// supported, so the tiling must not have any (see `CSuperTiler`).
+
+class CTextureBomber{
+  private:
+    UINT m_nBorder = 8; ///< Blend width on each side of a cell edge.
+    UINT m_nJitter = 4; ///< Maximum jitter in pixels.
+    UINT m_nSeed = 0; ///< Seed for jitter.
+
+    void GetJitter(size_t i, size_t j, int& dx,
+      int& dy) const; ///< Get jitter for a cell.
+
+  public:
+    CTextureBomber(UINT border=8, UINT jitter=4,
+      UINT seed=0); ///< Constructor.
+
+    HRESULT Render(const CTileSet& tileset, const CWangTiler& tiler,
+      BYTE* pDest, size_t nStride,
+      ePriority priority=ePriority::Batch) const; ///< Render a tiling.
+}; //CTextureBomber
+
+#endif //__TEXTUREBOMBER_H__
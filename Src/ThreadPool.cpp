@@ -0,0 +1,525 @@
+/// \file ThreadPool.cpp
+/// \brief Code for CThreadPool and CTaskGroup.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <chrono>
+#include <cmath>
+
+#include "ThreadPool.h"
+
+/// Pool that the calling thread is a worker for, if any.
+static thread_local const CThreadPool* g_pWorkerPool = nullptr;
+
+/// Index of the calling thread in `g_pWorkerPool`.
+static thread_local UINT g_nWorkerIndex = 0;
+
+///////////////////////////////////////////////////////////////////////////////
+// CTaskGroup functions
+
+#pragma region CTaskGroup functions
+
+/// \param pPool Pointer to a thread pool, or **nullptr** for the shared pool.
+/// \param priority Priority of tasks in this group.
+
+CTaskGroup::CTaskGroup(CThreadPool* pPool, ePriority priority):
+  m_pPool(pPool? pPool: &CThreadPool::GetInstance()), m_ePriority(priority),
+  m_nPending(0){
+} //constructor
+
+/// Wait for any tasks that are still running, since they refer to this group.
+
+CTaskGroup::~CTaskGroup(){
+  Wait();
+} //destructor
+
+/// Submit a task to the thread pool as part of this group.
+/// \param f Function to run.
+
+void CTaskGroup::Run(const std::function<void()>& f){
+  m_nPending++;
+
+  CThreadPool::STask task;
+  task.m_fnTask = f;
+  task.m_pGroup = this;
+  task.m_ePriority = m_ePriority;
+
+  m_pPool->Submit(std::move(task));
+} //Run
+
+/// Mark a task in this group as finished, waking up the waiting thread if
+/// it was the last one. The count is decremented under the lock so that the
+/// waiter cannot return and destroy the group while this is still using it.
+
+void CTaskGroup::Finish(){
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if(--m_nPending == 0)m_cv.notify_all();
+} //Finish
+
+/// Wait until every task in this group has finished, running queued tasks on
+/// the calling thread in the meantime. Only tasks of this group's priority
+/// or higher are run, so an interactive wait is never held up by a batch
+/// task. If there are none queued, then the rest of this group's tasks are
+/// running on other threads, so sleep until the last of them finishes.
+
+void CTaskGroup::Wait(){
+  const UINT p = UINT(m_ePriority); //lowest priority to run
+
+  while(m_nPending > 0)
+    if(!m_pPool->RunOne(p)){ //the rest are running elsewhere
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cv.wait(lock, [&](){return m_nPending == 0;});
+    } //if
+
+  std::lock_guard<std::mutex> lock(m_mutex); //until Finish() lets go
+} //Wait
+
+#pragma endregion CTaskGroup functions
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructors and destructors
+
+#pragma region Constructors and destructors
+
+/// Start the worker threads.
+/// \param n Number of workers, or 0 for one per logical processor.
+/// \param pin Whether to pin each worker to one logical processor.
+
+CThreadPool::CThreadPool(UINT n, bool pin):
+  m_nQueued(0), m_nQueuedInteractive(0)
+{
+  if(n == 0)n = max(1U, std::thread::hardware_concurrency());
+
+  for(SLatency& l: m_sLatency){
+    for(std::atomic<UINT64>& b: l.m_nBucket)
+      b = 0;
+
+    l.m_nMissed = l.m_nTotal = l.m_nMax = 0;
+  } //for
+
+  SetLatencyTarget(ePriority::Interactive, 5);
+  SetLatencyTarget(ePriority::Batch, 1000);
+
+  for(UINT i=0; i<n; i++)
+    m_vWorker.push_back(new SWorker);
+
+  for(UINT i=0; i<n; i++)
+    m_vWorker[i]->m_stdThread = std::thread(&CThreadPool::WorkerMain, this,
+      i, pin);
+} //constructor
+
+/// Tell the workers to stop once the queues are empty, wait for them, then
+/// delete them.
+
+CThreadPool::~CThreadPool(){
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_bStop = true;
+  }
+
+  m_cv.notify_all();
+
+  for(SWorker* p: m_vWorker)
+    p->m_stdThread.join();
+
+  for(SWorker* p: m_vWorker)
+    delete p;
+} //destructor
+
+#pragma endregion Constructors and destructors
+
+///////////////////////////////////////////////////////////////////////////////
+// Scheduling functions
+
+#pragma region Scheduling functions
+
+/// Get the index of the calling thread if it is a worker in this pool.
+/// \return Worker index, or -1 if the caller is not a worker in this pool.
+
+int CThreadPool::GetWorkerIndex() const{
+  return g_pWorkerPool == this? int(g_nWorkerIndex): -1;
+} //GetWorkerIndex
+
+/// Queue a task. A worker pushes onto the back of its own queue, any other
+/// thread onto the shared queue. The queued count is incremented first so
+/// that it never underflows when the task is taken straight away, then a
+/// sleeping worker is woken up.
+/// \param task Task to queue.
+
+void CThreadPool::Submit(STask&& task){
+  const int w = GetWorkerIndex();
+  const UINT p = UINT(task.m_ePriority);
+
+  task.m_tSubmit = std::chrono::steady_clock::now();
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex); //no lost wakeup
+    m_nQueued++;
+    if(task.m_ePriority == ePriority::Interactive)m_nQueuedInteractive++;
+  }
+
+  if(w >= 0){
+    std::lock_guard<std::mutex> lock(m_vWorker[w]->m_mutex);
+    m_vWorker[w]->m_dqTask[p].push_back(std::move(task));
+  } //if
+
+  else{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_dqShared[p].push_back(std::move(task));
+  } //else
+
+  m_cv.notify_one();
+} //Submit
+
+/// Get a task of a given priority: first from the back of the worker's own
+/// queue, then from the shared queue, then by stealing from the front of the
+/// other workers' queues, starting with the next worker along.
+/// \param w Worker index, or the number of workers if the caller is not a
+/// worker, in which case it has no queue of its own.
+/// \param p Priority.
+/// \param task [OUT] Task.
+/// \return true if a task was found.
+
+bool CThreadPool::Pop(UINT w, UINT p, STask& task){
+  const UINT n = UINT(m_vWorker.size());
+  bool found = false;
+
+  if(w < n){ //own queue
+    SWorker* q = m_vWorker[w];
+    std::lock_guard<std::mutex> lock(q->m_mutex);
+
+    if(!q->m_dqTask[p].empty()){
+      task = std::move(q->m_dqTask[p].back());
+      q->m_dqTask[p].pop_back();
+      found = true;
+    } //if
+  } //if
+
+  if(!found){ //shared queue
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if(!m_dqShared[p].empty()){
+      task = std::move(m_dqShared[p].front());
+      m_dqShared[p].pop_front();
+      found = true;
+    } //if
+  } //if
+
+  for(UINT k=(w < n? 1: 0); k<n && !found; k++){ //steal, but not from self
+    SWorker* q = m_vWorker[(w + k)%n];
+    std::lock_guard<std::mutex> lock(q->m_mutex);
+
+    if(!q->m_dqTask[p].empty()){
+      task = std::move(q->m_dqTask[p].front());
+      q->m_dqTask[p].pop_front();
+      found = true;
+      if(w < n)
+        m_vWorker[w]->m_nSteals.fetch_add(1, std::memory_order_relaxed);
+    } //if
+  } //for
+
+  if(found){
+    m_nQueued--;
+    if(task.m_ePriority == ePriority::Interactive)m_nQueuedInteractive--;
+  } //if
+
+  return found;
+} //Pop
+
+/// Record the queue latency of a task that is about to run. The histogram
+/// bucket is four times the base 2 logarithm of the latency in microseconds.
+/// \param task Task.
+
+void CThreadPool::RecordLatency(const STask& task){
+  const UINT64 us = UINT64(std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now() - task.m_tSubmit).count());
+  SLatency& l = m_sLatency[UINT(task.m_ePriority)];
+
+  const UINT b = UINT(4*std::log2(double(us) + 1)); //histogram bucket
+  l.m_nBucket[min(b, NUMBUCKETS - 1)]++;
+  l.m_nTotal += us;
+  if(us > l.m_nTarget)l.m_nMissed++;
+
+  UINT64 m = l.m_nMax;
+  while(us > m && !l.m_nMax.compare_exchange_weak(m, us));
+} //RecordLatency
+
+/// Run one queued task on the calling thread, if there is one. Higher
+/// priority tasks are taken first.
+/// \param p Lowest priority to run, as an index into `ePriority`.
+/// \return true if a task was run.
+
+bool CThreadPool::RunOne(UINT p){
+  const int w = GetWorkerIndex();
+  const UINT index = w < 0? GetSize(): UINT(w);
+  STask task;
+  bool found = false;
+
+  for(UINT k=0; k<=p && !found; k++)
+    found = Pop(index, k, task);
+
+  if(!found)return false;
+
+  RecordLatency(task);
+  task.m_fnTask();
+  if(w >= 0)m_vWorker[w]->m_nTasks.fetch_add(1, std::memory_order_relaxed);
+  if(task.m_pGroup)task.m_pGroup->Finish();
+
+  return true;
+} //RunOne
+
+/// Run any waiting interactive tasks on the calling thread. Long-running
+/// batch tasks should call this every so often, for example once per row,
+/// so that interactive requests do not wait for them to finish. It costs
+/// only an atomic read when there are no interactive tasks waiting.
+
+void CThreadPool::YieldToInteractive(){
+  while(m_nQueuedInteractive > 0 && RunOne(UINT(ePriority::Interactive)));
+} //YieldToInteractive
+
+/// Worker thread function. Run tasks until told to stop, sleeping while
+/// there are none queued.
+/// \param w Worker index.
+/// \param pin Whether to pin this worker to logical processor `w`.
+
+void CThreadPool::WorkerMain(UINT w, bool pin){
+  g_pWorkerPool = this;
+  g_nWorkerIndex = w;
+
+  if(pin && w < 8*sizeof(DWORD_PTR))
+    SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << w);
+
+  std::atomic<double>& idle = m_vWorker[w]->m_fIdle; //only this thread writes
+
+  while(true){
+    if(RunOne())continue;
+
+    const auto t0 = std::chrono::steady_clock::now();
+
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cv.wait(lock, [&](){return m_bStop || m_nQueued > 0;});
+      if(m_bStop && m_nQueued == 0)break;
+    }
+
+    idle.store(idle.load(std::memory_order_relaxed) +
+      std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - t0).count(),
+      std::memory_order_relaxed);
+  } //while
+} //WorkerMain
+
+#pragma endregion Scheduling functions
+
+///////////////////////////////////////////////////////////////////////////////
+// Parallel loops
+
+#pragma region Parallel loops
+
+/// Run a loop in parallel by splitting its range into chunks, one task per
+/// chunk, and waiting for them all.
+/// \param n Number of iterations.
+/// \param grain Number of iterations per chunk.
+/// \param f Function taking the start and end of a chunk.
+/// \param priority Priority.
+
+void CThreadPool::ParallelFor(size_t n, size_t grain,
+  const std::function<void(size_t, size_t)>& f, ePriority priority)
+{
+  ParallelFor2D(n, 1, grain, 1, [&](size_t i0, size_t i1, size_t, size_t){
+    f(i0, i1);
+  }, priority); //ParallelFor2D
+} //ParallelFor
+
+/// Run a 2D loop in parallel by splitting its range into blocks, one task per
+/// block, and waiting for them all. Use a column grain equal to the number of
+/// columns for row bands, or a row grain of 1 for single rows. A single block
+/// runs on the calling thread with no scheduling overhead. Batch loops have
+/// their row grain reduced if necessary so that there are at least four
+/// blocks per worker, which keeps each block short and frees up workers for
+/// interactive tasks sooner.
+/// \param rows Number of rows.
+/// \param cols Number of columns.
+/// \param rowgrain Number of rows per block.
+/// \param colgrain Number of columns per block.
+/// \param f Function taking the first row, end row, first column, and end
+/// column of a block.
+/// \param priority Priority.
+
+void CThreadPool::ParallelFor2D(size_t rows, size_t cols, size_t rowgrain,
+  size_t colgrain, const std::function<void(size_t, size_t, size_t, size_t)>& f,
+  ePriority priority)
+{
+  if(rows == 0 || cols == 0)return;
+
+  if(priority == ePriority::Batch){ //at least 4 blocks per worker
+    const size_t colblocks = (cols + max(size_t(1), colgrain) - 1)/
+      max(size_t(1), colgrain);
+    const size_t rowblocks = (4*GetSize() + colblocks - 1)/colblocks;
+    rowgrain = min(rowgrain, (rows + rowblocks - 1)/rowblocks);
+  } //if
+
+  rowgrain = max(size_t(1), rowgrain);
+  colgrain = max(size_t(1), colgrain);
+
+  if(rowgrain >= rows && colgrain >= cols){ //one block
+    f(0, rows, 0, cols);
+    return;
+  } //if
+
+  CTaskGroup group(this, priority);
+
+  for(size_t i=0; i<rows; i+=rowgrain)
+    for(size_t j=0; j<cols; j+=colgrain){
+      const size_t i1 = min(rows, i + rowgrain), j1 = min(cols, j + colgrain);
+      group.Run([&f, i, i1, j, j1](){f(i, i1, j, j1);});
+    } //for
+
+  group.Wait();
+} //ParallelFor2D
+
+#pragma endregion Parallel loops
+
+///////////////////////////////////////////////////////////////////////////////
+// Reader functions
+
+#pragma region Reader functions
+
+/// Set the queue latency target for a priority class. Tasks that wait longer
+/// than this are counted as having missed it.
+/// \param priority Priority class.
+/// \param ms Target in milliseconds.
+
+void CThreadPool::SetLatencyTarget(ePriority priority, double ms){
+  m_sLatency[UINT(priority)].m_nTarget = UINT64(1000*ms);
+} //SetLatencyTarget
+
+/// Get the number of workers.
+/// \return Number of workers.
+
+const UINT CThreadPool::GetSize() const{
+  return UINT(m_vWorker.size());
+} //GetSize
+
+/// Get a snapshot of the worker statistics. Each worker updates its own
+/// statistics in relaxed atomics without locking, so the counters in the
+/// snapshot may be slightly stale and not consistent with each other.
+/// \param v [OUT] Statistics, one per worker.
+
+void CThreadPool::GetStats(std::vector<SWorkerStats>& v){
+  v.resize(m_vWorker.size());
+
+  for(size_t i=0; i<v.size(); i++){
+    const SWorker* p = m_vWorker[i];
+    v[i].nTasks = p->m_nTasks.load(std::memory_order_relaxed);
+    v[i].nSteals = p->m_nSteals.load(std::memory_order_relaxed);
+    v[i].fIdle = p->m_fIdle.load(std::memory_order_relaxed);
+  } //for
+} //GetStats
+
+/// Get the queue latency statistics for a priority class. Percentiles are
+/// the geometric midpoint of the histogram bucket they fall in.
+/// \param priority Priority class.
+/// \return Latency statistics.
+
+const SLatencyStats CThreadPool::GetLatency(ePriority priority){
+  const SLatency& l = m_sLatency[UINT(priority)];
+  SLatencyStats stats;
+  UINT64 count[NUMBUCKETS]; //snapshot of histogram
+
+  for(UINT i=0; i<NUMBUCKETS; i++){
+    count[i] = l.m_nBucket[i];
+    stats.nTasks += count[i];
+  } //for
+
+  stats.nMissed = l.m_nMissed;
+  stats.fTarget = l.m_nTarget/1000.0;
+  stats.fMax = l.m_nMax/1000.0;
+
+  if(stats.nTasks == 0)return stats;
+
+  stats.fMean = l.m_nTotal/1000.0/stats.nTasks;
+
+  auto percentile = [&](double f){
+    const UINT64 rank = UINT64(std::ceil(f*stats.nTasks)); //1-based
+    UINT64 sum = 0;
+    UINT i = 0;
+
+    while(i < NUMBUCKETS - 1 && (sum += count[i]) < rank)
+      i++;
+
+    return min(stats.fMax, (std::exp2((i + 0.5)/4) - 1)/1000);
+  }; //percentile
+
+  stats.fP50 = percentile(0.5);
+  stats.fP99 = percentile(0.99);
+
+  return stats;
+} //GetLatency
+
+/// Get a snapshot of the worker and latency statistics as a JSON object.
+/// \return JSON string.
+
+std::string CThreadPool::GetJSON(){
+  std::vector<SWorkerStats> v;
+  GetStats(v);
+
+  std::string s = "{\"workers\": [";
+
+  for(size_t i=0; i<v.size(); i++){
+    if(i > 0)s += ", ";
+    s += "{\"tasks\": " + std::to_string(v[i].nTasks) +
+      ", \"steals\": " + std::to_string(v[i].nSteals) +
+      ", \"idlems\": " + std::to_string(v[i].fIdle) + "}";
+  } //for
+
+  s += "]";
+
+  const char* name[NUMPRIORITIES] = {"interactive", "batch"};
+
+  for(UINT p=0; p<NUMPRIORITIES; p++){
+    const SLatencyStats l = GetLatency(ePriority(p));
+
+    s += std::string(", \"") + name[p] + "\": {\"tasks\": " +
+      std::to_string(l.nTasks) +
+      ", \"missed\": " + std::to_string(l.nMissed) +
+      ", \"targetms\": " + std::to_string(l.fTarget) +
+      ", \"meanms\": " + std::to_string(l.fMean) +
+      ", \"p50ms\": " + std::to_string(l.fP50) +
+      ", \"p99ms\": " + std::to_string(l.fP99) +
+      ", \"maxms\": " + std::to_string(l.fMax) + "}";
+  } //for
+
+  return s + "}";
+} //GetJSON
+
+/// Get the thread pool shared by every parallel stage in the process, with
+/// one unpinned worker per logical processor.
+/// \return Reference to the shared pool.
+
+CThreadPool& CThreadPool::GetInstance(){
+  static CThreadPool pool;
+  return pool;
+} //GetInstance
+
+#pragma endregion Reader functions
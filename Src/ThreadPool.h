@@ -0,0 +1,198 @@
+/// \file ThreadPool.h
+/// \brief Interface for CThreadPool and CTaskGroup.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef __THREADPOOL_H__
+#define __THREADPOOL_H__
+
+#include "Windows.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class CThreadPool;
+
+/// \brief Task priority class.
+
+enum class ePriority{
+  Interactive, Batch, Size
+}; //ePriority
+
+/// \brief Worker statistics.
+///
+/// A snapshot of one worker's counters, which the worker itself keeps in
+/// relaxed atomics.
+
+struct SWorkerStats{
+  UINT64 nTasks = 0; ///< Number of tasks run.
+  UINT64 nSteals = 0; ///< Number of tasks stolen from other workers.
+  double fIdle = 0; ///< Time spent waiting for work in milliseconds.
+}; //SWorkerStats
+
+/// \brief Queue latency statistics for one priority class.
+///
+/// Latency is the time from a task being submitted to it starting to run.
+/// Percentiles are read from a histogram with four buckets per octave, so
+/// they are accurate to within about 19 percent.
+
+struct SLatencyStats{
+  UINT64 nTasks = 0; ///< Number of tasks run.
+  UINT64 nMissed = 0; ///< Number of tasks that missed the target.
+  double fTarget = 0; ///< Latency target in milliseconds.
+  double fMean = 0; ///< Mean latency in milliseconds.
+  double fP50 = 0; ///< Median latency in milliseconds.
+  double fP99 = 0; ///< 99th percentile latency in milliseconds.
+  double fMax = 0; ///< Maximum latency in milliseconds.
+}; //SLatencyStats
+
+/// \brief Task group.
+///
+/// A task group collects tasks submitted to a thread pool so that they can
+/// be waited for together. While waiting, the calling thread runs queued
+/// tasks of the group's priority or higher itself, so task groups can be
+/// nested and waited on from inside a task without deadlock, and an
+/// interactive wait never runs batch tasks. When there are no such tasks
+/// queued, the rest of the group is running on other threads and the caller
+/// sleeps until they finish. Every task in a group has the group's priority.
+
+class CTaskGroup{
+  friend class CThreadPool;
+
+  private:
+    CThreadPool* m_pPool = nullptr; ///< Pointer to the thread pool.
+    ePriority m_ePriority = ePriority::Batch; ///< Priority of tasks.
+    std::atomic<size_t> m_nPending; ///< Number of unfinished tasks.
+    std::mutex m_mutex; ///< Guards finishing the last task.
+    std::condition_variable m_cv; ///< Signalled when the last task finishes.
+
+    void Finish(); ///< Mark a task as finished.
+
+  public:
+    CTaskGroup(CThreadPool* pPool=nullptr,
+      ePriority priority=ePriority::Batch); ///< Constructor.
+    ~CTaskGroup(); ///< Destructor.
+
+    void Run(const std::function<void()>& f); ///< Submit a task.
+    void Wait(); ///< Wait for all tasks.
+}; //CTaskGroup
+
+/// \brief Work-stealing thread pool.
+///
+/// Each worker has its own double-ended task queue. A worker pushes and pops
+/// tasks at the back of its own queue, so recently submitted tasks that are
+/// still in cache run first, and when its queue is empty it steals from the
+/// front of another worker's queue. Threads that are not workers submit to
+/// a shared queue. The pool can optionally pin each worker to one logical
+/// processor. One pool shared by every parallel stage avoids the
+/// oversubscription that results from each stage creating its own threads.
+///
+/// There are separate queues for each priority class, and interactive tasks
+/// are always taken before batch tasks, so an interactive request waits at
+/// most for the batch tasks that are already running. Batch loops are split
+/// into small chunks, and long batch tasks can call `YieldToInteractive()`
+/// to run any waiting interactive tasks. Queue latency is measured per class
+/// against a target.
+
+class CThreadPool{
+  friend class CTaskGroup;
+
+  private:
+    /// \brief A task.
+
+    struct STask{
+      std::function<void()> m_fnTask; ///< Function to run.
+      CTaskGroup* m_pGroup = nullptr; ///< Task group, if any.
+      ePriority m_ePriority = ePriority::Batch; ///< Priority.
+      std::chrono::steady_clock::time_point m_tSubmit; ///< Submission time.
+    }; //STask
+
+    static const UINT NUMPRIORITIES = UINT(ePriority::Size); ///< Classes.
+    static const UINT NUMBUCKETS = 128; ///< Latency histogram buckets.
+
+    /// \brief Latency histogram for one priority class.
+
+    struct SLatency{
+      std::atomic<UINT64> m_nBucket[NUMBUCKETS]; ///< Counts per bucket.
+      std::atomic<UINT64> m_nMissed; ///< Tasks that missed the target.
+      std::atomic<UINT64> m_nTotal; ///< Total latency in microseconds.
+      std::atomic<UINT64> m_nMax; ///< Maximum latency in microseconds.
+      std::atomic<UINT64> m_nTarget; ///< Target in microseconds.
+    }; //SLatency
+
+    /// \brief A worker.
+
+    struct SWorker{
+      std::thread m_stdThread; ///< Thread.
+      std::deque<STask> m_dqTask[NUMPRIORITIES]; ///< Task queues.
+      std::mutex m_mutex; ///< Guards task queue.
+      std::atomic<UINT64> m_nTasks{0}; ///< Number of tasks run.
+      std::atomic<UINT64> m_nSteals{0}; ///< Number of tasks stolen.
+      std::atomic<double> m_fIdle{0}; ///< Idle time in milliseconds.
+    }; //SWorker
+
+    std::vector<SWorker*> m_vWorker; ///< Workers.
+    std::deque<STask> m_dqShared[NUMPRIORITIES]; ///< Tasks from outside.
+    std::mutex m_mutex; ///< Guards shared queues and sleeping.
+    std::condition_variable m_cv; ///< Signalled when tasks are queued.
+    std::atomic<size_t> m_nQueued; ///< Number of queued tasks.
+    std::atomic<size_t> m_nQueuedInteractive; ///< Queued interactive tasks.
+    bool m_bStop = false; ///< Whether workers should exit.
+
+    SLatency m_sLatency[NUMPRIORITIES]; ///< Latency per priority class.
+
+    void Submit(STask&& task); ///< Queue a task.
+    bool Pop(UINT w, UINT p, STask& task); ///< Get a task of one priority.
+    bool RunOne(UINT p=NUMPRIORITIES - 1); ///< Run one queued task.
+    void RecordLatency(const STask& task); ///< Record queue latency.
+    void WorkerMain(UINT w, bool pin); ///< Worker thread function.
+    int GetWorkerIndex() const; ///< Get index of the calling worker.
+
+  public:
+    CThreadPool(UINT n=0, bool pin=false); ///< Constructor.
+    ~CThreadPool(); ///< Destructor.
+
+    void ParallelFor(size_t n, size_t grain,
+      const std::function<void(size_t, size_t)>& f,
+      ePriority priority=ePriority::Batch); ///< Parallel 1D loop.
+    void ParallelFor2D(size_t rows, size_t cols, size_t rowgrain,
+      size_t colgrain, const std::function<void(size_t, size_t, size_t,
+      size_t)>& f, ePriority priority=ePriority::Batch); ///< Parallel 2D loop.
+    void YieldToInteractive(); ///< Run waiting interactive tasks.
+
+    void SetLatencyTarget(ePriority priority, double ms); ///< Set target.
+    const UINT GetSize() const; ///< Get number of workers.
+    void GetStats(std::vector<SWorkerStats>& v); ///< Get worker statistics.
+    const SLatencyStats GetLatency(ePriority priority); ///< Get latency.
+    std::string GetJSON(); ///< Get statistics as JSON.
+
+    static CThreadPool& GetInstance(); ///< Get shared thread pool.
+}; //CThreadPool
+
+#endif //__THREADPOOL_H__
@@ -0,0 +1,205 @@
+/// \file TileAtlas.cpp
+/// \brief Code for CTileAtlas.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <fstream>
+
+#include "TileAtlas.h"
+#include "WangTiler.h"
+#include "DDS.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructors and destructors
+
+#pragma region Constructors and destructors
+
+/// \param gutter Gutter width in pixels.
+
+CTileAtlas::CTileAtlas(UINT gutter):
+  m_nGutter(gutter){
+} //constructor
+
+#pragma endregion Constructors and destructors
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper functions
+
+#pragma region Helper functions
+
+/// Find a tile with the given edge colors. A negative color means that the
+/// corresponding edge may have any color. Key Fact 1 guarantees that a tile
+/// can be found for any two constraints on adjacent edges.
+/// \param n Number of tiles.
+/// \param top Top color, or -1.
+/// \param left Left color, or -1.
+/// \param bottom Bottom color, or -1.
+/// \param right Right color, or -1.
+/// \return Index of the first matching tile, or 0 if there is none.
+
+UINT CTileAtlas::FindTile(UINT n, int top, int left, int bottom, int right) const{
+  for(UINT t=0; t<n; t++)
+    if((top    < 0 || int(CWangTiler::GetTopColor(t))    == top) &&
+       (left   < 0 || int(CWangTiler::GetLeftColor(t))   == left) &&
+       (bottom < 0 || int(CWangTiler::GetBottomColor(t)) == bottom) &&
+       (right  < 0 || int(CWangTiler::GetRightColor(t))  == right))
+      return t;
+
+  return 0;
+} //FindTile
+
+/// Make the next mip level by averaging 2x2 squares of pixels, clamping at
+/// the bottom and right edges for odd sizes. The inner loop works on one
+/// byte channel at a time with no branches so that the compiler can
+/// vectorize it.
+/// \param src Source pixels.
+/// \param w Source width.
+/// \param h Source height.
+/// \param dest [OUT] Destination pixels, resized to fit.
+
+void CTileAtlas::Downsample(const std::vector<UINT>& src, UINT w, UINT h,
+  std::vector<UINT>& dest) const
+{
+  const UINT w2 = max(1U, w/2), h2 = max(1U, h/2);
+  dest.resize(size_t(w2)*h2);
+
+  for(UINT i=0; i<h2; i++){
+    const BYTE* row0 = (const BYTE*)&src[size_t(min(2*i, h - 1))*w];
+    const BYTE* row1 = (const BYTE*)&src[size_t(min(2*i + 1, h - 1))*w];
+    BYTE* out = (BYTE*)&dest[size_t(i)*w2];
+
+    for(UINT j=0; j<w2; j++){
+      const UINT x0 = 4*min(2*j, w - 1), x1 = 4*min(2*j + 1, w - 1);
+
+      for(UINT c=0; c<4; c++)
+        out[4*j + c] = BYTE((row0[x0 + c] + row0[x1 + c] +
+          row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+    } //for
+  } //for
+} //Downsample
+
+#pragma endregion Helper functions
+
+///////////////////////////////////////////////////////////////////////////////
+// Build and save
+
+#pragma region Build and save
+
+/// Build the atlas. Each element consists of a tile surrounded by a gutter.
+/// The gutter on each side of a tile is copied from a tile whose opposite edge
+/// has a matching color, and each corner of the gutter from a tile that
+/// matches the two tiles used for the adjacent sides, exactly as if the tile
+/// were surrounded by a valid Wang tiling. Then the full mip chain is
+/// generated for each element independently.
+/// \param tiles Tile pixels, 32-bit ARGB in row-major order.
+/// \param w Tile width in pixels.
+/// \param h Tile height in pixels.
+/// \return S_OK for success, E_FAIL if the gutter is wider than a tile.
+
+HRESULT CTileAtlas::Build(const std::vector<std::vector<UINT>>& tiles,
+  UINT w, UINT h)
+{
+  const UINT n = UINT(tiles.size()); //number of tiles
+  const UINT g = m_nGutter; //gutter width
+
+  if(n == 0 || w == 0 || h == 0 || g > w || g > h)return E_FAIL;
+
+  m_nWidth  = w + 2*g;
+  m_nHeight = h + 2*g;
+  m_nMips = 1;
+
+  for(UINT s=max(m_nWidth, m_nHeight); s>1; s>>=1)
+    m_nMips++;
+
+  m_vMip.assign(n, std::vector<std::vector<UINT>>(m_nMips));
+
+  for(UINT t=0; t<n; t++){
+    UINT nbr[3][3]; //neighbors, indexed by row and column offset plus 1
+
+    nbr[1][1] = t;
+    nbr[1][2] = FindTile(n, -1, CWangTiler::GetRightColor(t), -1, -1);
+    nbr[1][0] = FindTile(n, -1, -1, -1, CWangTiler::GetLeftColor(t));
+    nbr[2][1] = FindTile(n, CWangTiler::GetBottomColor(t), -1, -1, -1);
+    nbr[0][1] = FindTile(n, -1, -1, CWangTiler::GetTopColor(t), -1);
+
+    nbr[2][2] = FindTile(n, CWangTiler::GetBottomColor(nbr[1][2]),
+      CWangTiler::GetRightColor(nbr[2][1]), -1, -1);
+    nbr[2][0] = FindTile(n, CWangTiler::GetBottomColor(nbr[1][0]), -1, -1,
+      CWangTiler::GetLeftColor(nbr[2][1]));
+    nbr[0][2] = FindTile(n, -1, CWangTiler::GetRightColor(nbr[0][1]),
+      CWangTiler::GetTopColor(nbr[1][2]), -1);
+    nbr[0][0] = FindTile(n, -1, -1, CWangTiler::GetTopColor(nbr[1][0]),
+      CWangTiler::GetLeftColor(nbr[0][1]));
+
+    std::vector<UINT>& dest = m_vMip[t][0];
+    dest.resize(size_t(m_nWidth)*m_nHeight);
+
+    for(UINT i=0; i<m_nHeight; i++){
+      const int y = int(i) - int(g); //row relative to tile
+      const UINT r = y < 0? 0: y < int(h)? 1: 2; //neighbor row
+
+      for(UINT j=0; j<m_nWidth; j++){
+        const int x = int(j) - int(g); //column relative to tile
+        const UINT c = x < 0? 0: x < int(w)? 1: 2; //neighbor column
+        const UINT sy = UINT((y + int(h))%int(h)); //source row
+        const UINT sx = UINT((x + int(w))%int(w)); //source column
+
+        dest[size_t(i)*m_nWidth + j] = tiles[nbr[r][c]][size_t(sy)*w + sx];
+      } //for
+    } //for
+
+    UINT mw = m_nWidth, mh = m_nHeight; //mip size
+
+    for(UINT k=1; k<m_nMips; k++){
+      Downsample(m_vMip[t][k - 1], mw, mh, m_vMip[t][k]);
+      mw = max(1U, mw/2);
+      mh = max(1U, mh/2);
+    } //for
+  } //for
+
+  return S_OK;
+} //Build
+
+/// Save the atlas as an uncompressed 32-bit BGRA DDS texture array with a
+/// full mip chain for each element, in tile index order.
+/// `Build()` must have been called first.
+/// \param filename Name of the DDS file.
+/// \return S_OK for success, E_FAIL for failure.
+
+HRESULT CTileAtlas::Save(const std::wstring& filename) const{
+  if(m_vMip.empty())return E_FAIL; //nothing built
+
+  std::ofstream s(filename, std::ios::binary);
+  if(!s.is_open())return E_FAIL;
+
+  if(FAILED(WriteDDSHeader(s, m_nWidth, m_nHeight, DDS_FORMAT_BGRA, m_nMips,
+    UINT(m_vMip.size()))))return E_FAIL;
+
+  for(const std::vector<std::vector<UINT>>& element: m_vMip)
+    for(const std::vector<UINT>& mip: element) //32-bit ARGB is BGRA in memory
+      s.write((const char*)mip.data(), 4*mip.size());
+
+  return s.good()? S_OK: E_FAIL;
+} //Save
+
+#pragma endregion Build and save
@@ -0,0 +1,65 @@
+/// \file TileAtlas.h
+/// \brief Interface for CTileAtlas.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef __TILEATLAS_H__
+#define __TILEATLAS_H__
+
+#include "Windows.h"
+#include <string>
+#include <vector>
+
+/// \brief Tile atlas.
+///
+/// A tile atlas is a texture array with one element per tile, suitable for
+/// looking up Wang tiles in a shader. Each element is surrounded by a gutter
+/// filled in from neighbouring tiles whose edge colors match, so that bilinear
+/// filtering across a tile edge samples the same pixels it would in a real
+/// tiling. Each element has its own full mip chain, so nothing bleeds between
+/// tiles at any mip level.
+
+class CTileAtlas{
+  private:
+    UINT m_nGutter = 4; ///< Gutter width in pixels.
+
+    UINT m_nWidth = 0; ///< Element width in pixels, including gutters.
+    UINT m_nHeight = 0; ///< Element height in pixels, including gutters.
+    UINT m_nMips = 0; ///< Number of mip levels.
+
+    std::vector<std::vector<std::vector<UINT>>> m_vMip; ///< Mips per element.
+
+    UINT FindTile(UINT n, int top, int left, int bottom,
+      int right) const; ///< Find tile with given edge colors.
+    void Downsample(const std::vector<UINT>& src, UINT w, UINT h,
+      std::vector<UINT>& dest) const; ///< Make next mip level.
+
+  public:
+    CTileAtlas(UINT gutter=4); ///< Constructor.
+
+    HRESULT Build(const std::vector<std::vector<UINT>>& tiles,
+      UINT w, UINT h); ///< Build atlas from tiles.
+    HRESULT Save(const std::wstring& filename) const; ///< Save as DDS array.
+}; //CTileAtlas
+
+#endif //__TILEATLAS_H__
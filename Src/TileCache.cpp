@@ -0,0 +1,201 @@
+/// \file TileCache.cpp
+/// \brief Code for CTile and CTileCache.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "TileCache.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// CTile functions
+
+#pragma region CTile functions
+
+/// Take ownership of the pixels and create a bitmap that uses them.
+/// \param v Pixels, 32-bit ARGB in row-major order.
+/// \param w Width in pixels.
+/// \param h Height in pixels.
+/// \param hash Hash of size and pixels.
+
+CTile::CTile(std::vector<UINT>&& v, UINT w, UINT h, UINT64 hash):
+  m_nWidth(w), m_nHeight(h), m_vPixels(std::move(v)), m_nHash(hash)
+{
+  m_pBitmap = new Gdiplus::Bitmap(w, h, 4*w, PixelFormat32bppARGB,
+    (BYTE*)m_vPixels.data());
+} //constructor
+
+/// Delete the bitmap. The pixels go with the vector.
+
+CTile::~CTile(){
+  delete m_pBitmap;
+} //destructor
+
+/// Reader function for `m_nWidth`.
+/// \return `m_nWidth`.
+
+const UINT CTile::GetWidth() const{
+  return m_nWidth;
+} //GetWidth
+
+/// Reader function for `m_nHeight`.
+/// \return `m_nHeight`.
+
+const UINT CTile::GetHeight() const{
+  return m_nHeight;
+} //GetHeight
+
+/// Reader function for `m_vPixels`.
+/// \return `m_vPixels`.
+
+const std::vector<UINT>& CTile::GetPixels() const{
+  return m_vPixels;
+} //GetPixels
+
+/// Reader function for `m_pBitmap`.
+/// \return `m_pBitmap`.
+
+Gdiplus::Bitmap* CTile::GetBitmap() const{
+  return m_pBitmap;
+} //GetBitmap
+
+#pragma endregion CTile functions
+
+///////////////////////////////////////////////////////////////////////////////
+// CTileCache functions
+
+#pragma region CTileCache functions
+
+/// Delete any tiles that were never released.
+
+CTileCache::~CTileCache(){
+  for(auto& bucket: m_mapTile)
+    for(CTile* p: bucket.second)
+      delete p;
+} //destructor
+
+/// Hash the size and pixels of a tile, one 32-bit pixel at a time, using a
+/// multiply and rotate step with a final avalanche. This is not a
+/// cryptographic hash, so `Acquire()` compares pixels when hashes match.
+/// The pixels may be a tile-sized rectangle of a larger image, which hashes
+/// the same as a tile with identical pixels.
+/// \param p First pixel, 32-bit ARGB.
+/// \param stride Pixels per row of the image that contains them.
+/// \param w Width in pixels.
+/// \param h Height in pixels.
+/// \return 64-bit hash.
+
+UINT64 CTileCache::Hash(const UINT* p, size_t stride, UINT w, UINT h){
+  const UINT64 k = 0x9E3779B97F4A7C15ULL; //golden ratio
+  UINT64 hash = (UINT64(w) << 32 | h)*k;
+
+  for(UINT i=0; i<h; i++)
+    for(UINT j=0; j<w; j++){
+      hash = (hash ^ p[i*stride + j])*k;
+      hash ^= hash >> 29;
+    } //for
+
+  hash ^= hash >> 33;
+  hash *= 0xFF51AFD7ED558CCDULL;
+  hash ^= hash >> 33;
+
+  return hash;
+} //Hash
+
+/// Get a tile with the given pixels. If an identical tile is already in the
+/// cache then its reference count is incremented and it is returned,
+/// otherwise a new tile is created that takes ownership of the pixels.
+/// \param v Pixels, 32-bit ARGB in row-major order.
+/// \param w Width in pixels.
+/// \param h Height in pixels.
+/// \return Pointer to a tile, to be released with `Release()`.
+
+CTile* CTileCache::Acquire(std::vector<UINT>&& v, UINT w, UINT h){
+  const UINT64 hash = Hash(v.data(), w, w, h); //hash outside the lock
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::vector<CTile*>& bucket = m_mapTile[hash];
+
+  for(CTile* p: bucket)
+    if(p->m_nWidth == w && p->m_nHeight == h && p->m_vPixels == v){
+      p->m_nRefCount++;
+      return p;
+    } //if
+
+  CTile* p = new CTile(std::move(v), w, h, hash);
+  p->m_nRefCount = 1;
+  bucket.push_back(p);
+
+  m_nCount++;
+  m_nBytes += 4*p->m_vPixels.size();
+
+  return p;
+} //Acquire
+
+/// Release a reference to a tile, and evict it from the cache if that was
+/// the last reference.
+/// \param p Pointer to a tile from `Acquire()`.
+
+void CTileCache::Release(CTile* p){
+  if(p == nullptr)return;
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if(--p->m_nRefCount > 0)return;
+
+  auto it = m_mapTile.find(p->m_nHash);
+
+  if(it != m_mapTile.end()){
+    std::vector<CTile*>& bucket = it->second;
+
+    for(size_t i=0; i<bucket.size(); i++)
+      if(bucket[i] == p){
+        bucket[i] = bucket.back();
+        bucket.pop_back();
+        break;
+      } //if
+
+    if(bucket.empty())
+      m_mapTile.erase(it);
+  } //if
+
+  m_nCount--;
+  m_nBytes -= 4*p->m_vPixels.size();
+
+  delete p;
+} //Release
+
+/// Get the number of distinct tiles in the cache.
+/// \return Number of tiles.
+
+const size_t CTileCache::GetCount(){
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_nCount;
+} //GetCount
+
+/// Get the number of bytes of pixel data in the cache, which is the resident
+/// memory used by all loaded tile sets.
+/// \return Number of bytes.
+
+const size_t CTileCache::GetBytes(){
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_nBytes;
+} //GetBytes
+
+#pragma endregion CTileCache functions
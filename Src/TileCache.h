@@ -0,0 +1,91 @@
+/// \file TileCache.h
+/// \brief Interface for CTile and CTileCache.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef __TILECACHE_H__
+#define __TILECACHE_H__
+
+#include "Includes.h"
+
+#include <mutex>
+#include <unordered_map>
+
+/// \brief A decoded tile.
+///
+/// The pixels of a tile image together with a GDI+ bitmap that draws directly
+/// from them. Tiles are owned by a tile cache and shared by reference between
+/// every tile set that contains an identical image.
+
+class CTile{
+  friend class CTileCache;
+
+  private:
+    UINT m_nWidth = 0; ///< Width in pixels.
+    UINT m_nHeight = 0; ///< Height in pixels.
+    std::vector<UINT> m_vPixels; ///< 32-bit ARGB pixels in row-major order.
+    Gdiplus::Bitmap* m_pBitmap = nullptr; ///< Bitmap using `m_vPixels`.
+
+    UINT64 m_nHash = 0; ///< Hash of size and pixels.
+    UINT m_nRefCount = 0; ///< Number of references.
+
+    CTile(std::vector<UINT>&& v, UINT w, UINT h, UINT64 hash); ///< Constructor.
+    ~CTile(); ///< Destructor.
+
+  public:
+    const UINT GetWidth() const; ///< Get width.
+    const UINT GetHeight() const; ///< Get height.
+    const std::vector<UINT>& GetPixels() const; ///< Get pixels.
+    Gdiplus::Bitmap* GetBitmap() const; ///< Get bitmap.
+}; //CTile
+
+/// \brief Content-addressed tile cache.
+///
+/// Decoded tiles are stored once per distinct image, keyed by a hash of their
+/// size and pixels, and reference counted. Acquiring a tile that is identical
+/// to one already in the cache returns the existing tile, so tile sets that
+/// share images share memory. A tile is evicted when its last reference is
+/// released. All functions are thread-safe.
+
+class CTileCache{
+  private:
+    std::unordered_map<UINT64, std::vector<CTile*>> m_mapTile; ///< Tiles by hash.
+    std::mutex m_mutex; ///< Guards everything.
+
+    size_t m_nCount = 0; ///< Number of distinct tiles.
+    size_t m_nBytes = 0; ///< Bytes of pixel data.
+
+  public:
+    ~CTileCache(); ///< Destructor.
+
+    CTile* Acquire(std::vector<UINT>&& v, UINT w, UINT h); ///< Get tile.
+    void Release(CTile* p); ///< Release tile.
+
+    const size_t GetCount(); ///< Get number of distinct tiles.
+    const size_t GetBytes(); ///< Get bytes of pixel data.
+
+    static UINT64 Hash(const UINT* p, size_t stride, UINT w,
+      UINT h); ///< Hash pixels.
+}; //CTileCache
+
+#endif //__TILECACHE_H__
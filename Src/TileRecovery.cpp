@@ -0,0 +1,252 @@
+/// \file TileRecovery.cpp
+/// \brief Code for CTileRecovery.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "TileRecovery.h"
+#include "Helpers.h"
+#include "ThreadPool.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructors and destructors
+
+#pragma region Constructors and destructors
+
+/// Hash the pixels of every tile in the tile set. If two tiles are identical
+/// then the first one is the one that is recovered.
+/// \param pTileSet Pointer to a tile set.
+/// \param threshold Largest mean absolute difference per color channel for
+/// an approximate match.
+
+CTileRecovery::CTileRecovery(const CTileSet* pTileSet, UINT threshold):
+  m_pTileSet(pTileSet), m_nThreshold(threshold)
+{
+  const UINT w = pTileSet->GetTileWidth(), h = pTileSet->GetTileHeight();
+
+  for(UINT i=0; i<pTileSet->GetSize(); i++){
+    const UINT* p = pTileSet->GetTile(i)->GetPixels().data();
+    m_mapHash.insert(std::make_pair(CTileCache::Hash(p, w, w, h), i));
+  } //for
+} //constructor
+
+#pragma endregion Constructors and destructors
+
+///////////////////////////////////////////////////////////////////////////////
+// Match functions
+
+#pragma region Match functions
+
+/// Compute the sum of absolute differences of the red, green, and blue
+/// components of a tile and a tile-sized cell of an image, one row at a
+/// time, giving up at the end of a row once it exceeds a bound.
+/// \param a Tile pixels, 32-bit ARGB in row-major order.
+/// \param b First pixel of the cell.
+/// \param stride Pixels per image row.
+/// \param w Tile width in pixels.
+/// \param h Tile height in pixels.
+/// \param bound Bound, usually the best sum found so far.
+/// \return Sum of absolute differences, or a number larger than the bound.
+
+UINT64 CTileRecovery::Distance(const UINT* a, const UINT* b, size_t stride,
+  UINT w, UINT h, UINT64 bound)
+{
+  UINT64 sum = 0;
+
+  for(UINT i=0; i<h && sum<=bound; i++) //ignore alpha
+    sum += SumAbsDiff(a + size_t(i)*w, b + i*stride, w, 0x00FFFFFF);
+
+  return sum;
+} //Distance
+
+/// Match one cell of an image to a tile. The cell's hash is looked up first,
+/// and a tile with the same hash is the match if its pixels are identical.
+/// Otherwise the tile with the smallest sum of absolute differences is the
+/// best match, which counts as a match if the mean absolute difference per
+/// color channel is no more than the threshold.
+/// \param p First pixel of the cell.
+/// \param stride Pixels per image row.
+/// \param exact [OUT] true if the cell is identical to the tile.
+/// \param matched [OUT] true if the cell matches the tile.
+/// \return Index of the matching tile, or of the best match if none.
+
+UINT CTileRecovery::Match(const UINT* p, size_t stride, bool& exact,
+  bool& matched) const
+{
+  const UINT w = m_pTileSet->GetTileWidth(), h = m_pTileSet->GetTileHeight();
+  const auto it = m_mapHash.find(CTileCache::Hash(p, stride, w, h));
+
+  exact = false;
+
+  if(it != m_mapHash.end()){ //check for a hash collision
+    const UINT* q = m_pTileSet->GetTile(it->second)->GetPixels().data();
+    exact = true;
+
+    for(UINT i=0; i<h && exact; i++)
+      exact = memcmp(q + size_t(i)*w, p + i*stride, w*sizeof(UINT)) == 0;
+
+    if(exact){
+      matched = true;
+      return it->second;
+    } //if
+  } //if
+
+  UINT64 best = ~0ULL; //smallest sum of absolute differences
+  UINT index = 0; //tile with the smallest sum
+
+  for(UINT t=0; t<m_pTileSet->GetSize(); t++){
+    const UINT* q = m_pTileSet->GetTile(t)->GetPixels().data();
+    const UINT64 d = Distance(q, p, stride, w, h, best);
+
+    if(d < best){
+      best = d;
+      index = t;
+    } //if
+  } //for
+
+  matched = best <= UINT64(m_nThreshold)*3*w*h;
+  return index;
+} //Match
+
+/// Recover the tile indices of a tiling from a rendered image. The image
+/// must be exactly as large as the tiling. Any cell that does not match is
+/// given the index of the nearest tile, and adjacent cells whose edge colors
+/// differ are counted, so that a caller can tell how trustworthy the result
+/// is.
+/// \param v Image pixels, 32-bit ARGB in row-major order.
+/// \param w Image width in pixels.
+/// \param h Image height in pixels.
+/// \param tiler [OUT] Wang tiler to receive the tile indices.
+/// \return S_OK if every cell matched, E_FAIL if some did not or the sizes
+/// are wrong.
+
+HRESULT CTileRecovery::Recover(const std::vector<UINT>& v, UINT w, UINT h,
+  CWangTiler& tiler)
+{
+  const size_t tw = m_pTileSet->GetTileWidth();
+  const size_t th = m_pTileSet->GetTileHeight();
+  const size_t rows = tiler.GetHeight(), cols = tiler.GetWidth();
+
+  m_nExact = m_nApprox = m_nUnmatched = m_nMismatches = 0;
+
+  if(m_pTileSet->GetSize() == 0 || w != cols*tw || h != rows*th ||
+    v.size() < size_t(w)*h)return E_FAIL;
+
+  std::vector<size_t> exact(rows), approx(rows); //matches per row
+
+  CThreadPool::GetInstance().ParallelFor(rows, 1, [&](size_t i0, size_t i1){
+    for(size_t i=i0; i<i1; i++){
+      UINT* row = tiler.GetRow(i);
+
+      for(size_t j=0; j<cols; j++){
+        bool bExact = false, bMatched = false;
+        row[j] = Match(&v[i*th*w + j*tw], w, bExact, bMatched);
+        if(bExact)exact[i]++;
+        else if(bMatched)approx[i]++;
+      } //for
+    } //for
+  }); //ParallelFor
+
+  for(size_t i=0; i<rows; i++){
+    m_nExact += exact[i];
+    m_nApprox += approx[i];
+  } //for
+
+  m_nUnmatched = rows*cols - m_nExact - m_nApprox;
+
+  for(size_t i=0; i<rows; i++)
+    for(size_t j=0; j<cols; j++){
+      const UINT t = UINT(tiler(i, j));
+
+      if(j + 1 < cols && CWangTiler::GetRightColor(t) !=
+        CWangTiler::GetLeftColor(UINT(tiler(i, j + 1))))m_nMismatches++;
+
+      if(i + 1 < rows && CWangTiler::GetBottomColor(t) !=
+        CWangTiler::GetTopColor(UINT(tiler(i + 1, j))))m_nMismatches++;
+    } //for
+
+  return m_nUnmatched == 0? S_OK: E_FAIL;
+} //Recover
+
+#pragma endregion Match functions
+
+///////////////////////////////////////////////////////////////////////////////
+// Reader functions
+
+#pragma region Reader functions
+
+/// Reader function for the number of cells found by hash.
+/// \return Number of exact matches in the last recovery.
+
+const size_t CTileRecovery::GetExact() const{
+  return m_nExact;
+} //GetExact
+
+/// Reader function for the number of cells matched by sum of absolute
+/// differences.
+/// \return Number of approximate matches in the last recovery.
+
+const size_t CTileRecovery::GetApprox() const{
+  return m_nApprox;
+} //GetApprox
+
+/// Reader function for the number of cells that did not match any tile.
+/// \return Number of unmatched cells in the last recovery.
+
+const size_t CTileRecovery::GetUnmatched() const{
+  return m_nUnmatched;
+} //GetUnmatched
+
+/// Reader function for the number of pairs of adjacent cells whose shared
+/// edge has different colors, which should be 0 for a correct recovery.
+/// \return Number of mismatched edges in the last recovery.
+
+const size_t CTileRecovery::GetMismatches() const{
+  return m_nMismatches;
+} //GetMismatches
+
+/// Get the results of the last recovery as JSON, with the tile indices as an
+/// array of rows.
+/// \param tiler Wang tiler passed to `Recover()`.
+/// \return JSON string.
+
+std::string CTileRecovery::GetJSON(const CWangTiler& tiler) const{
+  std::string s = "{\"width\": " + std::to_string(tiler.GetWidth()) +
+    ", \"height\": " + std::to_string(tiler.GetHeight()) +
+    ", \"exact\": " + std::to_string(m_nExact) +
+    ", \"approximate\": " + std::to_string(m_nApprox) +
+    ", \"unmatched\": " + std::to_string(m_nUnmatched) +
+    ", \"mismatches\": " + std::to_string(m_nMismatches) + ", \"tiles\": [";
+
+  for(size_t i=0; i<tiler.GetHeight(); i++){
+    s += i > 0? ", [": "[";
+
+    for(size_t j=0; j<tiler.GetWidth(); j++)
+      s += (j > 0? ", ": "") + std::to_string(tiler(i, j));
+
+    s += "]";
+  } //for
+
+  return s + "]}";
+} //GetJSON
+
+#pragma endregion Reader functions
@@ -0,0 +1,78 @@
+/// \file TileRecovery.h
+/// \brief Interface for CTileRecovery.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef __TILERECOVERY_H__
+#define __TILERECOVERY_H__
+
+#include "Includes.h"
+#include <unordered_map>
+
+#include "WangTiler.h"
+#include "TileSet.h"
+
+/// \brief Tile recovery.
+///
+/// Recovers the tile indices of a Wang tiling from a rendered image of it,
+/// such as one saved from the `File` menu, so that it can be re-rendered with
+/// another tile set or at another resolution. Each tile-sized cell of the
+/// image is hashed with the tile cache's hash and looked up in a table of the
+/// tile hashes, which finds lossless copies of a tile in one pass over its
+/// pixels. A cell that is not found, for example because the image was
+/// saved with lossy compression, is matched to the tile with the smallest
+/// sum of absolute differences of red, green, and blue, computed with SSE2
+/// and abandoned as soon as it exceeds the best so far. Cells are recovered
+/// one row of tiles per task on the shared thread pool.
+
+class CTileRecovery{
+  private:
+    const CTileSet* m_pTileSet = nullptr; ///< Tile set.
+    std::unordered_map<UINT64, UINT> m_mapHash; ///< Tile index by hash.
+    UINT m_nThreshold = 16; ///< Largest mean error for a match.
+
+    size_t m_nExact = 0; ///< Number of cells found by hash.
+    size_t m_nApprox = 0; ///< Number of cells matched within the threshold.
+    size_t m_nUnmatched = 0; ///< Number of cells not matched.
+    size_t m_nMismatches = 0; ///< Number of edges whose colors differ.
+
+    static UINT64 Distance(const UINT* a, const UINT* b, size_t stride,
+      UINT w, UINT h, UINT64 bound); ///< Sum of absolute differences.
+    UINT Match(const UINT* p, size_t stride, bool& exact,
+      bool& matched) const; ///< Match one cell.
+
+  public:
+    CTileRecovery(const CTileSet* pTileSet,
+      UINT threshold=16); ///< Constructor.
+
+    HRESULT Recover(const std::vector<UINT>& v, UINT w, UINT h,
+      CWangTiler& tiler); ///< Recover tile indices.
+
+    const size_t GetExact() const; ///< Get number of exact matches.
+    const size_t GetApprox() const; ///< Get number of approximate matches.
+    const size_t GetUnmatched() const; ///< Get number of unmatched cells.
+    const size_t GetMismatches() const; ///< Get number of bad edges.
+    std::string GetJSON(const CWangTiler& tiler) const; ///< Get as JSON.
+}; //CTileRecovery
+
+#endif //__TILERECOVERY_H__
@@ -0,0 +1,634 @@
+/// \file TileSet.cpp
+/// \brief Code for CTileSet.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <fstream>
+#include <sstream>
+
+#include "TileSet.h"
+#include "SuperTiler.h"
+#include "EdgeInference.h"
+#include "WindowsHelpers.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructors and destructors
+
+#pragma region Constructors and destructors
+
+/// \param pCache Pointer to the tile cache.
+
+CTileSet::CTileSet(CTileCache* pCache):
+  m_pCache(pCache){
+} //constructor
+
+/// Release all tiles back to the cache.
+
+CTileSet::~CTileSet(){
+  Clear();
+} //destructor
+
+#pragma endregion Constructors and destructors
+
+///////////////////////////////////////////////////////////////////////////////
+// Load functions
+
+#pragma region Load functions
+
+/// Release all tiles and super-tiles back to the cache.
+
+void CTileSet::Clear(){
+  for(CTile* p: m_vTile)
+    m_pCache->Release(p);
+
+  for(SSuperTile& t: m_vSuper)
+    m_pCache->Release(t.m_pTile);
+
+  m_vTile.clear();
+  m_vSuper.clear();
+  m_vNav.clear();
+  m_nNavSize = 0;
+  m_vMask.clear();
+  m_nMaskStride = 0;
+} //Clear
+
+/// Determine whether a file exists in the tile folder, or in the zip archive
+/// that tiles are being loaded from.
+/// \param folder Tile folder or zip file name.
+/// \param name File name relative to the folder.
+/// \return true if the file exists.
+
+bool CTileSet::Exists(const std::wstring& folder,
+  const std::wstring& name) const
+{
+  if(m_pArchive != nullptr)
+    return m_pArchive->Contains(std::string(name.begin(), name.end()));
+
+  return std::ifstream(folder + L"\\" + name).is_open();
+} //Exists
+
+/// Read a whole text file from the tile folder, or from the zip archive that
+/// tiles are being loaded from.
+/// \param folder Tile folder or zip file name.
+/// \param name File name relative to the folder.
+/// \param text [OUT] File contents.
+/// \return S_OK for success, E_FAIL if the file cannot be read.
+
+HRESULT CTileSet::ReadText(const std::wstring& folder,
+  const std::wstring& name, std::string& text) const
+{
+  if(m_pArchive != nullptr){
+    std::vector<BYTE> v; //file contents
+    const std::string s(name.begin(), name.end()); //entry name
+    if(FAILED(m_pArchive->Extract(s, v)))return E_FAIL;
+
+    text.assign(v.begin(), v.end());
+    return S_OK;
+  } //if
+
+  std::ifstream in(folder + L"\\" + name);
+  if(!in.is_open())return E_FAIL;
+
+  std::ostringstream ss;
+  ss << in.rdbuf();
+  text = ss.str();
+
+  return S_OK;
+} //ReadText
+
+/// Read and decode an image file from the tile folder, or inflate and decode
+/// it from the zip archive that tiles are being loaded from. This is const
+/// and may be called from several threads at once.
+/// \param folder Tile folder or zip file name.
+/// \param name File name relative to the folder.
+/// \param v [OUT] 32-bit ARGB pixels in row-major order.
+/// \param w [OUT] Image width.
+/// \param h [OUT] Image height.
+/// \return S_OK for success, E_FAIL if the image cannot be read.
+
+HRESULT CTileSet::ReadImage(const std::wstring& folder,
+  const std::wstring& name, std::vector<UINT>& v, UINT& w, UINT& h) const
+{
+  if(m_pArchive != nullptr){
+    std::vector<BYTE> file; //file contents
+    const std::string s(name.begin(), name.end()); //entry name
+
+    if(FAILED(m_pArchive->Extract(s, file)))return E_FAIL;
+    return DecodeImage(file, v, w, h);
+  } //if
+
+  const std::wstring filename = folder + L"\\" + name;
+  Gdiplus::Bitmap* pBitmap = Gdiplus::Bitmap::FromFile(filename.c_str());
+  HRESULT hr = E_FAIL;
+
+  if(pBitmap->GetLastStatus() == Gdiplus::Ok &&
+    SUCCEEDED(GetPixels(pBitmap, v)))
+  {
+    w = pBitmap->GetWidth();
+    h = pBitmap->GetHeight();
+    hr = S_OK;
+  } //if
+
+  delete pBitmap;
+  return hr;
+} //ReadImage
+
+/// Load tiles from numbered png files in a folder, or in a zip archive that
+/// is used in place of the folder. Zip archives are memory-mapped rather
+/// than extracted to disk, and the files that are needed are inflated
+/// straight into memory. The images are read and decoded in parallel on the
+/// thread pool and then handed, in order, to the tile cache, which keeps only
+/// one copy of identical images. If any tile fails to load, or the tiles are
+/// not all the same size, then the tile set is left empty. The edge colors
+/// of a set of 8 tiles are then inferred from the images, and if that
+/// succeeds the tiles are put in the order that the Wang tiler expects,
+/// whatever order the files are numbered in. Navigation masks are loaded
+/// before that, so that they are put in the same order, if the folder has a
+/// `nav.txt` file, and so are collision masks if it has a `mask` subfolder.
+/// Super-tiles are loaded after it if the folder has a `super.txt` file.
+/// \param folder Folder containing files `0.png` through `n-1.png`, or the
+/// name of a zip file ending in `.zip` that contains them.
+/// \param n Number of tiles.
+/// \param filename [OUT] Name of the last file attempted.
+/// \return S_OK if the tiles loaded correctly, E_FAIL otherwise.
+
+HRESULT CTileSet::Load(const std::wstring& folder, const UINT n,
+  std::wstring& filename)
+{
+  Clear();
+
+  CZipArchive archive; //used if the folder is a zip file
+  const size_t len = folder.size(); //length of folder name
+
+  if(len > 4 && _wcsicmp(folder.c_str() + len - 4, L".zip") == 0){
+    filename = folder;
+    if(FAILED(archive.Open(folder)))return E_FAIL;
+    m_pArchive = &archive;
+  } //if
+
+  std::vector<std::vector<UINT>> v(n); //pixels of each tile
+  std::vector<UINT> w(n), h(n); //width and height of each tile
+  std::vector<HRESULT> hr(n, E_FAIL); //result for each tile
+
+  CThreadPool::GetInstance().ParallelFor(n, 1, [&](size_t i0, size_t i1){
+    for(size_t i=i0; i<i1; i++)
+      hr[i] = ReadImage(folder, std::to_wstring(i) + L".png", v[i], w[i], h[i]);
+  }); //ParallelFor
+
+  bool error = false;
+
+  for(UINT i=0; i<n && !error; i++){ //for each tile, in order
+    filename = folder + L"\\" + std::to_wstring(i) + L".png";
+    error = FAILED(hr[i]) ||
+      (i > 0 && (w[i] != GetTileWidth() || h[i] != GetTileHeight()));
+    if(!error)m_vTile.push_back(m_pCache->Acquire(std::move(v[i]), w[i], h[i]));
+  } //for
+
+  error = error || FAILED(LoadNav(folder, filename));
+  error = error || FAILED(LoadMasks(folder, filename));
+
+  if(!error && n == 8){ //put tiles in order of their inferred edge colors
+    CEdgeInference inference;
+
+    if(SUCCEEDED(inference.Infer(m_vTile))){
+      const std::vector<CTile*> file(m_vTile); //tiles in file order
+      const std::vector<BYTE> nav(m_vNav); //masks in file order
+      const std::vector<UINT64> mask(m_vMask); //masks in file order
+      const size_t k = size_t(m_nNavSize)*m_nNavSize; //nav mask size
+      const size_t m = size_t(m_nMaskStride)*GetTileHeight(); //mask size
+
+      for(UINT i=0; i<n; i++){
+        const UINT f = inference.GetOrder()[i]; //file number
+        m_vTile[i] = file[f];
+
+        for(size_t j=0; j<k; j++)
+          m_vNav[i*k + j] = nav[f*k + j];
+
+        for(size_t j=0; j<m; j++)
+          m_vMask[i*m + j] = mask[f*m + j];
+      } //for
+    } //if
+  } //if
+
+  error = error || FAILED(LoadSuper(folder, filename));
+  m_pArchive = nullptr;
+
+  if(error)Clear();
+  return error? E_FAIL: S_OK;
+} //Load
+
+/// Load super-tiles listed in the file `super.txt` in the tile folder, if
+/// there is one. Each line of that file that is neither blank nor starts
+/// with `#` describes one super-tile as its png file name, its size in tiles,
+/// then strings of 0s and 1s giving its top, left, bottom, and right edge
+/// colors, one digit per cell. For example, `big.png 2 01 10 11 00`
+/// describes a 2x2 super-tile whose image must be exactly twice the width
+/// and height of an ordinary tile. Only 2x2 and 3x3 super-tiles are allowed.
+/// Colors are numbered as they are for the ordinary tiles once those are in
+/// order, so color 0 is the top and left color of tile 0.
+/// \param folder Folder or zip file containing `super.txt` and the
+/// super-tile images.
+/// \param filename [OUT] Name of the last file attempted.
+/// \return S_OK if there are no super-tiles or they loaded correctly,
+/// E_FAIL otherwise.
+
+HRESULT CTileSet::LoadSuper(const std::wstring& folder,
+  std::wstring& filename)
+{
+  filename = folder + L"\\super.txt";
+  std::string text; //contents of super.txt
+  if(FAILED(ReadText(folder, L"super.txt", text)))return S_OK; //no super-tiles
+
+  std::istringstream in(text);
+  std::string line; //line of super.txt
+  std::vector<UINT> v; //pixels
+
+  while(std::getline(in, line)){
+    if(line.empty() || line[0] == '#')continue;
+
+    std::istringstream ss(line);
+    std::string name, edge[4]; //file name and edge colors
+    SSuperTile t;
+
+    ss >> name >> t.m_nSize >> edge[0] >> edge[1] >> edge[2] >> edge[3];
+    if(ss.fail() || t.m_nSize < 2 || t.m_nSize > 3)return E_FAIL;
+
+    std::vector<UINT>* color[4] = {&t.m_vTop, &t.m_vLeft, &t.m_vBottom,
+      &t.m_vRight}; //where edge colors go
+
+    for(UINT k=0; k<4; k++){
+      if(edge[k].size() != t.m_nSize)return E_FAIL;
+
+      for(char c: edge[k])
+        if(c == '0' || c == '1')color[k]->push_back(UINT(c - '0'));
+        else return E_FAIL;
+    } //for
+
+    const std::wstring wname(name.begin(), name.end()); //image file name
+    filename = folder + L"\\" + wname;
+    UINT w = 0, h = 0; //image size
+
+    if(FAILED(ReadImage(folder, wname, v, w, h)) ||
+      w != t.m_nSize*GetTileWidth() || h != t.m_nSize*GetTileHeight())
+      return E_FAIL;
+
+    t.m_pTile = m_pCache->Acquire(std::move(v), w, h);
+
+    m_vSuper.push_back(std::move(t));
+  } //while
+
+  return S_OK;
+} //LoadSuper
+
+/// Load navigation masks from the file `nav.txt` in the tile folder, if
+/// there is one. Blank lines are ignored. The first line gives the mask size
+/// `k`, and then there are `k` lines of `k` characters for each tile in
+/// file order, where `#` is a cell that cannot be walked on, `.` is a cell
+/// with movement cost 1, and a digit from `1` to `9` is a cell with that
+/// movement cost. The tiles must already have been loaded.
+/// \param folder Folder or zip file containing `nav.txt`.
+/// \param filename [OUT] Name of the last file attempted.
+/// \return S_OK if there are no masks or they loaded correctly, E_FAIL
+/// otherwise.
+
+HRESULT CTileSet::LoadNav(const std::wstring& folder, std::wstring& filename){
+  filename = folder + L"\\nav.txt";
+  std::string text; //contents of nav.txt
+  if(FAILED(ReadText(folder, L"nav.txt", text)))return S_OK; //no masks
+
+  std::istringstream in(text);
+
+  std::string line; //line of nav.txt
+  UINT k = 0; //mask size
+
+  while(k == 0 && std::getline(in, line))
+    if(!line.empty())
+      k = UINT(strtoul(line.c_str(), nullptr, 10));
+
+  if(k == 0 || k > max(GetTileWidth(), GetTileHeight()))return E_FAIL;
+
+  m_nNavSize = k;
+  m_vNav.reserve(m_vTile.size()*k*k);
+
+  while(m_vNav.size() < m_vTile.size()*k*k && std::getline(in, line)){
+    while(!line.empty() && line.back() == '\r')
+      line.pop_back(); //Windows line ending
+
+    if(line.empty())continue;
+    if(line.size() != k)return E_FAIL;
+
+    for(char c: line)
+      if(c == '#')m_vNav.push_back(0);
+      else if(c == '.')m_vNav.push_back(1);
+      else if(c >= '1' && c <= '9')m_vNav.push_back(BYTE(c - '0'));
+      else return E_FAIL;
+  } //while
+
+  return m_vNav.size() == m_vTile.size()*k*k? S_OK: E_FAIL;
+} //LoadNav
+
+/// Load collision masks from numbered png files in the `mask` subfolder of
+/// the tile folder, if there is one. Each mask must be the same size as the
+/// tiles, and a pixel is solid if the average of its red, green, and blue
+/// components is at least 128. Each row of a mask is packed into 64-bit
+/// words with the leftmost pixel in the most significant bit and unused bits
+/// at the end of the row clear. The masks are read and decoded in parallel.
+/// The tiles must already have been loaded.
+/// \param folder Folder or zip file containing the `mask` subfolder.
+/// \param filename [OUT] Name of the last file attempted.
+/// \return S_OK if there are no masks or they loaded correctly, E_FAIL
+/// otherwise.
+
+HRESULT CTileSet::LoadMasks(const std::wstring& folder,
+  std::wstring& filename)
+{
+  filename = folder + L"\\mask\\0.png";
+  if(!Exists(folder, L"mask\\0.png"))return S_OK; //no collision masks
+
+  const UINT w = GetTileWidth(), h = GetTileHeight();
+  const UINT stride = (w + 63)/64; //words per row
+  const size_t n = m_vTile.size(); //number of masks
+  std::vector<HRESULT> hr(n, E_FAIL); //result for each mask
+
+  m_nMaskStride = stride;
+  m_vMask.assign(n*stride*h, 0);
+
+  CThreadPool::GetInstance().ParallelFor(n, 1, [&](size_t i0, size_t i1){
+    std::vector<UINT> v; //pixels
+    UINT mw = 0, mh = 0; //mask size
+
+    for(size_t i=i0; i<i1; i++){ //for each mask
+      const std::wstring name = L"mask\\" + std::to_wstring(i) + L".png";
+      if(FAILED(ReadImage(folder, name, v, mw, mh)) || mw != w || mh != h)
+        continue;
+
+      UINT64* p = &m_vMask[i*stride*h]; //first word of mask
+
+      for(UINT y=0; y<h; y++)
+        for(UINT x=0; x<w; x++){
+          const UINT c = v[size_t(y)*w + x]; //ARGB
+          const UINT sum = (c >> 16 & 0xFF) + (c >> 8 & 0xFF) + (c & 0xFF);
+          if(sum >= 3*128)p[size_t(y)*stride + x/64] |= 1ULL << (63 - x%64);
+        } //for
+
+      hr[i] = S_OK;
+    } //for
+  }); //ParallelFor
+
+  for(size_t i=0; i<n; i++){
+    filename = folder + L"\\mask\\" + std::to_wstring(i) + L".png";
+    if(FAILED(hr[i]))return E_FAIL;
+  } //for
+
+  return S_OK;
+} //LoadMasks
+
+/// Make this tile set a transformed copy of another one, with each tile
+/// image, navigation mask, and collision mask rotated or mirrored and moved
+/// to the index given by `TransformTile()`. A tiling transformed by
+/// `TransformTiling()` and rendered with the transformed tile set looks
+/// exactly like the original rendered with the original tile set and then
+/// transformed. Super-tiles are not copied.
+/// \param src Tile set of 8 Wang tiles to be transformed.
+/// \param x Transform.
+/// \return S_OK for success, E_FAIL if the source is this tile set or does
+/// not have 8 tiles.
+
+HRESULT CTileSet::Transform(const CTileSet& src, eTransform x){
+  if(&src == this || src.GetSize() != 8)return E_FAIL;
+
+  Clear();
+
+  const UINT w = src.GetTileWidth(), h = src.GetTileHeight();
+  const UINT tw = SwapsAxes(x)? h: w, th = SwapsAxes(x)? w: h; //new size
+  const size_t k = src.m_nNavSize; //navigation mask size
+  const UINT stride = src.m_nMaskStride? (tw + 63)/64: 0; //new mask stride
+
+  m_vTile.resize(8);
+  m_nNavSize = src.m_nNavSize;
+  m_vNav.resize(src.m_vNav.size());
+  m_nMaskStride = stride;
+  m_vMask.assign(8*size_t(stride)*th, 0);
+
+  std::vector<UINT> v; //pixels
+  std::vector<BYTE> bits; //navigation or collision mask, one byte per cell
+
+  for(UINT t=0; t<8; t++){
+    const UINT i = TransformTile(t, x); //new index
+
+    TransformRect(src.m_vTile[t]->GetPixels().data(), w, h, x, v);
+    m_vTile[i] = m_pCache->Acquire(std::move(v), tw, th);
+
+    if(k > 0){
+      TransformRect(src.GetNavMask(t), k, k, x, bits);
+      std::copy(bits.begin(), bits.end(), m_vNav.begin() + i*k*k);
+    } //if
+
+    if(stride > 0){
+      const UINT64* p = src.GetMask(t);
+      std::vector<BYTE> cell(size_t(w)*h); //unpacked collision mask
+
+      for(UINT y=0; y<h; y++)
+        for(UINT z=0; z<w; z++)
+          cell[size_t(y)*w + z] = BYTE(p[size_t(y)*src.m_nMaskStride + z/64] >>
+            (63 - z%64) & 1);
+
+      TransformRect(cell.data(), w, h, x, bits);
+      UINT64* q = &m_vMask[size_t(i)*stride*th];
+
+      for(UINT y=0; y<th; y++)
+        for(UINT z=0; z<tw; z++)
+          if(bits[size_t(y)*tw + z])
+            q[size_t(y)*stride + z/64] |= 1ULL << (63 - z%64);
+    } //if
+  } //for
+
+  return S_OK;
+} //Transform
+
+#pragma endregion Load functions
+
+///////////////////////////////////////////////////////////////////////////////
+// Render function
+
+#pragma region Render function
+
+/// Render a Wang tiling into a 32-bit ARGB pixel buffer by copying tile
+/// pixels, one row of tiles per task on the shared thread pool. If there is
+/// a super-tiler then each of its super-tiles is copied as a single image,
+/// one per task, over the cells that it covers, which are skipped when
+/// copying ordinary tiles.
+/// \param tiler Wang tiler.
+/// \param pDest Destination pixels, large enough for the whole tiling.
+/// \param nStride Bytes per destination row.
+/// \param priority Thread pool priority.
+/// \param pSuper Pointer to a super-tiler for `tiler`, or **nullptr**.
+/// \return S_OK for success, E_FAIL if the tiling refers to a missing tile
+/// or super-tile.
+
+HRESULT CTileSet::Render(const CWangTiler& tiler, BYTE* pDest, size_t nStride,
+  ePriority priority, const CSuperTiler* pSuper) const
+{
+  const size_t nGridWidth  = tiler.GetWidth();
+  const size_t nGridHeight = tiler.GetHeight();
+  const UINT nTileHeight = GetTileHeight();
+  const size_t nRowBytes = 4*size_t(GetTileWidth()); //bytes per tile row
+
+  for(size_t i=0; i<nGridHeight; i++) //make sure indices are in range
+    for(size_t j=0; j<nGridWidth; j++)
+      if(tiler(i, j) >= m_vTile.size())return E_FAIL;
+
+  const std::vector<SSuperPlacement>* pPlacement = nullptr; //super-tiles
+
+  if(pSuper != nullptr){
+    pPlacement = &pSuper->GetPlacements();
+
+    for(const SSuperPlacement& p: *pPlacement){ //make sure they are in range
+      if(p.m_nType >= m_vSuper.size())return E_FAIL;
+      const UINT s = m_vSuper[p.m_nType].m_nSize;
+      if(p.m_nRow + s > nGridHeight || p.m_nCol + s > nGridWidth)return E_FAIL;
+    } //for
+  } //if
+
+  CThreadPool::GetInstance().ParallelFor(nGridHeight, 1,
+    [&](size_t i0, size_t i1){
+      for(size_t i=i0; i<i1; i++)
+        for(size_t j=0; j<nGridWidth; j++){
+          if(pSuper != nullptr && pSuper->IsOccupied(i, j))continue;
+
+          const CTile* pTile = m_vTile[tiler(i, j)];
+          const BYTE* pSrc = (const BYTE*)pTile->GetPixels().data();
+          BYTE* p = pDest + i*nTileHeight*nStride + j*nRowBytes;
+
+          for(UINT y=0; y<nTileHeight; y++)
+            memcpy(p + y*nStride, pSrc + y*nRowBytes, nRowBytes);
+        } //for
+    }, priority); //ParallelFor
+
+  if(pPlacement != nullptr)
+    CThreadPool::GetInstance().ParallelFor(pPlacement->size(), 1,
+      [&](size_t k0, size_t k1){
+        for(size_t k=k0; k<k1; k++){
+          const SSuperPlacement& s = (*pPlacement)[k];
+          const SSuperTile& t = m_vSuper[s.m_nType];
+          const BYTE* pSrc = (const BYTE*)t.m_pTile->GetPixels().data();
+          const size_t nBytes = t.m_nSize*nRowBytes; //bytes per image row
+          BYTE* p = pDest + s.m_nRow*nTileHeight*nStride + s.m_nCol*nRowBytes;
+
+          for(UINT y=0; y<t.m_nSize*nTileHeight; y++)
+            memcpy(p + y*nStride, pSrc + y*nBytes, nBytes);
+        } //for
+      }, priority); //ParallelFor
+
+  return S_OK;
+} //Render
+
+#pragma endregion Render function
+
+///////////////////////////////////////////////////////////////////////////////
+// Reader functions
+
+#pragma region Reader functions
+
+/// Get the number of tiles.
+/// \return Number of tiles.
+
+const UINT CTileSet::GetSize() const{
+  return UINT(m_vTile.size());
+} //GetSize
+
+/// Get the tile width, which is the same for every tile.
+/// \return Tile width in pixels, or 0 if there are no tiles.
+
+const UINT CTileSet::GetTileWidth() const{
+  return m_vTile.empty()? 0: m_vTile[0]->GetWidth();
+} //GetTileWidth
+
+/// Get the tile height, which is the same for every tile.
+/// \return Tile height in pixels, or 0 if there are no tiles.
+
+const UINT CTileSet::GetTileHeight() const{
+  return m_vTile.empty()? 0: m_vTile[0]->GetHeight();
+} //GetTileHeight
+
+/// Get a tile.
+/// \param i Tile index.
+/// \return Pointer to tile `i`.
+
+CTile* CTileSet::GetTile(UINT i) const{
+  return m_vTile[i];
+} //GetTile
+
+/// Get the number of super-tiles.
+/// \return Number of super-tiles.
+
+const UINT CTileSet::GetSuperTileCount() const{
+  return UINT(m_vSuper.size());
+} //GetSuperTileCount
+
+/// Get a super-tile.
+/// \param i Super-tile index.
+/// \return Reference to super-tile `i`.
+
+const SSuperTile& CTileSet::GetSuperTile(UINT i) const{
+  return m_vSuper[i];
+} //GetSuperTile
+
+/// Get the width and height of the navigation masks.
+/// \return Navigation mask size in cells, or 0 if there are no masks.
+
+const UINT CTileSet::GetNavSize() const{
+  return m_nNavSize;
+} //GetNavSize
+
+/// Get the navigation mask of a tile, which is a square of movement costs
+/// in row-major order with 0 for cells that cannot be walked on.
+/// \param i Tile index.
+/// \return Pointer to the first of `GetNavSize()` squared costs, or
+/// **nullptr** if there are no masks.
+
+const BYTE* CTileSet::GetNavMask(UINT i) const{
+  if(m_nNavSize == 0)return nullptr;
+  return &m_vNav[size_t(i)*m_nNavSize*m_nNavSize];
+} //GetNavMask
+
+/// Reader function for the number of 64-bit words in each row of a
+/// collision mask.
+/// \return Words per row, 0 if there are no collision masks.
+
+const UINT CTileSet::GetMaskStride() const{
+  return m_nMaskStride;
+} //GetMaskStride
+
+/// Get the collision mask of a tile. It has `GetTileHeight()` rows of
+/// `GetMaskStride()` words, with the leftmost pixel of each row in the most
+/// significant bit of its first word and a set bit for a solid pixel.
+/// \param i Tile index.
+/// \return Pointer to the first word, or **nullptr** if there are no masks.
+
+const UINT64* CTileSet::GetMask(UINT i) const{
+  if(m_nMaskStride == 0)return nullptr;
+  return &m_vMask[size_t(i)*m_nMaskStride*GetTileHeight()];
+} //GetMask
+
+#pragma endregion Reader functions
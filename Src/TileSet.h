@@ -0,0 +1,117 @@
+/// \file TileSet.h
+/// \brief Interface for CTileSet.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef __TILESET_H__
+#define __TILESET_H__
+
+#include "Includes.h"
+#include "TileCache.h"
+#include "WangTiler.h"
+#include "ThreadPool.h"
+#include "TilingTransform.h"
+#include "ZipArchive.h"
+
+class CSuperTiler;
+
+/// \brief Super-tile.
+///
+/// A super-tile is a single image that covers a square of cells in a tiling.
+/// Each cell-sized segment of its perimeter has an edge color, and the
+/// perimeter colors are listed left to right along the top and bottom edges
+/// and top to bottom along the left and right edges.
+
+struct SSuperTile{
+  CTile* m_pTile = nullptr; ///< Image, `m_nSize` tiles wide and high.
+  UINT m_nSize = 0; ///< Width and height in tiles.
+
+  std::vector<UINT> m_vTop; ///< Top edge colors.
+  std::vector<UINT> m_vLeft; ///< Left edge colors.
+  std::vector<UINT> m_vBottom; ///< Bottom edge colors.
+  std::vector<UINT> m_vRight; ///< Right edge colors.
+}; //SSuperTile
+
+/// \brief Tile set.
+///
+/// A set of tiles of the same size, indexed from 0, and optionally some
+/// super-tiles that each cover a square of 2x2 or 3x3 cells. The tiles
+/// themselves live in a tile cache, which may be shared by several tile sets.
+/// Each tile may also have a navigation mask, a small square grid of movement
+/// costs in which 0 means that the cell cannot be walked on, and a collision
+/// mask with one bit per pixel that is set where the pixel is solid.
+
+class CTileSet{
+  private:
+    CTileCache* m_pCache = nullptr; ///< Tile cache.
+    std::vector<CTile*> m_vTile; ///< Tile pointers.
+    std::vector<SSuperTile> m_vSuper; ///< Super-tiles.
+
+    UINT m_nNavSize = 0; ///< Navigation mask width and height, 0 if none.
+    std::vector<BYTE> m_vNav; ///< Navigation masks, one after another.
+
+    UINT m_nMaskStride = 0; ///< Collision mask words per row, 0 if none.
+    std::vector<UINT64> m_vMask; ///< Collision masks, one after another.
+
+    const CZipArchive* m_pArchive = nullptr; ///< Archive being loaded from.
+
+    void Clear(); ///< Release all tiles.
+    bool Exists(const std::wstring& folder,
+      const std::wstring& name) const; ///< Is there such a file?
+    HRESULT ReadText(const std::wstring& folder, const std::wstring& name,
+      std::string& text) const; ///< Read text file.
+    HRESULT ReadImage(const std::wstring& folder, const std::wstring& name,
+      std::vector<UINT>& v, UINT& w, UINT& h) const; ///< Read image file.
+    HRESULT LoadNav(const std::wstring& folder,
+      std::wstring& filename); ///< Load navigation masks.
+    HRESULT LoadMasks(const std::wstring& folder,
+      std::wstring& filename); ///< Load collision masks.
+    HRESULT LoadSuper(const std::wstring& folder,
+      std::wstring& filename); ///< Load super-tiles.
+
+  public:
+    CTileSet(CTileCache* pCache); ///< Constructor.
+    ~CTileSet(); ///< Destructor.
+
+    HRESULT Load(const std::wstring& folder, const UINT n,
+      std::wstring& filename); ///< Load tiles from folder or zip.
+    HRESULT Transform(const CTileSet& src,
+      eTransform x); ///< Make a transformed copy of a tile set.
+
+    HRESULT Render(const CWangTiler& tiler, BYTE* pDest, size_t nStride,
+      ePriority priority=ePriority::Batch,
+      const CSuperTiler* pSuper=nullptr) const; ///< Render a tiling.
+
+    const UINT GetSize() const; ///< Get number of tiles.
+    const UINT GetTileWidth() const; ///< Get tile width.
+    const UINT GetTileHeight() const; ///< Get tile height.
+    CTile* GetTile(UINT i) const; ///< Get tile.
+    const UINT GetSuperTileCount() const; ///< Get number of super-tiles.
+    const SSuperTile& GetSuperTile(UINT i) const; ///< Get super-tile.
+    const UINT GetNavSize() const; ///< Get navigation mask size.
+    const BYTE* GetNavMask(UINT i) const; ///< Get navigation mask.
+    const UINT GetMaskStride() const; ///< Get collision mask words per row.
+    const UINT64* GetMask(UINT i) const; ///< Get collision mask.
+}; //CTileSet
+
+#endif //__TILESET_H__
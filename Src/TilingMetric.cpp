@@ -0,0 +1,216 @@
+/// \file TilingMetric.cpp
+/// \brief Code for the tiling quality metrics.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <algorithm>
+#include <cmath>
+
+#include "TilingMetric.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// CRepetitionMetric functions
+
+#pragma region CRepetitionMetric functions
+
+/// Make a copy.
+/// \return Pointer to a new copy of this metric.
+
+CTilingMetric* CRepetitionMetric::Clone() const{
+  return new CRepetitionMetric(*this);
+} //Clone
+
+/// Start scoring a new tiling.
+/// \param tiler Wang tiler.
+
+void CRepetitionMetric::Reset(const CWangTiler& tiler){
+  m_nRepeats = 0;
+} //Reset
+
+/// Count repeated pairs within a row and between it and the row above.
+/// \param tiler Wang tiler.
+/// \param i Row number.
+
+void CRepetitionMetric::AddRow(const CWangTiler& tiler, size_t i){
+  const size_t w = tiler.GetWidth();
+
+  for(size_t j=1; j<w; j++)
+    m_nRepeats += tiler(i, j) == tiler(i, j - 1);
+
+  if(i > 0)
+    for(size_t j=0; j<w; j++)
+      m_nRepeats += tiler(i, j) == tiler(i - 1, j);
+} //AddRow
+
+/// Get the final score once every row has been added.
+/// \param tiler Wang tiler.
+/// \return Minus the number of repeated pairs.
+
+double CRepetitionMetric::GetScore(const CWangTiler& tiler){
+  return -double(m_nRepeats);
+} //GetScore
+
+/// Get an upper bound on the final score.
+/// \return Minus the number of repeated pairs so far.
+
+double CRepetitionMetric::GetBound() const{
+  return -double(m_nRepeats);
+} //GetBound
+
+#pragma endregion CRepetitionMetric functions
+
+///////////////////////////////////////////////////////////////////////////////
+// CBalanceMetric functions
+
+#pragma region CBalanceMetric functions
+
+/// Make a copy.
+/// \return Pointer to a new copy of this metric.
+
+CTilingMetric* CBalanceMetric::Clone() const{
+  return new CBalanceMetric(*this);
+} //Clone
+
+/// Start scoring a new tiling.
+/// \param tiler Wang tiler.
+
+void CBalanceMetric::Reset(const CWangTiler& tiler){
+  for(UINT& n: m_nCount)
+    n = 0;
+
+  m_nCells = tiler.GetWidth()*tiler.GetHeight();
+  m_nRemaining = m_nCells;
+} //Reset
+
+/// Count the tiles in a row.
+/// \param tiler Wang tiler.
+/// \param i Row number.
+
+void CBalanceMetric::AddRow(const CWangTiler& tiler, size_t i){
+  const size_t w = tiler.GetWidth();
+
+  for(size_t j=0; j<w; j++)
+    m_nCount[tiler(i, j)]++;
+
+  m_nRemaining -= w;
+} //AddRow
+
+/// Get the final score once every row has been added.
+/// \param tiler Wang tiler.
+/// \return Minus the sum of squared deviations from the mean tile count.
+
+double CBalanceMetric::GetScore(const CWangTiler& tiler){
+  const double mean = m_nCells/8.0;
+  double sum = 0;
+
+  for(const UINT n: m_nCount)
+    sum += (n - mean)*(n - mean);
+
+  return -sum;
+} //GetScore
+
+/// Get an upper bound on the final score. The best that the remaining cells
+/// can do is to raise the smallest counts to a common level, like water
+/// filling the lowest buckets. Allowing the level to be fractional can only
+/// make the bound better than any real tiling, so it is still a bound.
+/// \return Upper bound on the final score.
+
+double CBalanceMetric::GetBound() const{
+  double c[8]; //counts, sorted
+
+  for(UINT t=0; t<8; t++)
+    c[t] = m_nCount[t];
+
+  std::sort(c, c + 8);
+
+  double level = c[0], left = double(m_nRemaining); //water level, water left
+  UINT k = 1; //number of buckets under water
+
+  while(k < 8 && left >= k*(c[k] - level)){
+    left -= k*(c[k] - level);
+    level = c[k++];
+  } //while
+
+  level += left/k;
+
+  const double mean = m_nCells/8.0;
+  double sum = 0;
+
+  for(UINT t=0; t<8; t++){
+    const double n = max(c[t], level);
+    sum += (n - mean)*(n - mean);
+  } //for
+
+  return -sum;
+} //GetBound
+
+#pragma endregion CBalanceMetric functions
+
+///////////////////////////////////////////////////////////////////////////////
+// CCallbackMetric functions
+
+#pragma region CCallbackMetric functions
+
+/// \param f Function that scores a complete tiling, higher being better.
+
+CCallbackMetric::CCallbackMetric(
+  const std::function<double(const CWangTiler&)>& f):
+  m_fnScore(f){
+} //constructor
+
+/// Make a copy.
+/// \return Pointer to a new copy of this metric.
+
+CTilingMetric* CCallbackMetric::Clone() const{
+  return new CCallbackMetric(*this);
+} //Clone
+
+/// Start scoring a new tiling. There is nothing to do.
+/// \param tiler Wang tiler.
+
+void CCallbackMetric::Reset(const CWangTiler& tiler){
+} //Reset
+
+/// Add a row. There is nothing to do.
+/// \param tiler Wang tiler.
+/// \param i Row number.
+
+void CCallbackMetric::AddRow(const CWangTiler& tiler, size_t i){
+} //AddRow
+
+/// Get the final score from the callback.
+/// \param tiler Wang tiler.
+/// \return Score.
+
+double CCallbackMetric::GetScore(const CWangTiler& tiler){
+  return m_fnScore(tiler);
+} //GetScore
+
+/// Get an upper bound on the final score.
+/// \return Infinity, since nothing is known until the tiling is complete.
+
+double CCallbackMetric::GetBound() const{
+  return INFINITY;
+} //GetBound
+
+#pragma endregion CCallbackMetric functions
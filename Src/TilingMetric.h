@@ -0,0 +1,115 @@
+/// \file TilingMetric.h
+/// \brief Interface for the tiling quality metrics.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef __TILINGMETRIC_H__
+#define __TILINGMETRIC_H__
+
+#include "Windows.h"
+#include <functional>
+
+#include "WangTiler.h"
+
+/// \brief Tiling quality metric.
+///
+/// A metric scores a Wang tiling, with higher scores being better. Tilings are
+/// scored one row at a time as they are generated, and after each row the
+/// metric gives an upper bound on the final score, so that a search can
+/// abandon a tiling as soon as it cannot beat the tilings already found.
+/// A metric object holds the state for scoring one tiling at a time, so a
+/// parallel search clones one per task and reuses it for many tilings.
+
+class CTilingMetric{
+  public:
+    virtual ~CTilingMetric(){} ///< Destructor.
+
+    virtual CTilingMetric* Clone() const = 0; ///< Make a copy.
+    virtual void Reset(const CWangTiler& tiler) = 0; ///< Start a tiling.
+    virtual void AddRow(const CWangTiler& tiler, size_t i) = 0; ///< Add a row.
+    virtual double GetScore(const CWangTiler& tiler) = 0; ///< Get final score.
+    virtual double GetBound() const = 0; ///< Get bound on final score.
+}; //CTilingMetric
+
+/// \brief Repetition metric.
+///
+/// Penalizes visible repetition, scoring minus the number of pairs of
+/// horizontally or vertically adjacent cells that contain the same tile.
+/// The score can only go down as rows are added, so the score so far is the
+/// bound.
+
+class CRepetitionMetric: public CTilingMetric{
+  private:
+    UINT m_nRepeats = 0; ///< Number of repeated adjacent pairs so far.
+
+  public:
+    CTilingMetric* Clone() const; ///< Make a copy.
+    void Reset(const CWangTiler& tiler); ///< Start a tiling.
+    void AddRow(const CWangTiler& tiler, size_t i); ///< Add a row.
+    double GetScore(const CWangTiler& tiler); ///< Get final score.
+    double GetBound() const; ///< Get bound on final score.
+}; //CRepetitionMetric
+
+/// \brief Tile balance metric.
+///
+/// Rewards using every tile equally often, scoring minus the sum of squared
+/// differences between the number of times each tile is used and the mean.
+/// The bound assumes that the cells still to be generated are shared out as
+/// evenly as possible.
+
+class CBalanceMetric: public CTilingMetric{
+  private:
+    UINT m_nCount[8] = {0}; ///< Number of times each tile is used so far.
+    size_t m_nCells = 0; ///< Number of cells in the tiling.
+    size_t m_nRemaining = 0; ///< Number of cells not yet generated.
+
+  public:
+    CTilingMetric* Clone() const; ///< Make a copy.
+    void Reset(const CWangTiler& tiler); ///< Start a tiling.
+    void AddRow(const CWangTiler& tiler, size_t i); ///< Add a row.
+    double GetScore(const CWangTiler& tiler); ///< Get final score.
+    double GetBound() const; ///< Get bound on final score.
+}; //CBalanceMetric
+
+/// \brief Callback metric.
+///
+/// Scores a complete tiling with a user-supplied function. Since nothing is
+/// known about the score until the tiling is complete, there is no early
+/// abort.
+
+class CCallbackMetric: public CTilingMetric{
+  private:
+    std::function<double(const CWangTiler&)> m_fnScore; ///< Score function.
+
+  public:
+    CCallbackMetric(
+      const std::function<double(const CWangTiler&)>& f); ///< Constructor.
+
+    CTilingMetric* Clone() const; ///< Make a copy.
+    void Reset(const CWangTiler& tiler); ///< Start a tiling.
+    void AddRow(const CWangTiler& tiler, size_t i); ///< Add a row.
+    double GetScore(const CWangTiler& tiler); ///< Get final score.
+    double GetBound() const; ///< Get bound on final score.
+}; //CCallbackMetric
+
+#endif //__TILINGMETRIC_H__
@@ -0,0 +1,313 @@
+/// \file TilingTransform.cpp
+/// \brief Code for geometric transforms of Wang tilings.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <emmintrin.h>
+
+#include "TilingTransform.h"
+#include "ThreadPool.h"
+
+/// A transformed tile is a tile of the transformed tile set, whose images are
+/// the original tile images transformed, and its index is made from its new
+/// edge colors in the usual way. Each new edge is an old edge, for example
+/// the new top edge of a tile rotated a quarter turn clockwise is its old left
+/// edge, so a transform is described by which old edges become the new top,
+/// left, and bottom edges, where 0 is top, 1 is left, 2 is bottom, and 3 is
+/// right. The new right edge follows from the others. Opposite edges of a
+/// Wang tile differ exactly when its parity bit is set, so every transformed
+/// tile is a valid Wang tile and the transformed tiling is valid.
+
+static const UINT g_nEdge[8][3] = {
+  {0, 1, 2}, {1, 2, 3}, {2, 3, 0}, {3, 0, 1},
+  {0, 3, 2}, {2, 1, 0}, {1, 0, 3}, {3, 2, 1}
+}; //g_nEdge
+
+static const size_t g_nBlock = 32; ///< Block width and height in tiles.
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper functions
+
+#pragma region Helper functions
+
+/// \brief Transform of tile positions and indices, ready for SSE2.
+///
+/// A transform moves the tile in row `i` and column `j` to index
+/// `m_nBase + i*m_nRowStep + j*m_nColStep` of the destination in row-major
+/// order. The color of each edge of a tile is `(t >> s ^ t & m) & 1` for
+/// tile index `t`, a shift `s` of 2 for horizontal edges or 1 for vertical
+/// ones, and a mask `m` of 1 for bottom or right edges or 0 otherwise, so
+/// choosing which old edges become the new top, left, and bottom edges is
+/// choosing a shift and a mask for each.
+
+struct STransform{
+  ptrdiff_t m_nBase = 0; ///< Destination of the top left tile.
+  ptrdiff_t m_nRowStep = 0; ///< Destination step from one row to the next.
+  ptrdiff_t m_nColStep = 0; ///< Destination step from one column to the next.
+
+  __m128i m_nShift[3]; ///< Shift for the new top, left, and bottom edges.
+  __m128i m_nMask[3]; ///< Mask for the new top, left, and bottom edges.
+
+  STransform(size_t w, size_t h, eTransform x); ///< Constructor.
+}; //STransform
+
+/// \param w Source width.
+/// \param h Source height.
+/// \param x Transform.
+
+STransform::STransform(size_t w, size_t h, eTransform x){
+  size_t i0 = 0, j0 = 0, i1 = 0, j1 = 0; //positions of two tiles
+
+  TransformPosition(0, 0, w, h, x, i0, j0);
+  const size_t dw = SwapsAxes(x)? h: w; //destination width
+  m_nBase = ptrdiff_t(i0*dw + j0);
+
+  if(h > 1){ //step from row 0 to row 1
+    TransformPosition(1, 0, w, h, x, i1, j1);
+    m_nRowStep = ptrdiff_t(i1*dw + j1) - m_nBase;
+  } //if
+
+  if(w > 1){ //step from column 0 to column 1
+    TransformPosition(0, 1, w, h, x, i1, j1);
+    m_nColStep = ptrdiff_t(i1*dw + j1) - m_nBase;
+  } //if
+
+  for(UINT k=0; k<3; k++){
+    const UINT e = g_nEdge[UINT(x)][k]; //old edge
+    m_nShift[k] = _mm_cvtsi32_si128(e%2 == 0? 2: 1);
+    m_nMask[k] = _mm_set1_epi32(e >= 2? 1: 0);
+  } //for
+} //constructor
+
+/// Transform 4 tile indices at once, using the same edge selection as
+/// `TransformTile()`.
+/// \param v Tile indices.
+/// \param x Transform.
+/// \return Transformed tile indices.
+
+static __m128i TransformTiles(__m128i v, const STransform& x){
+  const __m128i one = _mm_set1_epi32(1);
+  __m128i e[3]; //new top, left, and bottom colors
+
+  for(UINT k=0; k<3; k++)
+    e[k] = _mm_and_si128(_mm_xor_si128(_mm_srl_epi32(v, x.m_nShift[k]),
+      _mm_and_si128(v, x.m_nMask[k])), one);
+
+  return _mm_or_si128(_mm_or_si128(_mm_slli_epi32(e[0], 2),
+    _mm_slli_epi32(e[1], 1)), _mm_xor_si128(e[0], e[2]));
+} //TransformTiles
+
+/// Transform one block of a tiling for a transform that swaps axes, so that
+/// consecutive tiles in a column go to consecutive tiles in a row. Each
+/// square of 4x4 tiles is loaded into 4 registers, transposed in registers,
+/// reversed if necessary, transformed, and stored as parts of 4 destination
+/// rows. Rows and columns left over at the edges of the tiling are done one
+/// tile at a time.
+/// \param src Source tile indices.
+/// \param dest [OUT] Destination tile indices.
+/// \param w Source width.
+/// \param x Transform.
+/// \param i0 First row of block.
+/// \param i1 One past the last row of block.
+/// \param j0 First column of block.
+/// \param j1 One past the last column of block.
+
+static void TransposeBlock(const UINT* src, UINT* dest, size_t w,
+  const STransform& x, size_t i0, size_t i1, size_t j0, size_t j1)
+{
+  const size_t i4 = i0 + (i1 - i0)/4*4; //end of whole squares of rows
+  const size_t j4 = j0 + (j1 - j0)/4*4; //end of whole squares of columns
+  const bool reverse = x.m_nRowStep < 0; //whether columns go right to left
+  const ptrdiff_t first = reverse? 3*x.m_nRowStep: 0; //offset of leftmost
+
+  for(size_t i=i0; i<i4; i+=4)
+    for(size_t j=j0; j<j4; j+=4){
+      const UINT* p = src + i*w + j; //top left of square
+      const __m128i r0 = _mm_loadu_si128((const __m128i*)p);
+      const __m128i r1 = _mm_loadu_si128((const __m128i*)(p + w));
+      const __m128i r2 = _mm_loadu_si128((const __m128i*)(p + 2*w));
+      const __m128i r3 = _mm_loadu_si128((const __m128i*)(p + 3*w));
+
+      const __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+      const __m128i t1 = _mm_unpacklo_epi32(r2, r3);
+      const __m128i t2 = _mm_unpackhi_epi32(r0, r1);
+      const __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+
+      __m128i c[4] = { //columns j to j + 3 of rows i to i + 3
+        _mm_unpacklo_epi64(t0, t1), _mm_unpackhi_epi64(t0, t1),
+        _mm_unpacklo_epi64(t2, t3), _mm_unpackhi_epi64(t2, t3)};
+
+      UINT* q = dest + x.m_nBase + ptrdiff_t(i)*x.m_nRowStep +
+        ptrdiff_t(j)*x.m_nColStep + first; //destination of column j
+
+      for(size_t k=0; k<4; k++){
+        if(reverse)c[k] = _mm_shuffle_epi32(c[k], 0x1B);
+        _mm_storeu_si128((__m128i*)(q + ptrdiff_t(k)*x.m_nColStep),
+          TransformTiles(c[k], x));
+      } //for
+    } //for
+
+  for(size_t i=i0; i<i1; i++) //leftovers
+    for(size_t j=(i < i4? j4: j0); j<j1; j++)
+      dest[x.m_nBase + ptrdiff_t(i)*x.m_nRowStep + ptrdiff_t(j)*x.m_nColStep] =
+        _mm_cvtsi128_si32(TransformTiles(_mm_cvtsi32_si128(src[i*w + j]), x));
+} //TransposeBlock
+
+/// Transform one block of a tiling for a transform that does not swap axes,
+/// so that consecutive tiles in a row stay consecutive. Each row is moved 4
+/// tiles at a time, reversed if necessary, and transformed. Columns left
+/// over at the edge of the tiling are done one tile at a time.
+/// \param src Source tile indices.
+/// \param dest [OUT] Destination tile indices.
+/// \param w Source width.
+/// \param x Transform.
+/// \param i0 First row of block.
+/// \param i1 One past the last row of block.
+/// \param j0 First column of block.
+/// \param j1 One past the last column of block.
+
+static void CopyBlock(const UINT* src, UINT* dest, size_t w,
+  const STransform& x, size_t i0, size_t i1, size_t j0, size_t j1)
+{
+  const size_t j4 = j0 + (j1 - j0)/4*4; //end of whole groups of columns
+  const bool reverse = x.m_nColStep < 0; //whether rows go right to left
+  const ptrdiff_t first = reverse? 3*x.m_nColStep: 0; //offset of leftmost
+
+  for(size_t i=i0; i<i1; i++){
+    const UINT* p = src + i*w; //source row
+    UINT* q = dest + x.m_nBase + ptrdiff_t(i)*x.m_nRowStep; //column 0
+
+    for(size_t j=j0; j<j4; j+=4){
+      __m128i v = _mm_loadu_si128((const __m128i*)(p + j));
+      if(reverse)v = _mm_shuffle_epi32(v, 0x1B);
+      _mm_storeu_si128((__m128i*)(q + ptrdiff_t(j)*x.m_nColStep + first),
+        TransformTiles(v, x));
+    } //for
+
+    for(size_t j=j4; j<j1; j++) //leftovers
+      q[ptrdiff_t(j)*x.m_nColStep] =
+        _mm_cvtsi128_si32(TransformTiles(_mm_cvtsi32_si128(p[j]), x));
+  } //for
+} //CopyBlock
+
+#pragma endregion Helper functions
+
+///////////////////////////////////////////////////////////////////////////////
+// Transform functions
+
+#pragma region Transform functions
+
+/// Find out whether a transform swaps width and height.
+/// \param x Transform.
+/// \return true for quarter turns and diagonal mirrors.
+
+const bool SwapsAxes(eTransform x){
+  return x == eTransform::Rotate90 || x == eTransform::Rotate270 ||
+    x == eTransform::Transpose || x == eTransform::AntiTranspose;
+} //SwapsAxes
+
+/// Get the position that a cell moves to under a transform.
+/// \param i Row.
+/// \param j Column.
+/// \param w Width before the transform.
+/// \param h Height before the transform.
+/// \param x Transform.
+/// \param ti [OUT] Row after the transform.
+/// \param tj [OUT] Column after the transform.
+
+void TransformPosition(size_t i, size_t j, size_t w, size_t h, eTransform x,
+  size_t& ti, size_t& tj)
+{
+  switch(x){
+    case eTransform::Identity:       ti = i;         tj = j;         break;
+    case eTransform::Rotate90:       ti = j;         tj = h - 1 - i; break;
+    case eTransform::Rotate180:      ti = h - 1 - i; tj = w - 1 - j; break;
+    case eTransform::Rotate270:      ti = w - 1 - j; tj = i;         break;
+    case eTransform::FlipHorizontal: ti = i;         tj = w - 1 - j; break;
+    case eTransform::FlipVertical:   ti = h - 1 - i; tj = j;         break;
+    case eTransform::Transpose:      ti = j;         tj = i;         break;
+    case eTransform::AntiTranspose:  ti = w - 1 - j; tj = h - 1 - i; break;
+  } //switch
+} //TransformPosition
+
+/// Get the index of a tile after a transform, that is, the index of the tile
+/// whose edge colors are those of the transformed tile. The transformed tile
+/// set, in which tile `TransformTile(t, x)` is the image of tile `t`
+/// transformed by `x`, tiles the transformed tiling.
+/// \param t Tile index.
+/// \param x Transform.
+/// \return Transformed tile index.
+
+UINT TransformTile(UINT t, eTransform x){
+  const UINT* e = g_nEdge[UINT(x)];
+  const UINT edge[4] = {
+    CWangTiler::GetTopColor(t), CWangTiler::GetLeftColor(t),
+    CWangTiler::GetBottomColor(t), CWangTiler::GetRightColor(t)};
+
+  return edge[e[0]] << 2 | edge[e[1]] << 1 | (edge[e[0]] ^ edge[e[2]]);
+} //TransformTile
+
+/// Transform a whole tiling, moving each tile and transforming its index,
+/// one band of rows per task on the shared thread pool, 4 tiles at a time
+/// with SSE2. If the transform swaps axes then each band is split into square
+/// blocks small enough to stay in the L1 cache along with their
+/// destinations, since the tiles of a source row are scattered over many
+/// destination rows. Otherwise rows are moved whole.
+/// \param src Source tiling.
+/// \param dest [OUT] Destination tiling, which must be a different tiler
+/// whose width and height are swapped if the transform swaps axes.
+/// \param x Transform.
+/// \return S_OK for success, E_FAIL if the destination is the wrong size.
+
+HRESULT TransformTiling(const CWangTiler& src, CWangTiler& dest,
+  eTransform x)
+{
+  const size_t w = src.GetWidth(), h = src.GetHeight();
+  const bool swap = SwapsAxes(x);
+
+  if(&src == &dest || dest.GetWidth() != (swap? h: w) ||
+    dest.GetHeight() != (swap? w: h))return E_FAIL;
+
+  if(w == 0 || h == 0)return S_OK;
+
+  const STransform t(w, h, x);
+  const UINT* p = src.GetRow(0);
+  UINT* q = dest.GetRow(0);
+  const size_t rows = (h + g_nBlock - 1)/g_nBlock; //number of block rows
+
+  CThreadPool::GetInstance().ParallelFor(rows, 1, [&](size_t b0, size_t b1){
+    for(size_t b=b0; b<b1; b++){
+      const size_t i0 = b*g_nBlock, i1 = min(h, i0 + g_nBlock);
+
+      if(swap)
+        for(size_t j0=0; j0<w; j0+=g_nBlock)
+          TransposeBlock(p, q, w, t, i0, i1, j0, min(w, j0 + g_nBlock));
+
+      else CopyBlock(p, q, w, t, i0, i1, 0, w); //rows stay rows
+    } //for
+  }); //ParallelFor
+
+  return S_OK;
+} //TransformTiling
+
+#pragma endregion Transform functions
@@ -0,0 +1,80 @@
+/// \file TilingTransform.h
+/// \brief Interface for geometric transforms of Wang tilings.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef __TILINGTRANSFORM_H__
+#define __TILINGTRANSFORM_H__
+
+#include "Windows.h"
+#include <vector>
+
+#include "WangTiler.h"
+
+/// \brief Geometric transform.
+///
+/// The 8 symmetries of a square. Rotations are clockwise.
+
+enum class eTransform{
+  Identity, ///< No change.
+  Rotate90, ///< Rotate a quarter turn clockwise.
+  Rotate180, ///< Rotate a half turn.
+  Rotate270, ///< Rotate a quarter turn counterclockwise.
+  FlipHorizontal, ///< Mirror left to right.
+  FlipVertical, ///< Mirror top to bottom.
+  Transpose, ///< Mirror in the main diagonal.
+  AntiTranspose ///< Mirror in the other diagonal.
+}; //eTransform
+
+const bool SwapsAxes(eTransform x); ///< Does a transform swap width and height?
+void TransformPosition(size_t i, size_t j, size_t w, size_t h, eTransform x,
+  size_t& ti, size_t& tj); ///< Transform a cell position.
+UINT TransformTile(UINT t, eTransform x); ///< Transform a tile index.
+HRESULT TransformTiling(const CWangTiler& src, CWangTiler& dest,
+  eTransform x); ///< Transform a whole tiling.
+
+/// Transform a rectangle of pixels or other values in row-major order, one
+/// element at a time. This is for tile images and masks, which are small,
+/// rather than for whole tilings.
+/// \param src Source values.
+/// \param w Source width.
+/// \param h Source height.
+/// \param x Transform.
+/// \param dest [OUT] Transformed values, resized to fit, with width and
+/// height swapped if the transform swaps axes.
+
+template<class T> void TransformRect(const T* src, size_t w, size_t h,
+  eTransform x, std::vector<T>& dest)
+{
+  const size_t dw = SwapsAxes(x)? h: w; //destination width
+  dest.resize(w*h);
+
+  for(size_t i=0; i<h; i++)
+    for(size_t j=0; j<w; j++){
+      size_t ti = 0, tj = 0; //destination position
+      TransformPosition(i, j, w, h, x, ti, tj);
+      dest[ti*dw + tj] = src[i*w + j];
+    } //for
+} //TransformRect
+
+#endif //__TILINGTRANSFORM_H__
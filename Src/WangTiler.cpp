@@ -30,70 +30,84 @@
 
 /// Set the pseudo-random number generator seed to `timeGetTime()`, the number
 /// of milliseconds since Windows last rebooted. This should be sufficiently
-/// unpredictable to make a good seed. Allocate memory for the tile array `m_nTile`.
+/// unpredictable to make a good seed. Point `m_pTile` at the inline storage
+/// if the tiling fits, otherwise allocate it on the heap.
 /// \param w Width in tiles.
 /// \param h Height in tiles.
 
 CWangTiler::CWangTiler(size_t w, size_t h):
-  m_nWidth(w), m_nHeight(h), m_nTile(new UINT*[h])
+  m_nWidth(w), m_nHeight(h)
 {
-  m_stdRandom.seed(timeGetTime()); //reset PRNG
+  m_cRandom.Seed(timeGetTime()); //reset PRNG
 
-  for(size_t i=0; i<h; i++){
-    m_nTile[i] = new UINT[w];
+  const size_t n = w*h; //number of tiles
+  m_pTile = n <= INLINECELLS? m_nInline: new UINT[n];
 
-    for(size_t j=0; j<w; j++)
-      m_nTile[i][j] = 0;
-  } //for
+  for(size_t i=0; i<n; i++)
+    m_pTile[i] = 0;
 } //constructor
 
-/// Deallocate memory from the tile array `m_nTile`.
+/// Deallocate the tile array `m_pTile` if it is on the heap.
 
 CWangTiler::~CWangTiler(){
-  for(size_t i=0; i<m_nHeight; i++)
-    delete [] m_nTile[i];
-
-  delete [] m_nTile;
+  if(m_pTile != m_nInline)
+    delete [] m_pTile;
 } //destructor
 
-/// Get a pseudo-random tile that matches tiles above and to the left.
-/// \param x Index of the tile to the left.
-/// \param y Index of the tile above.
-/// \return Index of a tile that matches tiles above and to the left.
+/// Seed the pseudo-random number generator, so that the tiling generated
+/// next depends only on the seed. The seed is scrambled first.
+/// \param seed Seed.
 
-UINT CWangTiler::Match(UINT x, UINT y){
-  std::uniform_int_distribution<UINT> d(0, 1);
-  return (y&4) ^ (y&1)<<2 | (x&2) ^ (x&1)<<1 | d(m_stdRandom);
-} //Match
+void CWangTiler::Seed(UINT seed){
+  m_cRandom.Seed(Scramble(seed));
+} //Seed
 
 /// Generate a Wang tiling of width `m_nWidth` and height `m_nHeight` into
-/// `m_nTile` using `m_stdRandom` as a source of randomness.
+/// `m_pTile` using `m_cRandom` as a source of randomness.
 
 void CWangTiler::Generate(){
-  std::uniform_int_distribution<UINT> d(0, 7);
+  for(size_t i=0; i<m_nHeight; i++)
+    GenerateRow(i);
+} //Generate
 
-  m_nTile[0][0] = d(m_stdRandom);
-  
-  for(size_t j=1; j<m_nWidth; j++)
-    m_nTile[0][j] = Match(m_nTile[0][j - 1], d(m_stdRandom));
+/// Generate one row of a Wang tiling. The rows must be generated in order,
+/// starting with row 0, since each row is matched to the one above it.
+/// Generating a tiling one row at a time produces the same tiling as
+/// `Generate()` does, which lets callers inspect it and stop early.
+/// \param i Row number.
 
-  for(size_t i=1; i<m_nHeight; i++){
-    m_nTile[i][0] = Match(d(m_stdRandom), m_nTile[i - 1][0]);
+void CWangTiler::GenerateRow(size_t i){
+  UINT* row = GetRow(i);
+  FillRow(row, i > 0? row - m_nWidth: nullptr, m_nWidth, m_cRandom);
+} //GenerateRow
 
-    for(size_t j=1; j<m_nWidth; j++)
-      m_nTile[i][j] = Match(m_nTile[i][j - 1], m_nTile[i - 1][j]);
-  } //for
-} //Generate
-
-/// Get tile index from `m_nTile`.
+/// Get tile index from `m_pTile`.
 /// \param i Row number.
 /// \param j Column number.
-/// \return `m_nTile`[i][j].
+/// \return Index of the tile in row `i` and column `j`.
 
 const size_t CWangTiler::operator()(size_t i, size_t j) const{
-  return m_nTile[i][j];
+  return m_pTile[i*m_nWidth + j];
 } //operator()
 
+/// Get a row of tile indices from `m_pTile` for reading or writing. Writing
+/// is for editing a tiling after it has been generated, and the caller must
+/// keep the edges matched.
+/// \param i Row number.
+/// \return Pointer to the first of `m_nWidth` tile indices in row `i`.
+
+UINT* CWangTiler::GetRow(size_t i){
+  return m_pTile + i*m_nWidth;
+} //GetRow
+
+/// Get a row of tile indices from `m_pTile` for reading.
+/// \param i Row number.
+/// \return Pointer to the first of `m_nWidth` tile indices in row `i`.
+
+const UINT* CWangTiler::GetRow(size_t i) const{
+  return m_pTile + i*m_nWidth;
+} //GetRow
+
 /// Reader function for `m_nWidth`.
 /// \return `m_nWidth`
 
@@ -106,4 +120,38 @@ const size_t CWangTiler::GetWidth() const{
 
 const size_t CWangTiler::GetHeight() const{
   return m_nHeight;
-} //GetHeight
\ No newline at end of file
+} //GetHeight
+
+/// Get the top color of a tile, which is bit 2 of its index.
+/// \param t Tile index.
+/// \return 0 for green, 1 for red.
+
+UINT CWangTiler::GetTopColor(UINT t){
+  return (t >> 2) & 1;
+} //GetTopColor
+
+/// Get the left color of a tile, which is bit 1 of its index.
+/// \param t Tile index.
+/// \return 0 for blue, 1 for yellow.
+
+UINT CWangTiler::GetLeftColor(UINT t){
+  return (t >> 1) & 1;
+} //GetLeftColor
+
+/// Get the bottom color of a tile, which is the top color exclusive-ored with
+/// the parity bit 0 of its index.
+/// \param t Tile index.
+/// \return 0 for green, 1 for red.
+
+UINT CWangTiler::GetBottomColor(UINT t){
+  return GetTopColor(t) ^ (t & 1);
+} //GetBottomColor
+
+/// Get the right color of a tile, which is the left color exclusive-ored with
+/// the parity bit 0 of its index.
+/// \param t Tile index.
+/// \return 0 for blue, 1 for yellow.
+
+UINT CWangTiler::GetRightColor(UINT t){
+  return GetLeftColor(t) ^ (t & 1);
+} //GetRightColor
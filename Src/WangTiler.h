@@ -27,34 +27,185 @@
 #define __WANGTILER_H__
 
 #include "Windows.h"
-#include <random>
+#include <array>
+#include <utility>
+
+#include "Random.h"
 
 /// \brief Wang tiler.
 ///
 /// The Wang tiler generates a pseudo-random rectangular array of tile indices
-/// into a set of 8 Wang tiles that seamlessly tile the plane.
+/// into a set of 8 Wang tiles that seamlessly tile the plane. The generation
+/// logic is also available as `constexpr` static functions, which
+/// `ConstexprWangTiling()` uses to generate a tiling at compile time that is
+/// identical to the one generated at run time from the same seed.
+///
+/// Tile indices are stored contiguously in row-major order. Tilings of up to
+/// `INLINECELLS` tiles, which covers the default 16x16 tiling and the small
+/// tilings used by particle and decal systems, are stored inside the tiler
+/// itself so that creating one does not touch the heap. Larger tilings are
+/// stored in a single heap allocation.
 
 class CWangTiler{
   private:
-    UINT** m_nTile = nullptr; ///< Array of tile indices.
+    static const size_t INLINECELLS = 1024; ///< Inline capacity in tiles.
+
+    UINT m_nInline[INLINECELLS]; ///< Inline storage for small tilings.
+    UINT* m_pTile = nullptr; ///< Tile indices, inline or on the heap.
 
     size_t m_nWidth = 0; ///< Array width in tiles.
     size_t m_nHeight = 0; ///< Array height in tiles.
     
-    std::default_random_engine m_stdRandom; ///< Pseudo-random number generator.
-    
-    UINT Match(UINT x, UINT y); ///< Choose random tile.
+    CRandom m_cRandom; ///< Pseudo-random number generator.
 
   public:
     CWangTiler(size_t w, size_t h); ///< Constructor.
+    CWangTiler(const CWangTiler&) = delete; ///< No copy constructor.
     ~CWangTiler(); ///< Destructor.
 
+    CWangTiler& operator=(const CWangTiler&) = delete; ///< No assignment.
+
+    void Seed(UINT seed); ///< Seed the pseudo-random number generator.
     void Generate(); ///< Generate tiling.
+    void GenerateRow(size_t i); ///< Generate one row of tiling.
 
     const size_t GetWidth() const; ///< Get width in tiles.
     const size_t GetHeight() const; ///< Get height in tiles.
 
     const size_t operator()(size_t i, size_t j) const; ///< Get tile index.
+    UINT* GetRow(size_t i); ///< Get row of tile indices.
+    const UINT* GetRow(size_t i) const; ///< Get row of tile indices.
+
+    static UINT GetTopColor(UINT t); ///< Get top color of a tile.
+    static UINT GetLeftColor(UINT t); ///< Get left color of a tile.
+    static UINT GetBottomColor(UINT t); ///< Get bottom color of a tile.
+    static UINT GetRightColor(UINT t); ///< Get right color of a tile.
+
+    static constexpr UINT Scramble(UINT seed); ///< Scramble a seed.
+    static constexpr UINT Match(UINT x, UINT y, UINT z); ///< Match tiles.
+    static constexpr void FillRow(UINT* row, const UINT* above, size_t w,
+      CRandom& r); ///< Generate one row of tile indices.
+    static constexpr void FillSpan(UINT* row, const UINT* above, size_t j0,
+      size_t j1, CRandom& r); ///< Generate part of a row of tile indices.
 }; //CWangTiler
 
+///////////////////////////////////////////////////////////////////////////////
+// Constexpr functions
+
+#pragma region Constexpr functions
+
+/// Scramble a seed, since consecutive seeds give similar output for a while
+/// from some generators, and seed searches use consecutive seeds.
+/// \param seed Seed.
+/// \return Scrambled seed.
+
+constexpr UINT CWangTiler::Scramble(UINT seed){
+  seed ^= seed >> 16;
+  seed *= 0x7FEB352D;
+  seed ^= seed >> 15;
+  seed *= 0x846CA68B;
+  seed ^= seed >> 16;
+
+  return seed;
+} //Scramble
+
+/// Get the tile that matches tiles above and to the left and has a given
+/// parity bit.
+/// \param x Index of the tile to the left.
+/// \param y Index of the tile above.
+/// \param z Parity bit.
+/// \return Index of a tile that matches tiles above and to the left.
+
+constexpr UINT CWangTiler::Match(UINT x, UINT y, UINT z){
+  return (y&4) ^ (y&1)<<2 | (x&2) ^ (x&1)<<1 | z;
+} //Match
+
+/// Generate one row of a Wang tiling into plain storage. The first row has
+/// a random first tile and random tiles above it. Later rows have a random
+/// tile to the left of their first tile. Every tile has a random parity bit.
+/// \param row [OUT] Tile indices of the row.
+/// \param above Tile indices of the row above, or **nullptr** for the first row.
+/// \param w Width in tiles.
+/// \param r Pseudo-random number generator.
+
+constexpr void CWangTiler::FillRow(UINT* row, const UINT* above, size_t w,
+  CRandom& r)
+{
+  FillSpan(row, above, 0, w, r);
+} //FillRow
+
+/// Generate part of one row of a Wang tiling into plain storage, exactly as
+/// `FillRow()` would. Generating a row in consecutive spans with the same
+/// pseudo-random number generator gives the same tiles as generating it all
+/// at once.
+/// \param row [IN, OUT] Tile indices of the row, filled in before `j0`.
+/// \param above Tile indices of the row above, or **nullptr** for the first row.
+/// \param j0 First column to fill in.
+/// \param j1 One past the last column to fill in.
+/// \param r Pseudo-random number generator.
+
+constexpr void CWangTiler::FillSpan(UINT* row, const UINT* above, size_t j0,
+  size_t j1, CRandom& r)
+{
+  for(size_t j=j0; j<j1; j++){
+    if(above == nullptr){
+      if(j == 0)row[0] = r.GetBits(3);
+
+      else{
+        const UINT y = r.GetBits(3); //random tile above
+        row[j] = Match(row[j - 1], y, r.GetBits(1));
+      } //else
+    } //if
+
+    else{
+      const UINT x = j == 0? r.GetBits(3): row[j - 1]; //tile to the left
+      row[j] = Match(x, above[j], r.GetBits(1));
+    } //else
+  } //for
+} //FillSpan
+
+/// \brief Tile indices of a tiling generated at compile time.
+
+template<size_t W, size_t H> struct SConstexprTiling{
+  UINT m_nTile[W*H] = {0}; ///< Tile indices in row-major order.
+}; //SConstexprTiling
+
+/// Copy the tile indices of a tiling generated at compile time into an
+/// array. This takes a parameter pack of indices since `std::array` cannot
+/// be written to in a constant expression before C++17.
+/// \param t Tiling.
+/// \return Array of tile indices in row-major order.
+
+template<size_t W, size_t H, size_t... I>
+constexpr std::array<UINT, W*H> ToArray(const SConstexprTiling<W, H>& t,
+  std::index_sequence<I...>)
+{
+  return {{t.m_nTile[I]...}};
+} //ToArray
+
+/// Generate a Wang tiling at compile time. This gives exactly the same tile
+/// indices as `CWangTiler::Seed()` followed by `CWangTiler::Generate()` for
+/// a `W` by `H` tiler, so small fixed tilings can be embedded in the
+/// executable. For example,
+/// `constexpr auto t = ConstexprWangTiling<16, 16>(42);` makes `t` a
+/// `std::array` of 256 tile indices in row-major order.
+/// \param seed Seed.
+/// \return Array of tile indices in row-major order.
+
+template<size_t W, size_t H>
+constexpr std::array<UINT, W*H> ConstexprWangTiling(UINT seed){
+  static_assert(W > 0 && H > 0, "Empty tiling");
+
+  SConstexprTiling<W, H> t;
+  CRandom r(CWangTiler::Scramble(seed));
+
+  for(size_t i=0; i<H; i++)
+    CWangTiler::FillRow(t.m_nTile + i*W, i > 0? t.m_nTile + (i - 1)*W: nullptr,
+      W, r);
+
+  return ToArray(t, std::make_index_sequence<W*H>());
+} //ConstexprWangTiling
+
+#pragma endregion Constexpr functions
+
 #endif //__WANGTILER_H__
@@ -127,25 +127,28 @@ HRESULT GetEncoderClsid(const WCHAR* format, CLSID* pClsid){
   return hr;
 } //GetEncoderClsid
 
-/// Display a `Save` dialog box for png files and save a bitmap to the file name
-/// that the user selects. Only files with a `.png` extension are allowed. The
-/// default file name is "ImageN.png", where N is the number of images saved
-/// so far in the current instance of this program. This prevents any collisions
-/// with files already saved by this instance. If there is a collision with a
-/// file from a previous instance, then the user is prompted to overwrite or
-/// rename it in the normal fashion. 
+/// Display a `Save` dialog box for a single file type and get the file name
+/// that the user selects. The default file name is "ImageN", where N is the
+/// number of files saved so far in the current instance of this program. This
+/// prevents any collisions with files already saved by this instance. If there
+/// is a collision with a file from a previous instance, then the user is
+/// prompted to overwrite or rename it in the normal fashion. 
 /// \param hwnd Window handle.
-/// \param pBitmap Pointer to a bitmap.
-/// \return S_OK for success, E_FAIL for failure.
-
-HRESULT SaveBitmap(HWND hwnd, Gdiplus::Bitmap* pBitmap){
-  COMDLG_FILTERSPEC filetypes[] = { //png files only
-    {L"PNG Files", L"*.png"}
+/// \param wstrType File type description, for example L"PNG Files".
+/// \param wstrExt File extension without the dot, for example L"png".
+/// \param wstrFileName [OUT] The selected file name.
+/// \return S_OK for success, E_FAIL for failure or if the user cancelled.
+
+HRESULT SaveFileDialog(HWND hwnd, const std::wstring& wstrType,
+  const std::wstring& wstrExt, std::wstring& wstrFileName)
+{
+  const std::wstring wstrSpec = L"*." + wstrExt; //file spec
+  COMDLG_FILTERSPEC filetypes[] = { //one file type only
+    {wstrType.c_str(), wstrSpec.c_str()}
   }; //filetypes
 
-  std::wstring wstrFileName; //result
   CComPtr<IFileSaveDialog> pDlg; //pointer to save dialog box
-  static int n = 0; //number of images saved in this run
+  static int n = 0; //number of files saved in this run
   std::wstring wstrName = L"Image" + std::to_wstring(n++); //default file name
   CComPtr<IShellItem> pItem; //item pointer
   LPWSTR pwsz = nullptr; //pointer to null-terminated wide string for result
@@ -154,28 +157,161 @@ HRESULT SaveBitmap(HWND hwnd, Gdiplus::Bitmap* pBitmap){
  
   if(FAILED(pDlg.CoCreateInstance(__uuidof(FileSaveDialog))))return E_FAIL; 
 
-  pDlg->SetFileTypes(_countof(filetypes), filetypes); //set file types to png
+  pDlg->SetFileTypes(_countof(filetypes), filetypes); //set file types
   pDlg->SetTitle(L"Save Image"); //set title bar text
   pDlg->SetFileName(wstrName.c_str()); //set default file name
-  pDlg->SetDefaultExtension(L"png"); //set default extension
+  pDlg->SetDefaultExtension(wstrExt.c_str()); //set default extension
  
   if(FAILED(pDlg->Show(hwnd)))return E_FAIL; //show the dialog box     
   if(FAILED(pDlg->GetResult(&pItem)))return E_FAIL; //get the result item
   if(FAILED(pItem->GetDisplayName(SIGDN_FILESYSPATH, &pwsz)))return E_FAIL; //get file name 
 
-  //wstrFileName should now contain the selected file name
+  wstrFileName = pwsz; //the selected file name
+  CoTaskMemFree(pwsz); //clean up
+
+  return S_OK;
+} //SaveFileDialog
+
+/// Display a `Save` dialog box for png files and save a bitmap to the file name
+/// that the user selects. Only files with a `.png` extension are allowed.
+/// \param hwnd Window handle.
+/// \param pBitmap Pointer to a bitmap.
+/// \return S_OK for success, E_FAIL for failure.
+
+HRESULT SaveBitmap(HWND hwnd, Gdiplus::Bitmap* pBitmap){
+  if(pBitmap == nullptr)return E_FAIL; //nothing drawn
+
+  std::wstring wstrFileName; //result
+
+  if(FAILED(SaveFileDialog(hwnd, L"PNG Files", L"png", wstrFileName)))
+    return E_FAIL;
 
   CLSID clsid; //for PNG class id
   if(FAILED(GetEncoderClsid((WCHAR*)L"image/png", &clsid)))return E_FAIL; //get
-  pBitmap->Save(pwsz, &clsid, nullptr); //the actual save happens here
-
-  CoTaskMemFree(pwsz); //clean up
+  pBitmap->Save(wstrFileName.c_str(), &clsid, nullptr); //the actual save happens here
 
   return S_OK;
 } //SaveBitmap
 
+/// Encode a bitmap as a PNG file in memory.
+/// \param pBitmap Pointer to a bitmap.
+/// \param v [OUT] PNG file contents.
+/// \return S_OK for success, E_FAIL for failure.
+
+HRESULT EncodePNG(Gdiplus::Bitmap* pBitmap, std::vector<BYTE>& v){
+  CLSID clsid; //for PNG class id
+  if(FAILED(GetEncoderClsid((WCHAR*)L"image/png", &clsid)))return E_FAIL; //get
+
+  IStream* pStream = nullptr; //memory stream
+  if(FAILED(CreateStreamOnHGlobal(nullptr, TRUE, &pStream)))return E_FAIL;
+
+  HRESULT hr = E_FAIL;
+  HGLOBAL hGlobal = nullptr; //memory behind the stream
+
+  if(pBitmap->Save(pStream, &clsid, nullptr) == Gdiplus::Ok &&
+    SUCCEEDED(GetHGlobalFromStream(pStream, &hGlobal)))
+  {
+    ULARGE_INTEGER size; //stream size, which may be less than the memory size
+    const LARGE_INTEGER zero = {0};
+    pStream->Seek(zero, STREAM_SEEK_END, &size);
+
+    const BYTE* p = (const BYTE*)GlobalLock(hGlobal);
+
+    if(p != nullptr){
+      v.assign(p, p + size.QuadPart);
+      GlobalUnlock(hGlobal);
+      hr = S_OK;
+    } //if
+  } //if
+
+  pStream->Release();
+  return hr;
+} //EncodePNG
+
+/// Decode an image file, such as a png file, that has already been read
+/// into memory, for example from a zip archive.
+/// \param v File contents.
+/// \param pixels [OUT] 32-bit ARGB pixels in row-major order.
+/// \param w [OUT] Image width.
+/// \param h [OUT] Image height.
+/// \return S_OK for success, E_FAIL for failure.
+
+HRESULT DecodeImage(const std::vector<BYTE>& v, std::vector<UINT>& pixels,
+  UINT& w, UINT& h)
+{
+  IStream* pStream = nullptr; //memory stream
+  if(FAILED(CreateStreamOnHGlobal(nullptr, TRUE, &pStream)))return E_FAIL;
+
+  HRESULT hr = E_FAIL;
+  const LARGE_INTEGER zero = {0};
+
+  if(SUCCEEDED(pStream->Write(v.data(), ULONG(v.size()), nullptr)) &&
+    SUCCEEDED(pStream->Seek(zero, STREAM_SEEK_SET, nullptr)))
+  {
+    Gdiplus::Bitmap* pBitmap = Gdiplus::Bitmap::FromStream(pStream);
+
+    if(pBitmap != nullptr && pBitmap->GetLastStatus() == Gdiplus::Ok &&
+      SUCCEEDED(GetPixels(pBitmap, pixels)))
+    {
+      w = pBitmap->GetWidth();
+      h = pBitmap->GetHeight();
+      hr = S_OK;
+    } //if
+
+    delete pBitmap;
+  } //if
+
+  pStream->Release(); //after the bitmap, which reads from it
+  return hr;
+} //DecodeImage
+
 #pragma endregion Save
 
+///////////////////////////////////////////////////////////////////////////////
+// Pixel functions
+
+#pragma region Pixel functions
+
+/// Copy the pixels of a bitmap, or of a band of rows from it, into an array
+/// of 32-bit ARGB values in row-major order, converting the pixel format if
+/// necessary.
+/// \param pBitmap Pointer to a bitmap.
+/// \param v [OUT] Pixel array, resized to fit.
+/// \param y0 First row of the band.
+/// \param rows Number of rows in the band, 0 for all rows from `y0` down.
+/// \return S_OK for success, E_FAIL for failure.
+
+HRESULT GetPixels(Gdiplus::Bitmap* pBitmap, std::vector<UINT>& v,
+  UINT y0, UINT rows)
+{
+  const UINT w = pBitmap->GetWidth(); //bitmap width
+  const UINT nHeight = pBitmap->GetHeight(); //bitmap height
+
+  if(y0 >= nHeight)return E_FAIL;
+  const UINT h = rows == 0? nHeight - y0: min(rows, nHeight - y0); //band height
+
+  v.resize(size_t(w)*h);
+
+  Gdiplus::Rect r(0, y0, w, h); //band
+  Gdiplus::BitmapData data; //describes our buffer to GDI+
+
+  data.Width = w;
+  data.Height = h;
+  data.Stride = 4*w;
+  data.PixelFormat = PixelFormat32bppARGB;
+  data.Scan0 = v.data();
+  data.Reserved = 0;
+
+  const UINT flags = Gdiplus::ImageLockModeRead | Gdiplus::ImageLockModeUserInputBuf;
+  if(pBitmap->LockBits(&r, flags, PixelFormat32bppARGB, &data) != Gdiplus::Ok)
+    return E_FAIL; //GDI+ copies the pixels into v here
+
+  pBitmap->UnlockBits(&data);
+  return S_OK;
+} //GetPixels
+
+#pragma endregion Pixel functions
+
 ///////////////////////////////////////////////////////////////////////////////
 // Create menu functions
 
@@ -189,11 +325,27 @@ void CreateFileMenu(HMENU hParent){
   
   AppendMenuW(hMenu, MF_STRING, IDM_FILE_GENERATE, L"Generate");
   AppendMenuW(hMenu, MF_STRING, IDM_FILE_SAVE,     L"Save...");
+  CreateExportMenu(hMenu);
   AppendMenuW(hMenu, MF_STRING, IDM_FILE_QUIT,     L"Quit");
   
   AppendMenuW(hParent, MF_POPUP, (UINT_PTR)hMenu, L"&File");
 } //CreateFileMenu
 
+/// Create the `Export` menu.
+/// \param hParent Handle to the parent menu.
+
+void CreateExportMenu(HMENU hParent){
+  HMENU hMenu = CreateMenu();
+  
+  AppendMenuW(hMenu, MF_STRING, IDM_EXPORT_BC1, L"DDS (BC1)...");
+  AppendMenuW(hMenu, MF_STRING, IDM_EXPORT_BC7, L"DDS (BC7)...");
+  AppendMenuW(hMenu, MF_STRING, IDM_EXPORT_JPEG, L"JPEG...");
+  AppendMenuW(hMenu, MF_STRING, IDM_EXPORT_ATLAS, L"Tile atlas (DDS array)...");
+  AppendMenuW(hMenu, MF_STRING, IDM_EXPORT_SVG, L"SVG...");
+  
+  AppendMenuW(hParent, MF_POPUP, (UINT_PTR)hMenu, L"&Export");
+} //CreateExportMenu
+
 /// Create the `Tileset` menu.
 /// \param hParent Handle to the parent menu.
 /// \return Handle to the `Tileset` menu.
@@ -205,6 +357,8 @@ HMENU CreateTilesetMenu(HMENU hParent){
   AppendMenuW(hMenu, MF_STRING, IDM_TILESET_FLOWER,  L"Flowers");
   AppendMenuW(hMenu, MF_STRING, IDM_TILESET_MUD,     L"Mud");
   AppendMenuW(hMenu, MF_STRING, IDM_TILESET_GRASS,   L"Grass");
+  AppendMenuW(hMenu, MF_SEPARATOR, 0, nullptr);
+  AppendMenuW(hMenu, MF_STRING, IDM_TILESET_BLEND,   L"Blend edges");
   
   AppendMenuW(hParent, MF_POPUP, (UINT_PTR)hMenu, L"&Tileset");
   return hMenu;
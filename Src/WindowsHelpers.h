@@ -48,6 +48,14 @@
 #define IDM_HELP_HELP  8 ///< Menu id for display help.
 #define IDM_HELP_ABOUT 9 ///< Menu id for display About info.
 
+#define IDM_EXPORT_BC1 10 ///< Menu id for export as BC1 DDS.
+#define IDM_EXPORT_BC7 11 ///< Menu id for export as BC7 DDS.
+#define IDM_EXPORT_JPEG 12 ///< Menu id for export as JPEG.
+#define IDM_EXPORT_ATLAS 13 ///< Menu id for export tile atlas.
+#define IDM_EXPORT_SVG 14 ///< Menu id for export as SVG.
+
+#define IDM_TILESET_BLEND 15 ///< Menu id for blend tile edges.
+
 #pragma endregion Menu IDs
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -62,7 +70,14 @@ ULONG_PTR InitGDIPlus(); ///< Initialize GDI+.
 
 //others
 
+HRESULT SaveFileDialog(HWND, const std::wstring&, const std::wstring&,
+  std::wstring&); ///< Get file name from Save dialog.
 HRESULT SaveBitmap(HWND, Gdiplus::Bitmap*); ///< Save bitmap to file.
+HRESULT EncodePNG(Gdiplus::Bitmap*, std::vector<BYTE>&); ///< Encode as PNG.
+HRESULT DecodeImage(const std::vector<BYTE>&, std::vector<UINT>&, UINT&,
+  UINT&); ///< Decode image file in memory.
+HRESULT GetPixels(Gdiplus::Bitmap*, std::vector<UINT>&,
+  UINT y0=0, UINT rows=0); ///< Get pixels.
 
 #pragma endregion Helper functions
 
@@ -72,6 +87,7 @@ HRESULT SaveBitmap(HWND, Gdiplus::Bitmap*); ///< Save bitmap to file.
 #pragma region Menu functions
 
 void CreateFileMenu(HMENU hParent); ///< Create `File` menu.
+void CreateExportMenu(HMENU hParent); ///< Create `Export` menu.
 HMENU CreateTilesetMenu(HMENU hParent); ///< Create `Tileset` menu.
 void CreateHelpMenu(HMENU hParent); ///< Create `Help` menu.
 
@@ -0,0 +1,313 @@
+/// \file ZipArchive.cpp
+/// \brief Code for CZipArchive.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <array>
+
+#include "ZipArchive.h"
+#include "Inflate.h"
+
+#define ZIP_LOCAL   0x04034B50 ///< Local file header signature.
+#define ZIP_CENTRAL 0x02014B50 ///< Central directory header signature.
+#define ZIP_END     0x06054B50 ///< End of central directory signature.
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper functions
+
+#pragma region Helper functions
+
+/// Read a little-endian 16-bit value.
+/// \param p Pointer to the first byte.
+/// \return Value read.
+
+static WORD Read16(const BYTE* p){
+  return WORD(p[0] | p[1] << 8);
+} //Read16
+
+/// Read a little-endian 32-bit value.
+/// \param p Pointer to the first byte.
+/// \return Value read.
+
+static UINT Read32(const BYTE* p){
+  return UINT(p[0]) | UINT(p[1]) << 8 | UINT(p[2]) << 16 | UINT(p[3]) << 24;
+} //Read32
+
+/// Compute the CRC-32 used by zip archives, one byte at a time using a table
+/// that is built the first time that it is needed.
+/// \param p Pointer to data.
+/// \param n Number of bytes.
+/// \return CRC-32 of the data.
+
+static UINT Crc32(const BYTE* p, size_t n){
+  static const std::array<UINT, 256> table = [](){ //CRC of each byte value
+    std::array<UINT, 256> t;
+
+    for(UINT i=0; i<256; i++){
+      UINT c = i;
+
+      for(UINT k=0; k<8; k++)
+        c = c & 1? 0xEDB88320 ^ (c >> 1): c >> 1;
+
+      t[i] = c;
+    } //for
+
+    return t;
+  }(); //table
+
+  UINT crc = 0xFFFFFFFF;
+
+  for(size_t i=0; i<n; i++)
+    crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+
+  return ~crc;
+} //Crc32
+
+/// Put a file name into the form used as a key in the entry map, which is
+/// lower case with forward slashes, since file names on Windows are not
+/// case-sensitive and either slash may separate folders.
+/// \param name File name.
+/// \return Normalized file name.
+
+static std::string Normalize(std::string name){
+  for(char& c: name)
+    if(c == '\\')c = '/';
+    else if(c >= 'A' && c <= 'Z')c = char(c - 'A' + 'a');
+
+  return name;
+} //Normalize
+
+#pragma endregion Helper functions
+
+///////////////////////////////////////////////////////////////////////////////
+// Open and close
+
+#pragma region Open and close
+
+/// Unmap and close the archive file.
+
+CZipArchive::~CZipArchive(){
+  Close();
+} //destructor
+
+/// Open an archive and read its central directory. Any archive that was
+/// already open is closed first.
+/// \param filename Name of the zip file.
+/// \return S_OK for success, E_FAIL if the file cannot be mapped or is not a
+/// zip archive that can be read.
+
+HRESULT CZipArchive::Open(const std::wstring& filename){
+  Close();
+
+  m_hFile = CreateFileW(filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+    nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if(m_hFile == INVALID_HANDLE_VALUE)return E_FAIL;
+
+  LARGE_INTEGER size; //file size
+
+  if(GetFileSizeEx(m_hFile, &size) && size.QuadPart > 0)
+    m_hMapping = CreateFileMappingW(m_hFile, nullptr, PAGE_READONLY, 0, 0,
+      nullptr);
+
+  if(m_hMapping != nullptr){
+    m_pData = (const BYTE*)MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0);
+    m_nSize = UINT64(size.QuadPart);
+  } //if
+
+  if(m_pData == nullptr || FAILED(ReadDirectory())){
+    Close();
+    return E_FAIL;
+  } //if
+
+  return S_OK;
+} //Open
+
+/// Unmap and close the archive file, if one is open, and forget its entries.
+
+void CZipArchive::Close(){
+  if(m_pData != nullptr)
+    UnmapViewOfFile(m_pData);
+
+  if(m_hMapping != nullptr)
+    CloseHandle(m_hMapping);
+
+  if(m_hFile != INVALID_HANDLE_VALUE)
+    CloseHandle(m_hFile);
+
+  m_hFile = INVALID_HANDLE_VALUE;
+  m_hMapping = nullptr;
+  m_pData = nullptr;
+  m_nSize = 0;
+  m_mapEntry.clear();
+  m_strRoot.clear();
+} //Close
+
+/// Read the central directory. The end of central directory record is the
+/// last thing in the file, followed only by a comment of up to 64KB, so it
+/// is found by searching backwards for its signature. Folders, encrypted
+/// entries, and entries compressed with anything other than deflate are
+/// skipped. Zip64 archives, which are only needed for archives of more than
+/// 4GB or 65535 entries, are not supported. If every entry is in the same
+/// top-level folder, as happens when a folder is zipped, then that folder is
+/// remembered so that names can be looked up relative to it.
+/// \return S_OK for success, E_FAIL if the directory is missing or corrupt.
+
+HRESULT CZipArchive::ReadDirectory(){
+  if(m_nSize < 22)return E_FAIL;
+
+  const UINT64 last = m_nSize - 22; //last place the record could start
+  const UINT64 first = last > 0xFFFF? last - 0xFFFF: 0; //first such place
+  const BYTE* end = nullptr; //end of central directory record
+
+  for(UINT64 i=last + 1; i>first && end == nullptr; i--)
+    if(Read32(m_pData + i - 1) == ZIP_END)
+      end = m_pData + i - 1;
+
+  if(end == nullptr)return E_FAIL;
+
+  const UINT n = Read16(end + 10); //number of entries
+  const UINT64 size = Read32(end + 12); //size of central directory
+  const UINT64 offset = Read32(end + 16); //offset of central directory
+
+  if(n == 0xFFFF || offset == 0xFFFFFFFF || offset + size > m_nSize)
+    return E_FAIL; //zip64 or corrupt
+
+  const BYTE* p = m_pData + offset; //current record
+  const BYTE* pEnd = p + size; //end of central directory
+  bool bRoot = true; //whether all entries so far share a top-level folder
+
+  for(UINT i=0; i<n; i++){
+    if(pEnd - p < 46 || Read32(p) != ZIP_CENTRAL)return E_FAIL;
+
+    const UINT len = Read16(p + 28); //file name length
+    const size_t skip = 46 + len + Read16(p + 30) + Read16(p + 32); //record
+    if(size_t(pEnd - p) < skip)return E_FAIL;
+
+    SZipEntry e;
+    e.m_nMethod = Read16(p + 10);
+    e.m_nCrc = Read32(p + 16);
+    e.m_nCompressed = Read32(p + 20);
+    e.m_nSize = Read32(p + 24);
+    e.m_nOffset = Read32(p + 42);
+
+    if(e.m_nCompressed == 0xFFFFFFFF || e.m_nSize == 0xFFFFFFFF ||
+      e.m_nOffset == 0xFFFFFFFF)return E_FAIL; //zip64
+
+    const std::string name = Normalize(std::string((const char*)p + 46, len));
+    const bool encrypted = (Read16(p + 8) & 1) != 0;
+    const bool supported = e.m_nMethod == 0 || e.m_nMethod == 8;
+
+    if(!name.empty() && name.back() != '/' && !encrypted && supported){
+      const size_t slash = name.find('/'); //end of top-level folder
+
+      if(slash == std::string::npos)bRoot = false;
+      else if(m_strRoot.empty())m_strRoot = name.substr(0, slash + 1);
+      else if(name.compare(0, slash + 1, m_strRoot) != 0)bRoot = false;
+
+      m_mapEntry[name] = e;
+    } //if
+
+    p += skip;
+  } //for
+
+  if(!bRoot)m_strRoot.clear();
+  return S_OK;
+} //ReadDirectory
+
+#pragma endregion Open and close
+
+///////////////////////////////////////////////////////////////////////////////
+// Extraction
+
+#pragma region Extraction
+
+/// Find an entry by name, first as given and then relative to the top-level
+/// folder shared by all entries, if there is one. Names are not case
+/// sensitive and either slash may separate folders.
+/// \param name File name.
+/// \return Pointer to the entry, or nullptr if there is none.
+
+const SZipEntry* CZipArchive::Find(const std::string& name) const{
+  const std::string key = Normalize(name); //map key
+  auto it = m_mapEntry.find(key);
+
+  if(it == m_mapEntry.end() && !m_strRoot.empty())
+    it = m_mapEntry.find(m_strRoot + key);
+
+  return it == m_mapEntry.end()? nullptr: &it->second;
+} //Find
+
+/// Determine whether the archive has an entry that can be extracted.
+/// \param name File name.
+/// \return true if there is such an entry.
+
+bool CZipArchive::Contains(const std::string& name) const{
+  return Find(name) != nullptr;
+} //Contains
+
+/// Extract an entry into memory. The local file header is checked, the data
+/// inflated or copied straight out of the mapped file, and the CRC-32 of the
+/// result checked against the central directory. This reads the archive but
+/// does not change it, so entries can be extracted by several threads at
+/// once.
+/// \param name File name.
+/// \param v [OUT] Uncompressed contents.
+/// \return S_OK for success, E_FAIL if there is no such entry or it is
+/// corrupt.
+
+HRESULT CZipArchive::Extract(const std::string& name,
+  std::vector<BYTE>& v) const
+{
+  const SZipEntry* e = Find(name);
+  if(e == nullptr || e->m_nOffset + 30 > m_nSize)return E_FAIL;
+
+  const BYTE* p = m_pData + e->m_nOffset; //local file header
+  if(Read32(p) != ZIP_LOCAL)return E_FAIL;
+
+  const UINT64 start = e->m_nOffset + 30 + Read16(p + 26) + Read16(p + 28);
+  if(start + e->m_nCompressed > m_nSize)return E_FAIL;
+
+  const BYTE* src = m_pData + start; //compressed data
+  const size_t n = size_t(e->m_nCompressed);
+
+  v.resize(size_t(e->m_nSize));
+
+  if(e->m_nMethod == 0){ //stored
+    if(n != v.size())return E_FAIL;
+    if(n > 0)memcpy(v.data(), src, n);
+  } //if
+
+  else if(FAILED(Inflate(src, n, v.data(), v.size())))
+    return E_FAIL;
+
+  return Crc32(v.data(), v.size()) == e->m_nCrc? S_OK: E_FAIL;
+} //Extract
+
+/// Get the number of entries that can be extracted.
+/// \return Number of entries.
+
+const size_t CZipArchive::GetSize() const{
+  return m_mapEntry.size();
+} //GetSize
+
+#pragma endregion Extraction
@@ -0,0 +1,81 @@
+/// \file ZipArchive.h
+/// \brief Interface for CZipArchive.
+
+// MIT License
+//
+// Copyright (c) 2020 Ian Parberry
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef __ZIPARCHIVE_H__
+#define __ZIPARCHIVE_H__
+
+#include "Windows.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// \brief Zip archive entry.
+///
+/// Where to find one file in a zip archive, from its central directory
+/// record.
+
+struct SZipEntry{
+  UINT64 m_nOffset = 0; ///< Offset of local file header.
+  UINT64 m_nCompressed = 0; ///< Compressed size in bytes.
+  UINT64 m_nSize = 0; ///< Uncompressed size in bytes.
+  UINT m_nCrc = 0; ///< CRC-32 of uncompressed data.
+  WORD m_nMethod = 0; ///< Compression method, 0 stored or 8 deflated.
+}; //SZipEntry
+
+/// \brief Read-only zip archive.
+///
+/// The archive file is memory-mapped and its entries found through the
+/// central directory at the end of the file, so opening an archive reads
+/// only the directory and extracting an entry touches only its own pages.
+/// Extraction is const and thread-safe, so entries can be inflated in
+/// parallel straight into memory without ever being written to disk.
+
+class CZipArchive{
+  private:
+    HANDLE m_hFile = INVALID_HANDLE_VALUE; ///< File handle.
+    HANDLE m_hMapping = nullptr; ///< File mapping handle.
+    const BYTE* m_pData = nullptr; ///< Mapped file contents.
+    UINT64 m_nSize = 0; ///< File size in bytes.
+
+    std::unordered_map<std::string, SZipEntry> m_mapEntry; ///< Entries.
+    std::string m_strRoot; ///< Top-level folder shared by all entries.
+
+    HRESULT ReadDirectory(); ///< Read central directory.
+    const SZipEntry* Find(const std::string& name) const; ///< Find entry.
+
+  public:
+    ~CZipArchive(); ///< Destructor.
+
+    HRESULT Open(const std::wstring& filename); ///< Open archive.
+    void Close(); ///< Close archive.
+
+    bool Contains(const std::string& name) const; ///< Is there an entry?
+    HRESULT Extract(const std::string& name,
+      std::vector<BYTE>& v) const; ///< Extract entry to memory.
+
+    const size_t GetSize() const; ///< Get number of entries.
+}; //CZipArchive
+
+#endif //__ZIPARCHIVE_H__